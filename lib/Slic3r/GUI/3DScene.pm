@@ -1069,10 +1069,17 @@ sub draw_volumes {
             glColor4f(@{ $volume->color });
         }
         
+        # when a toolpath segment is smaller than a pixel, draw the
+        # simplified geometry
+        my ($qverts, $tverts, $offsets) = ($volume->qverts, $volume->tverts, $volume->offsets);
+        if ($volume->lod && $self->_zoom * $volume->lod->{tolerance} <= 1) {
+            ($qverts, $tverts, $offsets) = @{$volume->lod}{qw(qverts tverts offsets)};
+        }
+        
         my @sorted_z = ();
         my ($min_z, $max_z);
-        if ($volume->range && $volume->offsets) {
-            @sorted_z = sort { $a <=> $b } keys %{$volume->offsets};
+        if ($volume->range && $offsets) {
+            @sorted_z = sort { $a <=> $b } keys %$offsets;
             
             ($min_z, $max_z) = @{$volume->range};
             $min_z = first { $_ >= $min_z } @sorted_z;
@@ -1080,35 +1087,35 @@ sub draw_volumes {
         }
         
         glCullFace(GL_BACK);
-        if ($volume->qverts) {
+        if ($qverts) {
             my ($min_offset, $max_offset);
             if (defined $min_z) {
-                $min_offset = $volume->offsets->{$min_z}->[0];
+                $min_offset = $offsets->{$min_z}->[0];
             }
             if (defined $max_z) {
-                $max_offset = $volume->offsets->{$max_z}->[0];
+                $max_offset = $offsets->{$max_z}->[0];
             }
             $min_offset //= 0;
-            $max_offset //= $volume->qverts->size;
+            $max_offset //= $qverts->size;
             
-            glVertexPointer_c(3, GL_FLOAT, 0, $volume->qverts->verts_ptr);
-            glNormalPointer_c(GL_FLOAT, 0, $volume->qverts->norms_ptr);
+            glVertexPointer_c(3, GL_FLOAT, $qverts->stride, $qverts->verts_ptr);
+            glNormalPointer_c(GL_FLOAT, $qverts->stride, $qverts->norms_ptr);
             glDrawArrays(GL_QUADS, $min_offset / 3, ($max_offset-$min_offset) / 3);
         }
         
-        if ($volume->tverts) {
+        if ($tverts) {
             my ($min_offset, $max_offset);
             if (defined $min_z) {
-                $min_offset = $volume->offsets->{$min_z}->[1];
+                $min_offset = $offsets->{$min_z}->[1];
             }
             if (defined $max_z) {
-                $max_offset = $volume->offsets->{$max_z}->[1];
+                $max_offset = $offsets->{$max_z}->[1];
             }
             $min_offset //= 0;
-            $max_offset //= $volume->tverts->size;
+            $max_offset //= $tverts->size;
             
-            glVertexPointer_c(3, GL_FLOAT, 0, $volume->tverts->verts_ptr);
-            glNormalPointer_c(GL_FLOAT, 0, $volume->tverts->norms_ptr);
+            glVertexPointer_c(3, GL_FLOAT, $tverts->stride, $tverts->verts_ptr);
+            glNormalPointer_c(GL_FLOAT, $tverts->stride, $tverts->norms_ptr);
             glDrawArrays(GL_TRIANGLES, $min_offset / 3, ($max_offset-$min_offset) / 3);
         }
         
@@ -1161,6 +1168,7 @@ has 'qverts'            => (is => 'rw');  # GLVertexArray object
 has 'tverts'            => (is => 'rw');  # GLVertexArray object
 has 'mesh'              => (is => 'rw');  # only required for cut contours
 has 'offsets'           => (is => 'rw');  # [ z => [ qverts_idx, tverts_idx ] ]
+has 'lod'               => (is => 'rw');  # { qverts, tverts, offsets, tolerance } for far zoom
 
 sub transformed_bounding_box {
     my ($self) = @_;
@@ -1187,6 +1195,7 @@ __PACKAGE__->mk_accessors(qw(
     drag_by
     volumes_by_object
     _objects_by_volumes
+    _toolpaths_previews
 ));
 
 sub default_colors { [@COLOR_PARTS], [@COLOR_INFILL], [@COLOR_SUPPORT], [@COLOR_UNKNOWN] }
@@ -1210,6 +1219,7 @@ sub new {
     $self->drag_by('instance');     # object | instance
     $self->volumes_by_object({});   # obj_idx => [ volume_idx, volume_idx ... ]
     $self->_objects_by_volumes({}); # volume_idx => [ obj_idx, instance_idx ]
+    $self->_toolpaths_previews({}); # PrintObject address => ToolpathsPreview
     
     return $self;
 }
@@ -1407,10 +1417,6 @@ sub load_print_toolpaths {
 sub load_print_object_toolpaths {
     my ($self, $object) = @_;
     
-    # order layers by print_z
-    my @layers = sort { $a->print_z <=> $b->print_z }
-        @{$object->layers}, @{$object->support_layers};
-    
     # Bounding box of the object and its copies.
     my $bb = Slic3r::Geometry::BoundingBoxf3->new;
     {
@@ -1423,93 +1429,49 @@ sub load_print_object_toolpaths {
         }
     }
     
-    my %volumes = ();  # color => Volume
-    
-    # Maximum size of an allocation block: 32MB / sizeof(float)
-    my $alloc_size_max = 32 * 1048576 / 4;
-    
-    my $add = sub {
-        my ($coll, $top_z, $copy, $color) = @_;
-        
-        my $volume = $volumes{$color};
-        if (!$volume) {
-            push @{$self->volumes}, $volumes{$color} = $volume = Slic3r::GUI::3DScene::Volume->new(
-                bounding_box    => $bb,
-                color           => $color,
-                qverts          => Slic3r::GUI::_3DScene::GLVertexArray->new,
-                tverts          => Slic3r::GUI::_3DScene::GLVertexArray->new,
-                offsets         => {},  # print_z => [ qverts, tverts ]
-            );
+    # The vertex arrays are built by parallel threads and kept from a load to
+    # the next one, which only converts the layers whose toolpaths changed.
+    my $preview = $self->_toolpaths_previews->{$$object}
+        //= Slic3r::GUI::_3DScene::ToolpathsPreview->new;
+    $preview->load_object($object, $self->color_toolpaths_by eq 'extruder', scalar @{$self->colors});
+    
+    my $zs = $preview->zs;
+    foreach my $group_idx (0..($preview->groups_count-1)) {
+        # level of detail => { qverts, tverts, offsets }
+        my @lods = ();
+        foreach my $lod (0, 1) {
+            my $qoffsets = $preview->qoffsets($group_idx, $lod);
+            my $toffsets = $preview->toffsets($group_idx, $lod);
+            my %offsets = ();  # print_z => [ qverts, tverts ]
+            $offsets{$zs->[$_]} //= [ $qoffsets->[$_], $toffsets->[$_] ] for 0..$#$zs;
+            push @lods, {
+                qverts  => $preview->qverts($group_idx, $lod),
+                # the simplified geometry has no joints
+                tverts  => ($lod == 0) ? $preview->tverts($group_idx, $lod) : undef,
+                offsets => \%offsets,
+            };
         }
         
-        $volume->offsets->{$top_z} //= [ $volume->qverts->size, $volume->tverts->size ];
-        $self->_extrusionentity_to_verts($coll, $top_z, $copy, $volume->qverts, $volume->tverts);
-    };
-    
-    my $color_by_extruder = $self->color_toolpaths_by eq 'extruder';
-    
-    foreach my $layer (@layers) {
-        my $top_z = $layer->print_z;
-        foreach my $copy (@{ $object->_shifted_copies }) {
-            foreach my $layerm (@{$layer->regions}) {
-                if ($object->step_done(STEP_PERIMETERS)) {
-                    my $color = $color_by_extruder
-                        ? $self->colors->[ ($layerm->region->config->perimeter_extruder-1) % @{$self->colors} ]
-                        : $self->colors->[0];
-                    $add->($layerm->perimeters, $top_z, $copy, $color);
-                }
-                
-                if ($object->step_done(STEP_INFILL)) {
-                    my $color = $color_by_extruder
-                        ? $self->colors->[ ($layerm->region->config->infill_extruder-1) % @{$self->colors} ]
-                        : $self->colors->[1];
-                    
-                    if ($color_by_extruder && $layerm->region->config->infill_extruder != $layerm->region->config->solid_infill_extruder) {
-                        # divide solid and non-solid infill
-                        my $solid = Slic3r::ExtrusionPath::Collection->new;
-                        my $non_solid = Slic3r::ExtrusionPath::Collection->new;
-                        foreach my $fill (@{$layerm->fills}) {
-                            if ($fill->[0]->is_solid_infill) {
-                                $solid->append($fill);
-                            } else {
-                                $non_solid->append($fill);
-                            }
-                        }
-                        $add->($non_solid, $top_z, $copy, $color);
-                        $color = $self->colors->[ ($layerm->region->config->solid_infill_extruder-1) % @{$self->colors} ];
-                        $add->($solid, $top_z, $copy, $color);
-                    } else {
-                        $add->($layerm->fills, $top_z, $copy, $color);
-                    }
-                }
-            }
-            
-            if ($layer->isa('Slic3r::Layer::Support') && $object->step_done(STEP_SUPPORTMATERIAL)) {
-                {
-                    my $color = $color_by_extruder
-                        ? $self->colors->[ ($layer->object->config->support_material_extruder-1) % @{$self->colors} ]
-                        : $self->colors->[2];
-                    $add->($layer->support_fills, $top_z, $copy, $color);
-                }
-                {
-                    my $color = ($color_by_extruder)
-                        ? $self->colors->[ ($layer->object->config->support_material_interface_extruder-1) % @{$self->colors} ]
-                        : $self->colors->[2];
-                    $add->($layer->support_interface_fills, $top_z, $copy, $color);
-                }
-            }
-        }
-        
-        foreach my $color (keys %volumes) {
-            my $volume = $volumes{$color};
-            if ($volume->qverts->size() > $alloc_size_max || $volume->tverts->size() > $alloc_size_max) {
-                # stop appending to this volume; create a new one next time
-                delete $volumes{$color};
-            }
-        }
+        push @{$self->volumes}, Slic3r::GUI::3DScene::Volume->new(
+            bounding_box    => $bb,
+            color           => $self->colors->[ $preview->group_color($group_idx) ],
+            qverts          => $lods[0]{qverts},
+            tverts          => $lods[0]{tverts},
+            offsets         => $lods[0]{offsets},
+            lod             => { %{$lods[1]}, tolerance => $preview->lod_tolerance },
+        );
     }
 }
 
+# Releases the toolpaths kept for the objects not listed.
+sub retain_toolpaths_previews {
+    my ($self, @objects) = @_;
+    
+    my %keep = map { $$_ => 1 } @objects;
+    delete $self->_toolpaths_previews->{$_}
+        for grep !$keep{$_}, keys %{$self->_toolpaths_previews};
+}
+
 sub set_toolpaths_range {
     my ($self, $min_z, $max_z) = @_;
     
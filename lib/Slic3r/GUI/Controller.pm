@@ -14,7 +14,7 @@ use base qw(Wx::ScrolledWindow Class::Accessor);
 
 __PACKAGE__->mk_accessors(qw(_selected_printer_preset));
 
-our @ConfigOptions = qw(bed_shape serial_port serial_speed);
+our @ConfigOptions = qw(bed_shape serial_port serial_speed serial_rx_buffer);
 
 sub new {
     my ($class, $parent) = @_;
@@ -326,6 +326,7 @@ sub connect {
     my $res = $self->sender->connect(
         $self->{serial_port_combobox}->GetValue,
         $self->{serial_speed_combobox}->GetValue,
+        $self->config->serial_rx_buffer,
     );
     if (!$res) {
         $self->set_status("Connection failed. Check serial port and speed.");
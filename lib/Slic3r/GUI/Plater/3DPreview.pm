@@ -140,6 +140,7 @@ sub load_print {
         }else{ # load all objects
 	        # load skirt and brim
             $self->canvas->load_print_toolpaths($self->print);
+            $self->canvas->retain_toolpaths_previews(@{$self->print->objects});
             
             foreach my $object (@{$self->print->objects}) {
                 $self->canvas->load_print_object_toolpaths($object);
@@ -1244,7 +1244,7 @@ sub options {
     return qw(
         bed_shape z_offset z_steps_per_mm has_heatbed
         gcode_flavor use_relative_e_distances
-        serial_port serial_speed
+        serial_port serial_speed serial_rx_buffer
         host_type print_host octoprint_apikey
         use_firmware_retraction pressure_advance vibration_limit
         use_volumetric_e
@@ -1342,6 +1342,7 @@ sub build {
                 my $res = $sender->connect(
                     $self->config->serial_port,
                     $self->config->serial_speed,
+                    $self->config->serial_rx_buffer,
                 );
                 if ($res && $sender->wait_connected) {
                     Slic3r::GUI::show_info($self, "Connection to printer works correctly.", "Success!");
@@ -1350,6 +1351,7 @@ sub build {
                 }
             }, \$self->{serial_test_btn});
             $optgroup->append_line($line);
+            $optgroup->append_single_option_line('serial_rx_buffer');
         }
         {
             my $optgroup = $page->new_optgroup('Print server upload');
@@ -1593,6 +1595,7 @@ sub _update {
     my $serial_speed = $self->get_field('serial_speed');
     if ($serial_speed) {
         $self->get_field('serial_speed')->toggle($config->get('serial_port'));
+        $self->get_field('serial_rx_buffer')->toggle($config->get('serial_port'));
         if ($config->get('serial_speed') && $config->get('serial_port')) {
             $self->{serial_test_btn}->Enable;
         } else {
@@ -81,6 +81,11 @@ sub new {
             $optgroup->append_line($line);
         }
     }
+    {
+        my $optgroup = $new_optgroup->('Raster');
+        $optgroup->append_single_option_line('sla_raster_dpi');
+        $optgroup->append_single_option_line('sla_raster_antialiasing');
+    }
     
     
     my $buttons = $self->CreateStdDialogButtonSizer(wxOK | wxCANCEL);
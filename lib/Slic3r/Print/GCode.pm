@@ -15,6 +15,7 @@ has '_brim_done'                     => (is => 'rw');
 has '_second_layer_things_done'      => (is => 'rw');
 has '_last_obj_copy'                 => (is => 'rw');
 has '_autospeed'                     => (is => 'rw', default => sub { 0 });   # boolean
+has '_layer_bodies'                  => (is => 'rw');
 
 use List::Util qw(first sum min max);
 use Slic3r::ExtrusionPath ':roles';
@@ -223,12 +224,27 @@ sub export {
     # set initial extruder only after custom start G-code
     print $fh $gcodegen->set_extruder($self->print->extruders->[0]);
     
+    # generate the extrusions of the layers in parallel threads; process_layer()
+    # stitches them in the order they are queued below
+    $self->_layer_bodies(Slic3r::GCode::LayerBodies->new($gcodegen, $self->print, $self->config->threads))
+        if $self->config->parallel_gcode;
+    
     # do all objects for each layer
     if ($self->config->complete_objects) {
         # print objects from the smallest to the tallest to avoid collisions
         # when moving onto next object starting point
         my @obj_idx = sort { $self->objects->[$a]->config->sequential_print_priority <=> $self->objects->[$b]->config->sequential_print_priority or $self->objects->[$a]->size->z <=> $self->objects->[$b]->size->z} 0..($self->print->object_count - 1);
         
+        if (defined $self->_layer_bodies) {
+            for my $obj_idx (@obj_idx) {
+                my $object = $self->objects->[$obj_idx];
+                for my $copy (@{ $object->_shifted_copies }) {
+                    $self->_layer_bodies->add($_->as_layer, $copy)
+                        for sort { $a->print_z <=> $b->print_z } @{$object->layers}, @{$object->support_layers};
+                }
+            }
+        }
+        
         my $finished_objects = 0;
         for my $obj_idx (@obj_idx) {
             my $object = $self->objects->[$obj_idx];
@@ -288,6 +304,17 @@ sub export {
             }
         }
         
+        if (defined $self->_layer_bodies) {
+            foreach my $print_z (sort { $a <=> $b } keys %layers) {
+                foreach my $obj_idx (@obj_idx) {
+                    foreach my $layer (@{ $layers{$print_z}[$obj_idx] // [] }) {
+                        $self->_layer_bodies->add($layer->as_layer, $_)
+                            for @{$layer->object->_shifted_copies};
+                    }
+                }
+            }
+        }
+        
         foreach my $print_z (sort { $a <=> $b } keys %layers) {
             foreach my $obj_idx (@obj_idx) {
                 foreach my $layer (@{ $layers{$print_z}[$obj_idx] // [] }) {
@@ -297,6 +324,7 @@ sub export {
         }
         $self->flush_filters;
     }
+    $self->_layer_bodies(undef);
     
     # write end commands to file
     print $fh $gcodegen->retract;   # TODO: process this retract through PressureRegulator in order to discharge fully
@@ -405,54 +433,7 @@ sub process_layer {
     $self->_gcodegen->set_enable_loop_clipping(!defined $self->_spiral_vase || !$self->_spiral_vase->enable);
     
     # initialize autospeed
-    {
-        # get the minimum cross-section used in the layer
-        my @mm3_per_mm = ();
-        foreach my $region_id (0..$#{$self->print->regions}) {
-            my $region = $self->print->get_region($region_id);
-            my $layerm = $layer->region($region_id);
-            if ($region->config->get_abs_value('perimeter_speed') == 0
-                || $region->config->get_abs_value('small_perimeter_speed') == 0
-                || $region->config->get_abs_value('external_perimeter_speed') == 0
-                || $region->config->get_abs_value('bridge_speed') == 0) {
-                push @mm3_per_mm, $layerm->perimeters->min_mm3_per_mm;
-            }
-            if ($region->config->get_abs_value('infill_speed') == 0
-                || $region->config->get_abs_value('solid_infill_speed') == 0
-                || $region->config->get_abs_value('top_solid_infill_speed') == 0
-                || $region->config->get_abs_value('bridge_speed') == 0
-                || $region->config->get_abs_value('gap_fill_speed') == 0) {
-                push @mm3_per_mm, $layerm->fills->min_mm3_per_mm;
-            }
-        }
-        if ($layer->isa('Slic3r::Layer::Support')) {
-            if ($object->config->get_abs_value('support_material_speed') == 0
-                || $object->config->get_abs_value('support_material_interface_speed') == 0) {
-                push @mm3_per_mm, $layer->support_fills->min_mm3_per_mm;
-                push @mm3_per_mm, $layer->support_interface_fills->min_mm3_per_mm;
-            }
-        }
-        # ignore too thin segments
-        @mm3_per_mm = grep $_ > 0.01, @mm3_per_mm;
-        if (@mm3_per_mm) {
-            my $min_mm3_per_mm = min(@mm3_per_mm);
-            # In order to honor max_print_speed we need to find a target volumetric
-            # speed that we can use throughout the print. So we define this target 
-            # volumetric speed as the volumetric speed produced by printing the 
-            # smallest cross-section at the maximum speed: any larger cross-section
-            # will need slower feedrates.
-            my $volumetric_speed = $min_mm3_per_mm * $self->config->max_print_speed;
-            
-            # limit such volumetric speed with max_volumetric_speed if set
-            if ($self->config->max_volumetric_speed > 0) {
-                $volumetric_speed = min(
-                    $volumetric_speed,
-                    $self->config->max_volumetric_speed,
-                );
-            }
-            $self->_gcodegen->set_volumetric_speed($volumetric_speed);
-        }
-    }
+    Slic3r::GCode::LayerBodies::autospeed($self->_gcodegen, $self->print, $layer->as_layer);
     
     if (!$self->_second_layer_things_done && $layer->id == 1) {
         for my $extruder (@{$self->_gcodegen->writer->extruders}) {
@@ -551,125 +532,11 @@ sub process_layer {
         
         $self->_gcodegen->set_origin(Slic3r::Pointf->new(map unscale $copy->[$_], X,Y));
         
-        # extrude support material before other things because it might use a lower Z
-        # and also because we avoid travelling on other things when printing it
-        if ($layer->isa('Slic3r::Layer::Support')) {
-            if ($layer->support_interface_fills->count > 0) {
-                $gcode .= $self->_gcodegen->set_extruder($object->config->support_material_interface_extruder-1);
-                $gcode .= $self->_gcodegen->extrude_path($_, 'support material interface', $object->config->get_abs_value('support_material_interface_speed')) 
-                    for @{$layer->support_interface_fills->chained_path_from($self->_gcodegen->last_pos, 0)}; 
-            }
-            if ($layer->support_fills->count > 0) {
-                $gcode .= $self->_gcodegen->set_extruder($object->config->support_material_extruder-1);
-                $gcode .= $self->_gcodegen->extrude_path($_, 'support material', $object->config->get_abs_value('support_material_speed')) 
-                    for @{$layer->support_fills->chained_path_from($self->_gcodegen->last_pos, 0)};
-            }
-        }
-        
-        # We now define a strategy for building perimeters and fills. The separation 
-        # between regions doesn't matter in terms of printing order, as we follow 
-        # another logic instead:
-        # - we group all extrusions by extruder so that we minimize toolchanges
-        # - we start from the last used extruder
-        # - for each extruder, we group extrusions by island
-        # - for each island, we extrude perimeters first, unless user set the infill_first
-        #   option
-        # (Still, we have to keep track of regions because we need to apply their config)
-        
-        # group extrusions by extruder and then by island
-        my %by_extruder = ();  # extruder_id => [ { perimeters => \@perimeters, infill => \@infill } ]
-        
-        # cache bounding boxes of layer slices
-        my @layer_slices_bb = map $_->contour->bounding_box, @{$layer->slices};
-        my $point_inside_surface = sub { 
-            my ($i, $point) = @_;
-            
-            my $bbox = $layer_slices_bb[$i];
-            return $layer_slices_bb[$i]->contains_point($point)
-                && $layer->slices->[$i]->contour->contains_point($point);
-        };
-        
-        my $n_slices = $layer->slices->count - 1;
-        foreach my $region_id (0..($self->print->region_count-1)) {
-            my $layerm = $layer->regions->[$region_id] or next;
-            my $region = $self->print->get_region($region_id);
-            
-            # process perimeters
-            {
-                my $extruder_id = $region->config->perimeter_extruder-1;
-                foreach my $perimeter_coll (@{$layerm->perimeters}) {
-                    next if $perimeter_coll->empty;  # this shouldn't happen but first_point() would fail
-                    
-                    # init by_extruder item only if we actually use the extruder
-                    $by_extruder{$extruder_id} //= [];
-                    
-                    # $perimeter_coll is an ExtrusionPath::Collection object representing a single slice
-                    for my $i (0 .. $n_slices) {
-                        if (
-                            # $perimeter_coll->first_point does not fit inside any slice
-                            $i == $n_slices 
-                            # $perimeter_coll->first_point fits inside ith slice
-                            || $point_inside_surface->($i, $perimeter_coll->first_point)) {
-                            $by_extruder{$extruder_id}[$i] //= { perimeters => {} };
-                            $by_extruder{$extruder_id}[$i]{perimeters}{$region_id} //= [];
-                            push @{ $by_extruder{$extruder_id}[$i]{perimeters}{$region_id} }, @$perimeter_coll;
-                            last;
-                        }
-                    }
-                }
-            }
-            
-            # process infill
-            # $layerm->fills is a collection of ExtrusionPath::Collection objects, each one containing
-            # the ExtrusionPath objects of a certain infill "group" (also called "surface"
-            # throughout the code). We can redefine the order of such Collections but we have to 
-            # do each one completely at once.
-            foreach my $fill (@{$layerm->fills}) {
-                next if $fill->empty;  # this shouldn't happen but first_point() would fail
-                
-                # init by_extruder item only if we actually use the extruder
-                my $extruder_id = $fill->[0]->is_solid_infill
-                    ? $region->config->solid_infill_extruder-1
-                    : $region->config->infill_extruder-1;
-                
-                $by_extruder{$extruder_id} //= [];
-                
-                # $fill is an ExtrusionPath::Collection object
-                for my $i (0 .. $n_slices) {
-                    if ($i == $n_slices
-                        || $point_inside_surface->($i, $fill->first_point)) {
-                        $by_extruder{$extruder_id}[$i] //= { infill => {} };
-                        $by_extruder{$extruder_id}[$i]{infill}{$region_id} //= [];
-                        push @{ $by_extruder{$extruder_id}[$i]{infill}{$region_id} }, $fill;
-                        last;
-                    }
-                }
-            }
-        }
-        
-        # tweak extruder ordering to save toolchanges
-        my @extruders = sort { $a <=> $b } keys %by_extruder;
-        if (@extruders > 1) {
-            my $last_extruder_id = $self->_gcodegen->writer->extruder->id;
-            if (exists $by_extruder{$last_extruder_id}) {
-                @extruders = (
-                    $last_extruder_id,
-                    grep $_ != $last_extruder_id, @extruders,
-                );
-            }
-        }
-        
-        foreach my $extruder_id (@extruders) {
-            $gcode .= $self->_gcodegen->set_extruder($extruder_id);
-            foreach my $island (@{ $by_extruder{$extruder_id} }) {
-                if ($self->print->config->infill_first) {
-                    $gcode .= $self->_extrude_infill($island->{infill} // {});
-                    $gcode .= $self->_extrude_perimeters($island->{perimeters} // {});
-                } else {
-                    $gcode .= $self->_extrude_perimeters($island->{perimeters} // {});
-                    $gcode .= $self->_extrude_infill($island->{infill} // {});
-                }
-            }
+        # the extrusions of this copy may have been generated in parallel
+        if (defined $self->_layer_bodies) {
+            $gcode .= $self->_layer_bodies->stitch($layer->as_layer, $copy);
+        } else {
+            $gcode .= Slic3r::GCode::LayerBodies::extrude($self->_gcodegen, $self->print, $layer->as_layer);
         }
     }
     
@@ -691,40 +558,6 @@ sub process_layer {
     print {$self->fh} $self->filter($gcode);
 }
 
-# Extrude perimeters: Decide where to put seams (hide or align seams).
-sub _extrude_perimeters {
-    my ($self, $entities_by_region) = @_;
-    
-    my $gcode = "";
-    foreach my $region_id (sort keys %$entities_by_region) {
-        $self->_gcodegen->config->apply_static($self->print->get_region($region_id)->config);
-        $gcode .= $self->_gcodegen->extrude($_, 'perimeter', -1)
-            for @{ $entities_by_region->{$region_id} };
-    }
-    return $gcode;
-}
-
-# Chain the paths hierarchically by a greedy algorithm to minimize a travel distance.
-sub _extrude_infill {
-    my ($self, $entities_by_region) = @_;
-    
-    my $gcode = "";
-    foreach my $region_id (sort keys %$entities_by_region) {
-        $self->_gcodegen->config->apply_static($self->print->get_region($region_id)->config);
-        
-        my $collection = Slic3r::ExtrusionPath::Collection->new(@{ $entities_by_region->{$region_id} });
-        for my $fill (@{$collection->chained_path_from($self->_gcodegen->last_pos, 0)}) {
-            if ($fill->isa('Slic3r::ExtrusionPath::Collection')) {
-                $gcode .= $self->_gcodegen->extrude($_, 'infill', -1) 
-                    for @{$fill->chained_path_from($self->_gcodegen->last_pos, 0)};
-            } else {
-                $gcode .= $self->_gcodegen->extrude($fill, 'infill', -1) ;
-            }
-        }
-    }
-    return $gcode;
-}
-
 sub flush_filters {
     my ($self) = @_;
     
@@ -151,13 +151,17 @@ sub detect_nonplanar_surfaces {
     # Temporary workaround for detect_surfaces_type() not being idempotent (see #3764).
     # We can remove this when idempotence is restored. This make_perimeters() method
     # will just call merge_slices() to undo the typed slices and invalidate posDetectSurfaces.
-    if ($self->typed_slices) {
+    # When the planar slices were saved by a previous run we restore them instead.
+    if ($self->typed_slices && !$self->restore_planar_slices) {
         $self->invalidate_step(STEP_SLICE);
     }
 
     # prerequisites
     $self->slice;
 
+    # Find the nonplanar surfaces on the meshes; this is kept across reslices.
+    $self->find_nonplanar_surfaces;
+
     # Detect nonplanar surfaces areas and move them to the heighest layer of the nonplanar_surface
     $self->print->status_cb->(25, "Move nonplanar surfaces up");
     $self->move_nonplanar_surfaces_up;
@@ -16,7 +16,7 @@ has '_print' => (
     default => sub { Slic3r::Print->new },
     handles => [qw(apply_config config extruders output_filepath
                     total_used_filament total_extruded_volume
-                    placeholder_parser process)],
+                    placeholder_parser process profile_json)],
 );
 
 has 'duplicate' => (
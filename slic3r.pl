@@ -39,6 +39,7 @@ my %cli_options = ();
         'ignore-nonexistent-config' => \$opt{ignore_nonexistent_config},
         'datadir=s'             => \$opt{datadir},
         'export-svg'            => \$opt{export_svg},
+        'profile=s'             => \$opt{profile},
         'merge|m'               => \$opt{merge},
         'repair'                => \$opt{repair},
         'cut=f'                 => \$opt{cut},
@@ -288,6 +289,15 @@ if (@ARGV) {  # slicing from command line
             printf "Filament required: %.1fmm (%.1fcm3)\n",
                 $sprint->total_used_filament, $sprint->total_extruded_volume/1000;
         }
+        
+        if (defined $opt{profile}) {
+            my $profile_file = Slic3r::decode_path($opt{profile});
+            Slic3r::open(\my $fh, '>', $profile_file)
+                or die "Failed to open $profile_file for writing\n";
+            print $fh $sprint->profile_json;
+            close $fh;
+            printf "Profile written to %s\n", basename($profile_file);
+        }
     }
 } else {
     usage(1) unless $opt{save};
@@ -349,6 +359,9 @@ $j
     --post-process      Generated G-code will be processed with the supplied script;
                         call this more than once to process through multiple scripts.
     --export-svg        Export a SVG file containing slices instead of G-code.
+    --profile <file>    Write the time, CPU time, peak memory growth and item counts of each
+                        processing step and of each layer within a step to the specified
+                        file as JSON.
     -m, --merge         If multiple files are supplied, they will be composed into a single 
                         print rather than processed individually.
   
@@ -368,6 +381,7 @@ $j
     --gcode-arcs        Use G2/G3 commands for native arcs (experimental, not supported
                         by all firmwares)
     --gcode-comments    Make G-code verbose by adding comments (default: no)
+    --parallel-gcode    Generate the G-code of the layers in parallel threads (default: no)
     --vibration-limit   Limit the frequency of moves on X and Y axes (Hz, set zero to disable;
                         default: $config->{vibration_limit})
     --pressure-advance  Adjust pressure using the experimental advance algorithm (K constant,
@@ -5,6 +5,7 @@
 #include "SLAPrint.hpp"
 #include "TriangleMesh.hpp"
 #include "libslic3r.h"
+#include <chrono>
 #include <cstdio>
 #include <string>
 #include <cstring>
@@ -134,6 +135,23 @@ main(int argc, char **argv)
             print.slice();
             print.write_svg(outfile);
             boost::nowide::cout << "SVG file exported to " << outfile << std::endl;
+        } else if (cli_config.export_png) {
+            std::string outfile = cli_config.output.value;
+            if (outfile.empty()) outfile = model.objects.front()->input_file + ".zip";
+            
+            SLAPrint print(&model);
+            print.config.apply(print_config, true);
+            print.slice();
+            
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (!print.write_png_zip(outfile)) {
+                boost::nowide::cerr << "Unable to write " << outfile << std::endl;
+                exit(1);
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            boost::nowide::cout << "PNG archive exported to " << outfile
+                << " (" << print.layers.size() << " layers, "
+                << (seconds > 0 ? print.layers.size() / seconds : 0) << " layers/s)" << std::endl;
         } else if (cli_config.export_3mf) {
             std::string outfile = cli_config.output.value;
             if (outfile.empty()) outfile = model.objects.front()->input_file;
@@ -0,0 +1,108 @@
+#include "Config.hpp"
+#include "ClipperUtils.hpp"
+#include "Fill/Fill.hpp"
+#include "Surface.hpp"
+#include "libslic3r.h"
+#include <chrono>
+#include <memory>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/iostream.hpp>
+
+using namespace Slic3r;
+
+void confess_at(const char *file, int line, const char *func, const char *pat, ...){}
+
+// Micro-benchmark for the infill generators: fills a synthetic plate (a square
+// with a grid of round holes, so that fill lines get split and reconnected)
+// for a range of plate sizes and densities and reports the time spent per pattern.
+int
+main(int argc, char **argv)
+{
+    // Convert arguments to UTF-8 (needed on Windows).
+    // argv then points to memory owned by a.
+    boost::nowide::args a(argc, argv);
+
+    // read config
+    ConfigDef config_def;
+    {
+        ConfigOptionDef* def;
+
+        def = config_def.add("fill_pattern", coString);
+        def->label = "Fill pattern";
+        def->cli = "fill-pattern";
+        def->default_value = new ConfigOptionString("rectilinear");
+
+        def = config_def.add("layers", coInt);
+        def->label = "Layers filled per configuration";
+        def->cli = "layers";
+        def->default_value = new ConfigOptionInt(20);
+
+        def = config_def.add("extrusion_width", coFloat);
+        def->label = "Extrusion width";
+        def->cli = "extrusion-width";
+        def->default_value = new ConfigOptionFloat(0.45);
+    }
+    DynamicConfig config(&config_def);
+    t_config_option_keys input_files;
+    config.read_cli(argc, argv, &input_files);
+
+    const std::string pattern = config.option("fill_pattern", true)->getString();
+    const int layers = config.option("layers", true)->getInt();
+    const float extrusion_width = config.option("extrusion_width", true)->getFloat();
+
+    const double plate_sizes[] = { 50, 100, 200, 300 };
+    const float densities[] = { 0.1, 0.2, 0.4, 0.7, 1.0 };
+
+    boost::nowide::cout << "pattern: " << pattern << std::endl;
+    for (const double size : plate_sizes) {
+        // square plate with a 5x5 grid of holes
+        ExPolygon plate;
+        plate.contour.points.push_back(Point(0, 0));
+        plate.contour.points.push_back(Point(scale_(size), 0));
+        plate.contour.points.push_back(Point(scale_(size), scale_(size)));
+        plate.contour.points.push_back(Point(0, scale_(size)));
+        Polygons holes;
+        for (int i = 1; i <= 5; ++i) {
+            for (int j = 1; j <= 5; ++j) {
+                Polygon hole;
+                for (int k = 0; k < 32; ++k) {
+                    const double angle = -2*PI*k/32;
+                    hole.points.push_back(Point(
+                        scale_(size*i/6 + size/20*cos(angle)),
+                        scale_(size*j/6 + size/20*sin(angle))
+                    ));
+                }
+                holes.push_back(hole);
+            }
+        }
+        const ExPolygons expolygons = diff_ex(plate, holes);
+
+        for (const float density : densities) {
+            std::unique_ptr<Fill> fill(Fill::new_from_type(pattern));
+            fill->min_spacing   = extrusion_width;
+            fill->density       = density;
+
+            size_t polylines = 0;
+            double length = 0;
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int layer = 0; layer < layers; ++layer) {
+                fill->layer_id  = layer;
+                fill->z         = extrusion_width * (layer + 1);
+                fill->angle     = (layer % 2) * PI/2;
+                for (ExPolygons::const_iterator ex = expolygons.begin(); ex != expolygons.end(); ++ex) {
+                    const Polylines pp = fill->fill_surface(Surface(stInternal, *ex));
+                    polylines += pp.size();
+                    for (Polylines::const_iterator p = pp.begin(); p != pp.end(); ++p)
+                        length += unscale(p->length());
+                }
+            }
+            const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            boost::nowide::cout << "  " << size << "x" << size << " mm, density " << density << ": "
+                << time << " s (" << (time * 1000 / layers) << " ms/layer), "
+                << polylines << " polylines, " << length << " mm" << std::endl;
+        }
+    }
+
+    return 0;
+}
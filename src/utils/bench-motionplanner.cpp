@@ -0,0 +1,93 @@
+#include "Config.hpp"
+#include "ClipperUtils.hpp"
+#include "IO.hpp"
+#include "MotionPlanner.hpp"
+#include "TriangleMesh.hpp"
+#include "libslic3r.h"
+#include <chrono>
+#include <random>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/iostream.hpp>
+
+using namespace Slic3r;
+
+void confess_at(const char *file, int line, const char *func, const char *pat, ...){}
+
+// Micro-benchmark for the avoid_crossing_perimeters travel planner: slices the
+// input meshes and plans random travel moves between the islands' vertices.
+int
+main(int argc, char **argv)
+{
+    // Convert arguments to UTF-8 (needed on Windows).
+    // argv then points to memory owned by a.
+    boost::nowide::args a(argc, argv);
+    
+    // read config
+    ConfigDef config_def;
+    {
+        ConfigOptionDef* def;
+        
+        def = config_def.add("layer_height", coFloat);
+        def->label = "Layer height";
+        def->cli = "layer-height";
+        def->default_value = new ConfigOptionFloat(0.3);
+        
+        def = config_def.add("travels", coInt);
+        def->label = "Travel moves planned per layer";
+        def->cli = "travels";
+        def->default_value = new ConfigOptionInt(200);
+    }
+    DynamicConfig config(&config_def);
+    t_config_option_keys input_files;
+    config.read_cli(argc, argv, &input_files);
+    
+    const float layer_height = config.option("layer_height", true)->getFloat();
+    const int travels = config.option("travels", true)->getInt();
+    
+    for (t_config_option_keys::const_iterator it = input_files.begin(); it != input_files.end(); ++it) {
+        TriangleMesh mesh;
+        Slic3r::IO::STL::read(*it, &mesh);
+        mesh.repair();
+        mesh.translate(0, 0, -mesh.bounding_box().min.z);
+        
+        std::vector<float> slice_z;
+        for (float z = layer_height/2; z < mesh.stl.stats.max.z; z += layer_height)
+            slice_z.push_back(z);
+        std::vector<ExPolygons> layers;
+        TriangleMeshSlicer<Z>(&mesh).slice(slice_z, &layers);
+        
+        // use a fixed seed so that runs are comparable
+        std::mt19937 rng(1);
+        double build_time = 0, query_time = 0, length = 0;
+        size_t queries = 0;
+        for (std::vector<ExPolygons>::const_iterator layer = layers.begin(); layer != layers.end(); ++layer) {
+            // travel moves go from and to points on the islands' contours
+            Points endpoints;
+            for (ExPolygons::const_iterator ex = layer->begin(); ex != layer->end(); ++ex)
+                append_to(endpoints, ex->contour.points);
+            if (endpoints.size() < 2) continue;
+            std::uniform_int_distribution<size_t> pick(0, endpoints.size()-1);
+            
+            MotionPlanner mp(union_ex(*layer, true));
+            mp.build();
+            build_time += mp.build_time;
+            
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int i = 0; i < travels; ++i) {
+                const Point &from = endpoints[pick(rng)];
+                const Point &to   = endpoints[pick(rng)];
+                length += unscale(mp.shortest_path(from, to).length());
+                ++queries;
+            }
+            query_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        
+        boost::nowide::cout << *it << ": " << layers.size() << " layers" << std::endl
+            << "  build:   " << build_time << " s" << std::endl
+            << "  queries: " << queries << " in " << query_time << " s ("
+            << (query_time > 0 ? queries / query_time : 0) << " travels/s)" << std::endl
+            << "  total travel length: " << length << " mm" << std::endl;
+    }
+    
+    return 0;
+}
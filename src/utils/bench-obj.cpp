@@ -0,0 +1,133 @@
+#include "Config.hpp"
+#include "IO.hpp"
+#include "Model.hpp"
+#include "TriangleMesh.hpp"
+#include "libslic3r.h"
+#include <chrono>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/nowide/iostream.hpp>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+using namespace Slic3r;
+
+void confess_at(const char *file, int line, const char *func, const char *pat, ...){}
+
+// The OBJ import as it was done before IO::OBJ::read() parsed files in
+// parallel: tiny_obj_loader fills its own buffers, which are then copied
+// into one TriangleMesh per shape.
+static void
+read_tinyobj(const std::string &input_file, Model* model)
+{
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string err;
+    boost::nowide::ifstream ifs(input_file);
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &ifs))
+        throw std::runtime_error("Error while reading OBJ file");
+
+    ModelObject* object = model->add_object();
+    for (const tinyobj::shape_t &shape : shapes) {
+        Pointf3s points;
+        for (size_t v = 0; v < attrib.vertices.size(); v += 3)
+            points.push_back(Pointf3(attrib.vertices[v], attrib.vertices[v+1], attrib.vertices[v+2]));
+
+        std::vector<Point3> facets;
+        for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); ++f)
+            facets.push_back(Point3(
+                shape.mesh.indices[f*3+0].vertex_index,
+                shape.mesh.indices[f*3+1].vertex_index,
+                shape.mesh.indices[f*3+2].vertex_index
+            ));
+
+        TriangleMesh mesh(points, facets);
+        mesh.check_topology();
+        object->add_volume(mesh);
+    }
+}
+
+static bool
+same_facets(const Model &a, const Model &b)
+{
+    const ModelVolumePtrs &va = a.objects.front()->volumes;
+    const ModelVolumePtrs &vb = b.objects.front()->volumes;
+    if (va.size() != vb.size()) return false;
+    for (size_t i = 0; i < va.size(); ++i) {
+        const stl_file &sa = va[i]->mesh.stl;
+        const stl_file &sb = vb[i]->mesh.stl;
+        if (sa.stats.number_of_facets != sb.stats.number_of_facets) return false;
+        for (int f = 0; f < sa.stats.number_of_facets; ++f)
+            if (memcmp(sa.facet_start[f].vertex, sb.facet_start[f].vertex, sizeof(sa.facet_start[f].vertex)) != 0)
+                return false;
+    }
+    return true;
+}
+
+// Compares the import throughput of tiny_obj_loader with the one of the
+// multithreaded reader, and checks that both produce the same facets.
+int
+main(int argc, char **argv)
+{
+    // Convert arguments to UTF-8 (needed on Windows).
+    // argv then points to memory owned by a.
+    boost::nowide::args a(argc, argv);
+
+    // read config
+    ConfigDef config_def;
+    {
+        ConfigOptionDef* def;
+
+        def = config_def.add("repeat", coInt);
+        def->label = "Imports timed per file and reader";
+        def->cli = "repeat";
+        def->default_value = new ConfigOptionInt(3);
+    }
+    DynamicConfig config(&config_def);
+    t_config_option_keys input_files;
+    config.read_cli(argc, argv, &input_files);
+
+    if (input_files.empty()) {
+        boost::nowide::cerr << "Usage: bench-obj [--repeat N] file.obj [file.obj ...]" << std::endl;
+        return 1;
+    }
+    const int repeat = std::max(1, config.option("repeat", true)->getInt());
+
+    for (const std::string &file : input_files) {
+        const double mb = boost::filesystem::file_size(file) / (1024.0 * 1024.0);
+        boost::nowide::cout << file << " (" << mb << " MB)" << std::endl;
+
+        double time_tinyobj = 0, time_parallel = 0;
+        Model model_tinyobj, model_parallel;
+        for (int i = 0; i < repeat; ++i) {
+            model_tinyobj = Model();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            read_tinyobj(file, &model_tinyobj);
+            time_tinyobj += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            model_parallel = Model();
+            start = std::chrono::steady_clock::now();
+            IO::OBJ::read(file, &model_parallel);
+            time_parallel += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        time_tinyobj /= repeat;
+        time_parallel /= repeat;
+
+        size_t facets = 0;
+        for (const ModelVolume* volume : model_parallel.objects.front()->volumes)
+            facets += volume->mesh.stl.stats.number_of_facets;
+
+        boost::nowide::cout << "  " << model_parallel.objects.front()->volumes.size() << " volumes, "
+            << facets << " facets" << std::endl;
+        boost::nowide::cout << "  tiny_obj_loader: " << time_tinyobj << " s (" << (mb / time_tinyobj) << " MB/s)" << std::endl;
+        boost::nowide::cout << "  parallel:        " << time_parallel << " s (" << (mb / time_parallel) << " MB/s)" << std::endl;
+        if (!same_facets(model_tinyobj, model_parallel))
+            boost::nowide::cout << "  WARNING: the readers returned different facets" << std::endl;
+    }
+
+    return 0;
+}
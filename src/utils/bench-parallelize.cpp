@@ -0,0 +1,166 @@
+#include "Config.hpp"
+#include "libslic3r.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <boost/bind.hpp>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/iostream.hpp>
+
+using namespace Slic3r;
+
+void confess_at(const char *file, int line, const char *func, const char *pat, ...){}
+
+// parallelize() as it was before ThreadPool: new threads for each call,
+// popping one item at a time from a queue guarded by a mutex.
+template <class T> static void
+_queue_parallelize_do(std::queue<T>* queue, boost::mutex* queue_mutex, boost::function<void(T)> func)
+{
+    while (true) {
+        T i;
+        {
+            boost::lock_guard<boost::mutex> l(*queue_mutex);
+            if (queue->empty()) return;
+            i = queue->front();
+            queue->pop();
+        }
+        func(i);
+        boost::this_thread::interruption_point();
+    }
+}
+
+template <class T> static void
+queue_parallelize(T start, T end, boost::function<void(T)> func, int threads_count)
+{
+    std::queue<T> queue;
+    for (T i = start; i <= end; ++i) queue.push(i);
+    boost::mutex queue_mutex;
+    boost::thread_group workers;
+    for (int i = 0; i < std::min(threads_count, (int)queue.size()); i++)
+        workers.add_thread(new boost::thread(&_queue_parallelize_do<T>, &queue, &queue_mutex, func));
+    workers.join_all();
+}
+
+typedef void (*parallelize_t)(size_t, size_t, boost::function<void(size_t)>, int);
+
+static void
+pool_parallelize(size_t start, size_t end, boost::function<void(size_t)> func, int threads_count)
+{
+    parallelize<size_t>(start, end, func, threads_count);
+}
+
+// Items doing about as much work as the given number of square roots.
+struct Work {
+    std::vector<std::atomic<int> > runs;
+    std::atomic<double> sink;
+    size_t work;
+
+    Work(size_t items, size_t work) : runs(items), sink(0), work(work) {
+        for (std::atomic<int> &r : runs) r = 0;
+    };
+    void item(size_t i) {
+        double x = i;
+        for (size_t k = 0; k < this->work; ++k) x = sqrt(x + k);
+        if (x < 0) this->sink = x;
+        ++this->runs[i];
+    };
+    bool all_run_once() const {
+        for (const std::atomic<int> &r : runs)
+            if (r != 1) return false;
+        return true;
+    };
+};
+
+static double
+time_loop(parallelize_t parallelize_fn, size_t items, size_t work, size_t calls, int threads, bool* ok)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < calls; ++c) {
+        Work w(items, work);
+        parallelize_fn(0, items-1, boost::bind(&Work::item, &w, _1), threads);
+        if (!w.all_run_once()) *ok = false;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Outer items each running a loop of their own.
+struct Nested {
+    size_t inner;
+    int threads;
+    std::atomic<size_t> count;
+
+    Nested(size_t inner, int threads) : inner(inner), threads(threads), count(0) {};
+    void outer_item(size_t i) {
+        parallelize<size_t>(0, this->inner-1, boost::bind(&Nested::inner_item, this, _1), this->threads);
+    };
+    void inner_item(size_t i) { ++this->count; };
+};
+
+// Measures the overhead of parallelize() per item and per call, and checks
+// that each item is run exactly once, including in nested loops.
+int
+main(int argc, char **argv)
+{
+    // Convert arguments to UTF-8 (needed on Windows).
+    // argv then points to memory owned by a.
+    boost::nowide::args a(argc, argv);
+
+    // read config
+    ConfigDef config_def;
+    {
+        ConfigOptionDef* def;
+
+        def = config_def.add("threads", coInt);
+        def->label = "Threads";
+        def->cli = "threads";
+        const unsigned int threads = boost::thread::hardware_concurrency();
+        def->default_value = new ConfigOptionInt(threads > 0 ? threads : 2);
+
+        def = config_def.add("items", coInt);
+        def->label = "Items of the per-item overhead loops";
+        def->cli = "items";
+        def->default_value = new ConfigOptionInt(1000000);
+    }
+    DynamicConfig config(&config_def);
+    t_config_option_keys input_files;
+    config.read_cli(argc, argv, &input_files);
+    const int threads   = std::max(1, config.option("threads", true)->getInt());
+    const size_t items  = std::max(1, config.option("items", true)->getInt());
+
+    struct Case {
+        const char* name;
+        size_t items, work, calls;
+    };
+    const Case cases[] = {
+        { "empty items",                items,      0,      1    },
+        { "short items (20 sqrt)",      items,      20,     1    },
+        { "long items (20000 sqrt)",    1000,       20000,  1    },
+        { "calls of 16 empty items",    16,         0,      2000 },
+    };
+
+    boost::nowide::cout << threads << " threads" << std::endl;
+    bool ok = true;
+    for (const Case &c : cases) {
+        const double t_queue = time_loop(&queue_parallelize<size_t>, c.items, c.work, c.calls, threads, &ok);
+        const double t_pool  = time_loop(&pool_parallelize, c.items, c.work, c.calls, threads, &ok);
+        const double per = 1e9 / (c.items * c.calls);
+        boost::nowide::cout << "  " << c.name << ": " << c.calls << " x " << c.items << std::endl
+            << "    mutex queue: " << t_queue << " s (" << t_queue * per << " ns/item)" << std::endl
+            << "    thread pool: " << t_pool  << " s (" << t_pool  * per << " ns/item)" << std::endl;
+    }
+
+    {
+        Nested nested(1000, threads);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        parallelize<size_t>(0, 63, boost::bind(&Nested::outer_item, &nested, _1), threads);
+        const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        boost::nowide::cout << "  nested: 64 x 1000 empty items: " << t << " s" << std::endl;
+        if (nested.count != 64 * 1000) ok = false;
+    }
+
+    if (!ok) {
+        boost::nowide::cout << "ERROR: items were skipped or run more than once" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+#include "Config.hpp"
+#include "GCodeSender.hpp"
+#include "libslic3r.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <boost/nowide/fstream.hpp>
+#include <boost/nowide/iostream.hpp>
+
+using namespace Slic3r;
+
+void confess_at(const char *file, int line, const char *func, const char *pat, ...){}
+
+static double
+now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Emulates the serial protocol of a RepRap firmware on a pseudo-terminal:
+// bytes arrive at the baud rate into a receive buffer of rx_buffer bytes
+// (overflowing bytes are lost, as on the real thing), complete lines move
+// to a command queue of queue_size commands, and each command takes
+// line_time seconds to execute. The ok of a command is sent when its
+// execution starts, which frees its slot in the queue, and replies reach
+// the host after latency seconds.
+class FakePrinter {
+    public:
+    size_t rx_buffer;
+    size_t queue_size;
+    double line_time;
+    double latency;
+    unsigned int baud;
+    size_t error_every;     ///< corrupts one line out of error_every, 0 for none
+
+    struct Stats {
+        size_t executed, stalls, overflows, resends;
+        double idle_time;   ///< time spent waiting for commands between two of them
+        Stats() : executed(0), stalls(0), overflows(0), resends(0), idle_time(0) {};
+    };
+
+    FakePrinter() : rx_buffer(128), queue_size(4), line_time(0.001), latency(0.002),
+        baud(115200), error_every(0), _master(-1), _stop(false) {};
+    ~FakePrinter() { if (_master >= 0) ::close(_master); };
+
+    /// Creates the pseudo-terminal and returns the path of its slave side.
+    std::string open();
+    /// Serves the host until stop() is called.
+    void run();
+    void stop() { _stop = true; };
+    Stats stats() const {
+        std::lock_guard<std::mutex> l(_stats_mutex);
+        return _stats;
+    };
+    void reset_stats() {
+        std::lock_guard<std::mutex> l(_stats_mutex);
+        _stats = Stats();
+    };
+
+    private:
+    int _master;
+    std::atomic<bool> _stop;
+    mutable std::mutex _stats_mutex;
+    Stats _stats;
+
+    std::string _wire, _rx;
+    std::deque<std::string> _commands;
+    std::deque<std::pair<double,std::string> > _replies;
+    size_t _last_n = 0, _received = 0;
+
+    void _reply(const std::string &line, double t) {
+        _replies.push_back(std::make_pair(t + this->latency, line + "\n"));
+    };
+    void _process_line(std::string line, double t);
+};
+
+std::string
+FakePrinter::open()
+{
+    _master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (_master < 0 || grantpt(_master) != 0 || unlockpt(_master) != 0)
+        return "";
+    termios ios;
+    if (tcgetattr(_master, &ios) == 0) {
+        cfmakeraw(&ios);
+        tcsetattr(_master, TCSANOW, &ios);
+    }
+    fcntl(_master, F_SETFL, fcntl(_master, F_GETFL) | O_NONBLOCK);
+    return ptsname(_master);
+}
+
+void
+FakePrinter::_process_line(std::string line, double t)
+{
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+        line.pop_back();
+    if (line.empty()) return;
+
+    // unnumbered commands are accepted as they are
+    if (line[0] != 'N') {
+        _commands.push_back(line);
+        return;
+    }
+
+    const size_t star = line.rfind('*');
+    bool valid = star != std::string::npos;
+    if (valid) {
+        unsigned char cs = 0;
+        for (size_t i = 0; i < star; ++i) cs ^= line[i];
+        valid = atoi(line.c_str() + star + 1) == cs;
+    }
+    if (this->error_every > 0 && ++_received % this->error_every == 0)
+        valid = false;
+    const size_t n = strtoul(line.c_str() + 1, NULL, 10);
+    const std::string command = valid
+        ? line.substr(line.find(' ') + 1, star - line.find(' ') - 1)
+        : "";
+
+    if (valid && command.compare(0, 4, "M110") == 0) {
+        _last_n = n;
+    } else if (!valid || n != _last_n + 1) {
+        // as Marlin does, every rejected line gets a resend request
+        _reply(valid ? "Error:Line Number is not Last Line Number+1, Last Line: " + std::to_string(_last_n)
+            : "Error:checksum mismatch, Last Line: " + std::to_string(_last_n), t);
+        _reply("Resend: " + std::to_string(_last_n + 1), t);
+        _reply("ok", t);
+        std::lock_guard<std::mutex> l(_stats_mutex);
+        ++_stats.resends;
+        return;
+    }
+    _last_n = n;
+    _commands.push_back(command);
+}
+
+void
+FakePrinter::run()
+{
+    const double byte_time = 10.0 / this->baud;     // 8N1
+    double wire_clock = 0;      // time the next byte of _wire is received
+    double busy_until = 0;      // end of the command being executed
+    bool idle = true;
+    double idle_since = 0;
+
+    while (!_stop) {
+        pollfd pfd = { _master, POLLIN, 0 };
+        const int ret = poll(&pfd, 1, 1);
+        double t = now();
+        if (ret > 0 && (pfd.revents & POLLIN)) {
+            char buf[4096];
+            const ssize_t len = ::read(_master, buf, sizeof(buf));
+            if (len > 0) {
+                if (_wire.empty()) wire_clock = t + byte_time;
+                _wire.append(buf, len);
+            }
+        } else if (ret > 0 && (pfd.revents & POLLHUP)) {
+            // no host on the slave side
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // bytes arrive at the baud rate
+        size_t arrived = 0;
+        for (; arrived < _wire.size() && wire_clock <= t; ++arrived, wire_clock += byte_time) {
+            if (_rx.size() < this->rx_buffer) {
+                _rx += _wire[arrived];
+            } else {
+                std::lock_guard<std::mutex> l(_stats_mutex);
+                ++_stats.overflows;
+            }
+        }
+        _wire.erase(0, arrived);
+
+        // complete lines move to the command queue
+        size_t eol;
+        while (_commands.size() < this->queue_size && (eol = _rx.find('\n')) != std::string::npos) {
+            const std::string line = _rx.substr(0, eol);
+            _rx.erase(0, eol + 1);
+            _process_line(line, t);
+        }
+
+        if (t >= busy_until) {
+            if (!_commands.empty()) {
+                const std::string command = _commands.front();
+                _commands.pop_front();
+                {
+                    std::lock_guard<std::mutex> l(_stats_mutex);
+                    // no idle time is counted before the first command
+                    if (idle && _stats.executed > 0) {
+                        ++_stats.stalls;
+                        _stats.idle_time += t - idle_since;
+                    }
+                    ++_stats.executed;
+                }
+                idle = false;
+                busy_until = t + this->line_time;
+                _reply(command.compare(0, 4, "M105") == 0 ? "ok T:20.0 /0.0 B:20.0 /0.0" : "ok", t);
+            } else if (!idle) {
+                idle = true;
+                idle_since = busy_until;
+            }
+        }
+
+        while (!_replies.empty() && _replies.front().first <= t) {
+            const std::string &reply = _replies.front().second;
+            if (::write(_master, reply.data(), reply.size()) < 0 && errno == EAGAIN)
+                break;
+            _replies.pop_front();
+        }
+    }
+}
+
+// Streams lines to the printer through GCodeSender and returns the time
+// it took to execute them, or a negative value if the transfer stalled.
+static double
+stream(FakePrinter &printer, const std::string &port, size_t window,
+    const std::vector<std::string> &lines, size_t commands)
+{
+    GCodeSender sender;
+    if (!sender.connect(port, printer.baud, window) || !sender.wait_connected())
+        return -1;
+    // let the M105 sent on connection complete
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    printer.reset_stats();
+
+    const double start = now();
+    sender.send(lines);
+    double last_progress = start;
+    size_t executed = 0;
+    while (printer.stats().executed < commands) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (printer.stats().executed > executed) {
+            executed = printer.stats().executed;
+            last_progress = now();
+        } else if (now() - last_progress > 5) {
+            sender.disconnect();
+            return -1;
+        }
+    }
+    const double time = now() - start;
+    sender.disconnect();
+    return time;
+}
+
+// Without arguments, serves a fake printer on a pseudo-terminal until
+// interrupted. With G-code files, streams each of them to a fake printer
+// one line at a time, then with character-counting flow control, and
+// compares the throughput.
+int
+main(int argc, char **argv)
+{
+    ConfigDef config_def;
+    {
+        ConfigOptionDef* def;
+
+        def = config_def.add("rx_buffer", coInt);
+        def->label = "Receive buffer of the printer (bytes)";
+        def->cli = "rx-buffer";
+        def->default_value = new ConfigOptionInt(128);
+
+        def = config_def.add("queue", coInt);
+        def->label = "Command queue of the printer (commands)";
+        def->cli = "queue";
+        def->default_value = new ConfigOptionInt(4);
+
+        def = config_def.add("line_time", coFloat);
+        def->label = "Execution time of a command (ms)";
+        def->cli = "line-time";
+        def->default_value = new ConfigOptionFloat(1);
+
+        def = config_def.add("latency", coFloat);
+        def->label = "Delay of the replies (ms)";
+        def->cli = "latency";
+        def->default_value = new ConfigOptionFloat(2);
+
+        def = config_def.add("baud", coInt);
+        def->label = "Baud rate";
+        def->cli = "baud";
+        def->default_value = new ConfigOptionInt(115200);
+
+        def = config_def.add("error_every", coInt);
+        def->label = "Corrupt one line out of N";
+        def->cli = "error-every";
+        def->default_value = new ConfigOptionInt(0);
+    }
+    DynamicConfig config(&config_def);
+    t_config_option_keys input_files;
+    config.read_cli(argc, argv, &input_files);
+
+    const auto setup = [&config](FakePrinter &printer) {
+        printer.rx_buffer   = std::max(1, config.option("rx_buffer", true)->getInt());
+        printer.queue_size  = std::max(1, config.option("queue", true)->getInt());
+        printer.line_time   = config.option("line_time", true)->getFloat() / 1000;
+        printer.latency     = config.option("latency", true)->getFloat() / 1000;
+        printer.baud        = std::max(1, config.option("baud", true)->getInt());
+        printer.error_every = std::max(0, config.option("error_every", true)->getInt());
+    };
+
+    if (input_files.empty()) {
+        FakePrinter printer;
+        setup(printer);
+        const std::string port = printer.open();
+        if (port.empty()) {
+            boost::nowide::cerr << "Can't create a pseudo-terminal" << std::endl;
+            return 1;
+        }
+        boost::nowide::cout << "Fake printer listening on " << port << std::endl;
+        printer.run();
+        return 0;
+    }
+
+    for (const std::string &file : input_files) {
+        boost::nowide::ifstream ifs(file);
+        std::vector<std::string> lines;
+        size_t commands = 0;
+        for (std::string line; std::getline(ifs, line); ) {
+            lines.push_back(line);
+            // GCodeSender doesn't send comments and empty lines
+            const std::string command = line.substr(0, line.find(';'));
+            if (command.find_first_not_of(" \t\r") != std::string::npos)
+                ++commands;
+        }
+        boost::nowide::cout << file << " (" << commands << " commands)" << std::endl;
+
+        const size_t windows[] = { 0, size_t(std::max(1, config.option("rx_buffer", true)->getInt())) };
+        for (size_t window : windows) {
+            FakePrinter printer;
+            setup(printer);
+            const std::string port = printer.open();
+            if (port.empty()) {
+                boost::nowide::cerr << "Can't create a pseudo-terminal" << std::endl;
+                return 1;
+            }
+            std::thread thread(&FakePrinter::run, &printer);
+            const double time = stream(printer, port, window, lines, commands);
+            printer.stop();
+            thread.join();
+
+            const FakePrinter::Stats stats = printer.stats();
+            boost::nowide::cout << (window == 0 ? "  one line at a time: " : "  buffered:           ");
+            if (time < 0) {
+                boost::nowide::cout << "stalled after " << stats.executed << " commands" << std::endl;
+                continue;
+            }
+            boost::nowide::cout << time << " s (" << (commands / time) << " commands/s), "
+                << stats.stalls << " stalls (" << stats.idle_time << " s idle), "
+                << stats.overflows << " bytes lost, " << stats.resends << " resends" << std::endl;
+        }
+    }
+
+    return 0;
+}
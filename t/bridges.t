@@ -1,4 +1,4 @@
-use Test::More tests => 20;
+use Test::More tests => 28;
 use strict;
 use warnings;
 
@@ -117,6 +117,51 @@ use Slic3r::Test;
         'correct bridge angle when lower slices have narrow gap';
 }
 
+{
+    # Square O-shaped overhangs score the same along both of their sides, up to
+    # floating point noise: ties go to the smallest angle.
+    my $test = sub {
+        my ($rotate, $expected_angle) = @_;
+        
+        my $lower = Slic3r::ExPolygon->new(
+            Slic3r::Polygon->new_scale([-2,-2], [12,-2], [12,12], [-2,12]),
+            Slic3r::Polygon->new_scale([0,0], [0,10], [10,10], [10,0]),
+        );
+        $lower->translate(scale 20, scale 20); # avoid negative coordinates for easier SVG preview
+        $lower->rotate(deg2rad($rotate), [5,5]);
+        my $bridge = $lower->[1]->clone;
+        $bridge->reverse;
+        $bridge = Slic3r::ExPolygon->new($bridge);
+        
+        ok check_angle([$lower], $bridge, $expected_angle, 1), "smallest angle wins ties for square overhang rotated by $rotate";
+    };
+
+    $test->(0, 0);
+    $test->(10, 10);
+    $test->(90, 0);
+}
+
+{
+    # identical bridges stacked on consecutive layers share the detected angle
+    my $lower = Slic3r::ExPolygon::Collection->new(
+        Slic3r::ExPolygon->new(
+            Slic3r::Polygon->new_scale([-2,-2], [22,-2], [22,12], [-2,12]),
+            Slic3r::Polygon->new_scale([0,0], [0,10], [20,10], [20,0]),
+        ),
+    );
+    my $bridge = Slic3r::ExPolygon->new(Slic3r::Polygon->new_scale([0,0], [20,0], [20,10], [0,10]));
+    
+    my $cache = Slic3r::BridgeAngleCache->new;
+    my @angles = map {
+        my $bd = Slic3r::BridgeDetector->new($bridge, $lower, scale 0.5);
+        $bd->set_cache($cache);
+        $bd->detect_angle;
+        $bd->angle;
+    } 1..2;
+    is $angles[1], $angles[0], 'stacked identical bridges get the same angle';
+    ok $cache->hits == 1 && $cache->misses == 1, 'angle of the upper bridge is read from the cache';
+}
+
 sub check_angle {
     my ($lower, $bridge, $expected, $tolerance, $expected_coverage, $extrusion_width) = @_;
     
@@ -1,4 +1,4 @@
-use Test::More tests => 27;
+use Test::More tests => 30;
 use strict;
 use warnings;
 
@@ -10,7 +10,7 @@ BEGIN {
 
 use List::Util qw(first);
 use Slic3r;
-use Slic3r::Geometry qw(scale convex_hull);
+use Slic3r::Geometry qw(scale convex_hull PI);
 use Slic3r::Test;
 
 {
@@ -286,4 +286,79 @@ use Slic3r::Test;
     ok $had_gcode, 'M190/M140 codes are generated if has_heatbed = 1';
 }
 
+{
+    # the layers generated in parallel threads extrude as much as the
+    # layers generated in sequence, and never from a retracted state
+    my $extruded = sub {
+        my ($parallel) = @_;
+        my $config = Slic3r::Config->new_from_defaults;
+        $config->set('parallel_gcode', $parallel);
+        $config->set('threads', 4);
+        $config->set('skirts', 0);
+        
+        my $print = Slic3r::Test::init_print('cube_with_hole', config => $config, duplicate => 2);
+        my $total = 0;
+        my $retracted = 0;
+        my $extruded_while_retracted = 0;
+        Slic3r::GCode::Reader->new->parse(Slic3r::Test::gcode($print), sub {
+            my ($self, $cmd, $args, $info) = @_;
+            
+            if ($info->{retracting}) {
+                $retracted = 1;
+            } elsif ($info->{extruding} && $info->{dist_XY}) {
+                $extruded_while_retracted = 1 if $retracted;
+                $total += $info->{dist_E};
+            } elsif ($info->{extruding}) {
+                $retracted = 0;
+            }
+        });
+        return ($total, $extruded_while_retracted);
+    };
+    
+    my ($sequential) = $extruded->(0);
+    my ($parallel, $extruded_while_retracted) = $extruded->(1);
+    ok abs($parallel - $sequential) < 0.1, 'parallel G-code generation extrudes the same amount';
+    ok !$extruded_while_retracted, 'parallel G-code generation unretracts before extruding';
+}
+
+{
+    # layers generated in parallel threads plan their travel moves around
+    # perimeters like the layers generated in sequence, including the first
+    # travel of each layer that needs retraction
+    my $travel_moves = sub {
+        my ($parallel) = @_;
+        my $config = Slic3r::Config->new_from_defaults;
+        $config->set('parallel_gcode', $parallel);
+        $config->set('threads', 4);
+        $config->set('skirts', 0);
+        $config->set('layer_height', 0.3);
+        $config->set('fill_density', 30);
+        $config->set('avoid_crossing_perimeters', 1);
+        $config->set('retract_lift', [0.3]);
+        $config->set('wipe', [1]);
+        
+        # six pillars, so that every layer has several islands
+        my $mesh = Slic3r::TriangleMesh::make_cylinder(1, 10, 2*PI/90);
+        for my $i (1..5) {
+            my $pillar = Slic3r::TriangleMesh::make_cylinder(1, 10, 2*PI/90);
+            $pillar->translate(5 * ($i % 3), 5 * int($i / 3), 0);
+            $mesh->merge($pillar);
+        }
+        my $model = Slic3r::Model->new;
+        my $object = $model->add_object;
+        $object->add_volume(mesh => $mesh);
+        $object->add_instance(offset => Slic3r::Pointf->new(0,0));
+        
+        my $print = Slic3r::Test::init_print($model, config => $config, duplicate => 2);
+        my $travel_moves = 0;
+        Slic3r::GCode::Reader->new->parse(Slic3r::Test::gcode($print), sub {
+            my ($self, $cmd, $args, $info) = @_;
+            $travel_moves++ if $cmd eq 'G1' && !$info->{extruding} && $info->{dist_XY} > 0;
+        });
+        return $travel_moves;
+    };
+    
+    is $travel_moves->(1), $travel_moves->(0), 'parallel G-code generation avoids crossing perimeters';
+}
+
 __END__
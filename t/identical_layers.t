@@ -0,0 +1,64 @@
+use Test::More tests => 6;
+use strict;
+use warnings;
+
+BEGIN {
+    use FindBin;
+    use lib "$FindBin::Bin/../lib";
+    use local::lib "$FindBin::Bin/../local-lib";
+}
+
+use List::Util qw(first);
+use Slic3r;
+use Slic3r::Test;
+
+# Processes the print and returns its object, with the perimeters and fills
+# of each layer as strings.
+sub process {
+    my ($model, $config, $reuse) = @_;
+
+    my $print = Slic3r::Test::init_print($model, config => $config);
+    my $object = $print->print->objects->[0];
+    $object->set_reuse_identical_layers($reuse);
+    $print->print->process;
+
+    my $wkt = sub { join ';', map $_->as_polyline->wkt, @{$_[0]->flatten} };
+    my @layers = map {
+        my $layer = $_;
+        join '|', map { $wkt->($_->perimeters) . '#' . $wkt->($_->fills) } @{$layer->regions};
+    } @{$object->layers};
+    return ($print, $object, \@layers);
+}
+
+{
+    my $config = Slic3r::Config->new_from_defaults;
+    $config->set('skirts', 0);
+
+    my (undef, $object, $reused)  = process('20mm_cube', $config, 1);
+    my (undef, undef, $generated) = process('20mm_cube', $config, 0);
+    ok((grep $_->perimeters_reused, @{$object->layers}), 'perimeters of identical layers are reused');
+    ok((grep $_->fills_reused, @{$object->layers}), 'fills of identical layers are reused');
+    is_deeply $reused, $generated, 'reused perimeters and fills equal the generated ones';
+}
+
+foreach my $pattern (qw(gyroid 3dhoneycomb)) {
+    my $config = Slic3r::Config->new_from_defaults;
+    $config->set('skirts', 0);
+    $config->set('fill_pattern', $pattern);
+
+    my (undef, $object) = process('20mm_cube', $config, 1);
+    ok !(first { $_->fills_reused } @{$object->layers}), "$pattern fills are never reused";
+}
+
+{
+    my $config = Slic3r::Config->new_from_defaults;
+    $config->set('skirts', 0);
+    $config->set('nonplanar_layers', 1);
+
+    my (undef, $object) = process('slopy_cube', $config, 1);
+    my @nonplanar = grep $_->has_nonplanar_surfaces, @{$object->layers};
+    ok @nonplanar && !(first { $_->perimeters_reused || $_->fills_reused } @nonplanar),
+        'layers with nonplanar surfaces are never reused';
+}
+
+__END__
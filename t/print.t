@@ -1,4 +1,4 @@
-use Test::More tests => 6;
+use Test::More tests => 9;
 use strict;
 use warnings;
 
@@ -8,6 +8,7 @@ BEGIN {
     use local::lib "$FindBin::Bin/../local-lib";
 }
 
+use JSON::PP;
 use List::Util qw(first);
 use Slic3r;
 use Slic3r::Geometry qw(epsilon unscale X Y);
@@ -57,4 +58,22 @@ use Slic3r::Test;
     is $print->print->regions->[0]->config->perimeter_extruder, 2, 'extruder setting does not override explicitely specified extruders';
 }
 
+{
+    my $config = Slic3r::Config->new_from_defaults;
+    $config->set('skirts', 0);
+    $config->set('brim_width', 2);
+    my $print = Slic3r::Test::init_print('20mm_cube', config => $config);
+    Slic3r::Test::gcode($print);
+    
+    my $profile = JSON::PP->new->decode($print->print->profile_json);
+    my $object = $profile->{objects}[0];
+    my %steps = map { $_->{step} => $_ } @{$object->{steps}};
+    ok !(grep { !$steps{$_} || $steps{$_}{runs} < 1 } qw(slice perimeters detect_surfaces prepare_infill infill)),
+        'profile records the steps of the object';
+    is scalar(@{$steps{slice}{layers}}), $print->print->objects->[0]->layer_count,
+        'profile records each layer of a step';
+    my ($brim) = grep { $_->{step} eq 'brim' } @{$profile->{steps}};
+    is $brim->{items}, scalar(@{$print->print->brim}), 'profile counts the items of a step';
+}
+
 __END__
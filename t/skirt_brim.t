@@ -1,4 +1,4 @@
-use Test::More tests => 8;
+use Test::More tests => 10;
 use strict;
 use warnings;
 
@@ -167,6 +167,27 @@ use Slic3r::Test;
     ok $skirt_length > $hull_perimeter, 'skirt length is large enough to contain object with support';
 }
 
+{
+    my $config = Slic3r::Config->new_from_defaults;
+    $config->set('skirts', 0);
+    $config->set('brim_width', 3);
+    
+    my $test = sub {
+        my $print = Slic3r::Test::init_print('20mm_cube', config => $config, duplicate => 4);
+        $print->process;
+        my $num_loops = int($config->brim_width / $print->print->brim_flow->width + 0.5);
+        return (scalar(@{$print->print->brim}), $num_loops);
+    };
+    
+    $config->set('duplicate_distance', 10);
+    my ($loops, $num_loops) = $test->();
+    is $loops, 4 * $num_loops, 'copies whose brims don\'t meet get a brim each';
+    
+    $config->set('duplicate_distance', 2);
+    ($loops, $num_loops) = $test->();
+    ok $loops < 4 * $num_loops, 'brims of close copies are merged';
+}
+
 {
     my $config = Slic3r::Config->new_from_defaults;
     $config->set('min_skirt_length', 20);
@@ -0,0 +1,70 @@
+use Test::More tests => 9;
+use strict;
+use warnings;
+
+BEGIN {
+    use FindBin;
+    use lib "$FindBin::Bin/../lib";
+    use local::lib "$FindBin::Bin/../local-lib";
+}
+
+use File::Temp qw(tempdir);
+use Slic3r;
+use Slic3r::Test;
+
+# Slices the cube and returns the slices of each layer.
+sub slices {
+    my ($config) = @_;
+
+    my $print = Slic3r::Test::init_print('20mm_cube', config => $config);
+    my $object = $print->print->objects->[0];
+    $object->slice;
+    return [ map $_->slices->pp, @{$object->layers} ];
+}
+
+my $config = Slic3r::Config->new_from_defaults;
+my $expected = slices($config);
+
+{
+    my $dir = tempdir(CLEANUP => 1);
+    $config->set('slice_cache_dir', $dir);
+
+    is_deeply slices($config), $expected, 'slices are not altered by the cache';
+    my @entries = glob "$dir/*.slices";
+    is scalar(@entries), 1, 'slices are stored in the cache directory';
+
+    my $entry = $entries[0];
+    my ($inode, $size) = (stat $entry)[1,7];
+    utime 0, 0, $entry;
+    is_deeply slices($config), $expected, 'cached slices equal the computed ones';
+    ok((stat $entry)[9] > 0 && (stat $entry)[1] == $inode, 'stored entry is read and marked as recently used');
+
+    truncate $entry, int($size/2);
+    is_deeply slices($config), $expected, 'truncated entry falls back to slicing';
+    is -s $entry, $size, 'truncated entry is stored again';
+
+    open my $fh, '+<:raw', $entry or die "Can't open $entry: $!";
+    print $fh 'XXXX';
+    close $fh;
+    is_deeply slices($config), $expected, 'corrupted entry falls back to slicing';
+}
+
+{
+    my $dir = tempdir(CLEANUP => 1);
+    $config->set('slice_cache_dir', $dir);
+    $config->set('slice_cache_size', 1);
+
+    # an old entry filling the whole budget
+    my $old = "$dir/0000000000000000.slices";
+    open my $fh, '>:raw', $old or die "Can't write $old: $!";
+    print $fh "\0" x (1024 * 1024);
+    close $fh;
+    utime 1, 1, $old;
+
+    slices($config);
+    my @entries = glob "$dir/*.slices";
+    ok !-e $old, 'least recently used entries are evicted beyond slice_cache_size';
+    is scalar(@entries), 1, 'new entry is kept';
+}
+
+__END__
@@ -212,8 +212,12 @@ sub new {
 package Slic3r::GUI::_3DScene::GLVertexArray;
 sub CLONE_SKIP { 1 }
 
+package Slic3r::GUI::_3DScene::ToolpathsPreview;
+sub CLONE_SKIP { 1 }
+
 package main;
 for my $class (qw(
+        Slic3r::BridgeAngleCache
         Slic3r::BridgeDetector
         Slic3r::Config
         Slic3r::Config::Full
@@ -239,6 +243,7 @@ for my $class (qw(
         Slic3r::Geometry::BoundingBox
         Slic3r::Geometry::BoundingBoxf
         Slic3r::Geometry::BoundingBoxf3
+        Slic3r::GUI::_3DScene::GLVertexArray
         Slic3r::Layer
         Slic3r::Layer::Region
         Slic3r::Layer::Support
@@ -34,6 +34,49 @@ ZipArchive::add_entry (std::string entry_path, std::string file_path)
     return stats;
 }
 
+mz_bool
+ZipArchive::add_entry (std::string entry_path, const void* data, size_t size, int level)
+{
+    stats = 0;
+    // Check if it's in the write mode.
+    if(mode != 'W')
+        return stats;
+    stats = mz_zip_writer_add_mem(&archive, entry_path.c_str(), data, size, level);
+    return stats;
+}
+
+mz_bool
+ZipArchive::add_entry (std::string entry_path, ZipDeflateStream &stream)
+{
+    stats = 0;
+    // Check if it's in the write mode.
+    if(mode != 'W' || !stream.finish())
+        return stats;
+    const std::string &data = stream.compressed_data();
+    stats = mz_zip_writer_add_mem_ex(&archive, entry_path.c_str(), data.data(), data.size(), nullptr, 0,
+        ZIP_DEFLATE_COMPRESSION | MZ_ZIP_FLAG_COMPRESSED_DATA, stream.uncompressed_size(), stream.uncompressed_crc32());
+    return stats;
+}
+
+static size_t
+extract_callback(void* opaque, mz_uint64 file_ofs, const void* data, size_t size)
+{
+    const std::function<bool(const char*, size_t)> &callback = *static_cast<const std::function<bool(const char*, size_t)>*>(opaque);
+    // Returning less than size makes miniz abort the extraction.
+    return callback(static_cast<const char*>(data), size) ? size : 0;
+}
+
+mz_bool
+ZipArchive::extract_entry (std::string entry_path, std::function<bool(const char* data, size_t size)> callback)
+{
+    stats = 0;
+    // Check if it's in the read mode.
+    if (mode != 'R')
+        return stats;
+    stats = mz_zip_reader_extract_file_to_callback(&archive, entry_path.c_str(), extract_callback, &callback, 0);
+    return stats;
+}
+
 mz_bool
 ZipArchive::extract_entry (std::string entry_path, std::string file_path)
 {
@@ -45,6 +88,27 @@ ZipArchive::extract_entry (std::string entry_path, std::string file_path)
     return stats;
 }
 
+std::vector<std::string>
+ZipArchive::entries()
+{
+    std::vector<std::string> paths;
+    stats = 0;
+    // Check if it's in the read mode.
+    if (mode != 'R')
+        return paths;
+    const mz_uint count = mz_zip_reader_get_num_files(&archive);
+    for (mz_uint i = 0; i < count; ++i) {
+        if (mz_zip_reader_is_file_a_directory(&archive, i))
+            continue;
+        // Query the length first, as names are not bounded by MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE.
+        std::vector<char> path(mz_zip_reader_get_filename(&archive, i, nullptr, 0));
+        if (!path.empty() && mz_zip_reader_get_filename(&archive, i, path.data(), path.size()) > 0)
+            paths.push_back(path.data());
+    }
+    stats = 1;
+    return paths;
+}
+
 mz_bool
 ZipArchive::finalize()
 {
@@ -66,4 +130,81 @@ ZipArchive::~ZipArchive() {
         this->finalize();
 }
 
+ZipDeflateStream::ZipDeflateStream(int level) : std::ostream(nullptr), buffer(level), finished(false)
+{
+    this->rdbuf(&buffer);
+    if (!buffer.ok)
+        this->setstate(std::ios::badbit);
+}
+
+ZipDeflateStream::~ZipDeflateStream()
+{
+    this->rdbuf(nullptr);
+}
+
+bool
+ZipDeflateStream::finish()
+{
+    if (!finished) {
+        finished = true;
+        this->flush();
+        buffer.compress(TDEFL_FINISH);
+    }
+    return buffer.ok && this->good();
+}
+
+ZipDeflateStream::Buffer::Buffer(int level) : size(0), crc(MZ_CRC32_INIT), ok(true)
+{
+    // The compressor state is too large for the stack.
+    compressor = static_cast<tdefl_compressor*>(malloc(sizeof(tdefl_compressor)));
+    // Raw deflate stream as stored in zip archives, same settings as mz_zip_writer_add_mem().
+    ok = compressor != nullptr && tdefl_init(compressor, put_buf, this,
+        tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY)) == TDEFL_STATUS_OKAY;
+    this->setp(input, input + sizeof(input));
+}
+
+ZipDeflateStream::Buffer::~Buffer()
+{
+    free(compressor);
+}
+
+mz_bool
+ZipDeflateStream::Buffer::put_buf(const void* data, int len, void* user)
+{
+    static_cast<Buffer*>(user)->compressed.append(static_cast<const char*>(data), len);
+    return MZ_TRUE;
+}
+
+bool
+ZipDeflateStream::Buffer::compress(tdefl_flush flush)
+{
+    const size_t len = this->pptr() - this->pbase();
+    if (ok) {
+        crc = (mz_uint32)mz_crc32(crc, reinterpret_cast<const mz_uint8*>(this->pbase()), len);
+        size += len;
+        const tdefl_status status = tdefl_compress_buffer(compressor, this->pbase(), len, flush);
+        ok = (flush == TDEFL_FINISH) ? status == TDEFL_STATUS_DONE : status == TDEFL_STATUS_OKAY;
+    }
+    this->setp(input, input + sizeof(input));
+    return ok;
+}
+
+int
+ZipDeflateStream::Buffer::overflow(int c)
+{
+    if (!this->compress(TDEFL_NO_FLUSH))
+        return traits_type::eof();
+    if (c != traits_type::eof()) {
+        *this->pptr() = traits_type::to_char_type(c);
+        this->pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int
+ZipDeflateStream::Buffer::sync()
+{
+    return this->compress(TDEFL_NO_FLUSH) ? 0 : -1;
+}
+
 }
@@ -4,12 +4,55 @@
 #define MINIZ_HEADER_FILE_ONLY
 #define ZIP_DEFLATE_COMPRESSION 8
 
+#include <functional>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <miniz/miniz.h>
 
 namespace Slic3r {
 
+/// An output stream deflating everything written to it, to be added to a
+/// ZipArchive with add_entry() once complete. Only the compressed data is kept
+/// in memory, so large entries can be written without a temporary file.
+class ZipDeflateStream : public std::ostream
+{
+public:
+    /// \param level int the compression level.
+    ZipDeflateStream(int level = ZIP_DEFLATE_COMPRESSION);
+    ~ZipDeflateStream();
+
+    /// Flush the compressor. No more data can be written afterwards.
+    /// \return bool false if the compression failed.
+    bool finish();
+
+    const std::string& compressed_data() const { return buffer.compressed; };
+    mz_uint64 uncompressed_size() const { return buffer.size; };
+    mz_uint32 uncompressed_crc32() const { return buffer.crc; };
+
+private:
+    class Buffer : public std::streambuf
+    {
+    public:
+        Buffer(int level);
+        ~Buffer();
+        bool compress(tdefl_flush flush);
+        std::string compressed;
+        mz_uint64 size;
+        mz_uint32 crc;
+        bool ok;
+    protected:
+        int overflow(int c);
+        int sync();
+    private:
+        tdefl_compressor* compressor;
+        char input[1 << 16];
+        static mz_bool put_buf(const void* data, int len, void* user);
+    };
+    Buffer buffer;
+    bool finished;
+};
+
 /// A zip wrapper for Miniz lib.
 class ZipArchive
 {
@@ -30,12 +73,36 @@ public:
     /// \return mz_bool 0: failure 1: success.
     mz_bool add_entry (std::string entry_path, std::string file_path);
 
+    /// Add an in-memory buffer to the current zip archive.
+    /// \param entry_path string the path of the entry in the zip archive.
+    /// \param data pointer to the buffer holding the entry contents.
+    /// \param size size_t the buffer size in bytes.
+    /// \param level int the compression level (use MZ_NO_COMPRESSION for data that is already compressed).
+    /// \return mz_bool 0: failure 1: success.
+    mz_bool add_entry (std::string entry_path, const void* data, size_t size, int level = ZIP_DEFLATE_COMPRESSION);
+
+    /// Add the contents of a deflate stream to the current zip archive.
+    /// \param entry_path string the path of the entry in the zip archive.
+    /// \param stream ZipDeflateStream& the stream holding the entry contents. It is finished if not done yet.
+    /// \return mz_bool 0: failure 1: success.
+    mz_bool add_entry (std::string entry_path, ZipDeflateStream &stream);
+
     /// Extract a zip entry to a file on the disk.
     /// \param entry_path string the path of the entry in the zip archive.
     /// \param file_path string the path of the file in the disk.
     /// \return mz_bool 0: failure 1: success.
     mz_bool extract_entry (std::string entry_path, std::string file_path);
 
+    /// Inflate a zip entry, passing the data to a callback chunk by chunk.
+    /// \param entry_path string the path of the entry in the zip archive.
+    /// \param callback function called with each chunk of inflated data in order. Returning false aborts the extraction.
+    /// \return mz_bool 0: failure 1: success.
+    mz_bool extract_entry (std::string entry_path, std::function<bool(const char* data, size_t size)> callback);
+
+    /// List the files stored in the zip archive, leaving out directories.
+    /// \return vector<string> the paths of the entries, in the order of the central directory.
+    std::vector<std::string> entries();
+
     /// Finalize the archive and free any allocated memory.
     /// \return mz_bool 0: failure 1: success.
     mz_bool finalize();
@@ -1,14 +1,24 @@
 #include "BridgeDetector.hpp"
 #include "ClipperUtils.hpp"
 #include "Geometry.hpp"
+#include "GeometryHash.hpp"
 #include <algorithm>
+#include <limits>
+#include <boost/version.hpp>
+#if BOOST_VERSION >= 107300
+#include <boost/bind/bind.hpp>
+#endif
 
 namespace Slic3r {
 
+#if BOOST_VERSION >= 107300
+using boost::placeholders::_1;
+#endif
+
 BridgeDetector::BridgeDetector(const ExPolygon &_expolygon, const ExPolygonCollection &_lower_slices,
     coord_t _extrusion_width)
     : expolygon(_expolygon), extrusion_width(_extrusion_width),
-        resolution(PI/36.0), angle(-1)
+        resolution(PI/36.0), angle(-1), threads(1), cache(NULL)
 {
     /*  outset our bridge by an arbitrary amout; we'll use this outer margin
         for detecting anchors */
@@ -59,6 +69,24 @@ BridgeDetector::detect_angle()
     // and there are no anchors available at the layer below.
     if (this->_edges.empty() || this->_anchors.empty()) return false;
     
+    if (this->cache == NULL || !this->cache->find(*this, &this->angle)) {
+        this->angle = this->_detect_angle();
+        if (this->cache != NULL) this->cache->store(*this, this->angle);
+    }
+    
+    #ifdef SLIC3R_DEBUG
+    if (this->angle != -1)
+        printf("  Optimal infill angle is %d degrees\n", (int)Slic3r::Geometry::rad2deg(this->angle));
+    #endif
+    
+    return this->angle != -1;
+}
+
+/// Brute force search of the bridging angle; returns -1 if no direction
+/// has any line anchored at both ends.
+double
+BridgeDetector::_detect_angle() const
+{
     /*  Outset the bridge expolygon by half the amount we used for detecting anchors;
         we'll use this one to clip our test lines and be sure that their endpoints
         are inside the anchors and not on their contours leading to false negatives. */
@@ -106,46 +134,18 @@ BridgeDetector::detect_angle()
             candidates.push_back(BridgeDirection(angle));
     }
     
-    const coord_t line_increment = this->extrusion_width;
+    // candidates are scored independently, each one into its own slot
+    const ExPolygonGrid anchors(this->_anchors);
+    parallelize<size_t>(
+        0,
+        candidates.size()-1,
+        boost::bind(&BridgeDetector::_evaluate_candidate, this, _1, &clip_area, &anchors, &candidates),
+        this->threads
+    );
+    
+    // if no direction produced coverage, then there's no bridge direction
     bool have_coverage = false;
-    for (BridgeDirection &candidate : candidates) {
-        Polygons my_clip_area = clip_area;
-        ExPolygons my_anchors = this->_anchors;
-        
-        // rotate everything - the center point doesn't matter
-        for (Polygon &p : my_clip_area)
-            p.rotate(-candidate.angle, Point(0,0));
-        for (ExPolygon &e : my_anchors)
-            e.rotate(-candidate.angle, Point(0,0));
-    
-        // generate lines in this direction
-        BoundingBox bb;
-        for (const ExPolygon &e : my_anchors)
-            bb.merge(e.bounding_box());
-        
-        Lines lines;
-        for (coord_t y = bb.min.y; y <= bb.max.y; y += line_increment)
-            lines.push_back(Line(Point(bb.min.x, y), Point(bb.max.x, y)));
-        
-        const Lines clipped_lines = intersection_ln(lines, my_clip_area);
-        
-        for (const Line &line : clipped_lines) {
-            // skip any line not having both endpoints within anchors
-            if (!Slic3r::Geometry::contains(my_anchors, line.a)
-                || !Slic3r::Geometry::contains(my_anchors, line.b))
-                continue;
-            
-            candidate.max_length = std::max(candidate.max_length, line.length());
-            // Calculate coverage as actual covered area, because length of centerlines
-            // is not accurate enough when such lines are slightly skewed and not parallel
-            // to the sides; calculating area will compute them as triangles.
-            // TODO: use a faster algorithm for computing covered area by using a sweep line
-            // instead of intersecting many lines.
-            candidate.coverage += Slic3r::Geometry::area(intersection(
-                my_clip_area,
-                offset((Polyline)line, +this->extrusion_width/2)
-            ));
-        }
+    for (const BridgeDirection &candidate : candidates) {
         if (candidate.coverage > 0) have_coverage = true;
         
         #if 0
@@ -155,29 +155,197 @@ BridgeDetector::detect_angle()
             << std::endl;
         #endif
     }
+    if (!have_coverage) return -1;
     
-    // if no direction produced coverage, then there's no bridge direction
-    if (!have_coverage) return false;
-    
-    // sort directions by coverage - most coverage first
-    std::sort(candidates.begin(), candidates.end());
+    // sort directions by coverage - most coverage first; equal coverages keep
+    // the ascending angle order
+    std::stable_sort(candidates.begin(), candidates.end());
     
     // if any other direction is within extrusion width of coverage, prefer it if shorter
     // TODO: There are two options here - within width of the angle with most coverage, or within width of the currently perferred?
+    // Coverage and lengths are integrated in floating point, so lengths within
+    // SCALED_EPSILON are a tie, which goes to the smallest angle.
     size_t i_best = 0;
-    for (size_t i = 1; i < candidates.size() && candidates[i_best].coverage - candidates[i].coverage < this->extrusion_width; ++ i)
-        if (candidates[i].max_length < candidates[i_best].max_length)
+    for (size_t i = 1; i < candidates.size() && candidates[i_best].coverage - candidates[i].coverage < this->extrusion_width; ++ i) {
+        const double shorter = candidates[i_best].max_length - candidates[i].max_length;
+        if (shorter > SCALED_EPSILON
+            || (shorter >= -SCALED_EPSILON && candidates[i].angle < candidates[i_best].angle))
             i_best = i;
+    }
     
-    this->angle = candidates[i_best].angle;
+    double angle = candidates[i_best].angle;
+    if (angle >= PI) angle -= PI;
+    return angle;
+}
+
+/*  Scores a single candidate angle. Instead of rotating the geometry and clipping
+    the test lines with Clipper, the clip area edges are rotated once into a flat
+    list bucketed by scanline, so that each test line is found as an interval between
+    two crossings and its coverage is integrated analytically. */
+void
+BridgeDetector::_evaluate_candidate(size_t i, const Polygons* clip_area, const ExPolygonGrid* anchors,
+    std::vector<BridgeDirection>* candidates) const
+{
+    BridgeDirection &candidate = (*candidates)[i];
     
-    if (this->angle >= PI) this->angle -= PI;
+    // rotate everything by -angle so that test lines are horizontal - the center point doesn't matter
+    const double c = cos(-candidate.angle);
+    const double s = sin(-candidate.angle);
     
-    #ifdef SLIC3R_DEBUG
-    printf("  Optimal infill angle is %d degrees\n", (int)Slic3r::Geometry::rad2deg(this->angle));
-    #endif
+    // test lines span the bounding box of the rotated anchors
+    double min_x = +std::numeric_limits<double>::max(), max_x = -std::numeric_limits<double>::max();
+    double min_y = min_x, max_y = max_x;
+    for (const ExPolygon &anchor : this->_anchors) {
+        for (const Point &p : anchor.contour.points) {
+            const double x = c * p.x - s * p.y;
+            const double y = s * p.x + c * p.y;
+            min_x = std::min(min_x, x); max_x = std::max(max_x, x);
+            min_y = std::min(min_y, y); max_y = std::max(max_y, y);
+        }
+    }
     
-    return true;
+    std::vector<RotatedEdge> edges;
+    for (const Polygon &polygon : *clip_area) {
+        for (size_t j = 0; j < polygon.points.size(); ++j) {
+            const Point &a = polygon.points[j];
+            const Point &b = polygon.points[(j+1) % polygon.points.size()];
+            const double ax = c * a.x - s * a.y, ay = s * a.x + c * a.y;
+            const double bx = c * b.x - s * b.y, by = s * b.x + c * b.y;
+            if (ay == by) continue;  // horizontal edges don't cross any scanline
+            RotatedEdge e;
+            if (ay < by) {
+                e.y0 = ay; e.y1 = by; e.x0 = ax; e.winding = +1;
+                e.dxdy = (bx - ax) / (by - ay);
+            } else {
+                e.y0 = by; e.y1 = ay; e.x0 = bx; e.winding = -1;
+                e.dxdy = (ax - bx) / (ay - by);
+            }
+            edges.push_back(e);
+        }
+    }
+    
+    // bucket the edges by the band of half extrusion width around each test line
+    const double w    = this->extrusion_width;
+    const size_t rows = size_t(floor((max_y - min_y) / w)) + 1;
+    std::vector<std::vector<size_t> > buckets(rows);
+    for (size_t j = 0; j < edges.size(); ++j) {
+        const double r0 = ceil((edges[j].y0 - min_y - w/2) / w);
+        const double r1 = floor((edges[j].y1 - min_y + w/2) / w);
+        for (double r = std::max(r0, 0.); r <= std::min(r1, double(rows-1)); ++r)
+            buckets[size_t(r)].push_back(j);
+    }
+    
+    std::vector<std::pair<double,int> > crossings;
+    for (size_t r = 0; r < rows; ++r) {
+        const double y = min_y + r * w;
+        
+        crossings.clear();
+        for (size_t j : buckets[r])
+            if (edges[j].y0 <= y && y < edges[j].y1)
+                crossings.push_back(std::make_pair(edges[j].x_at(y), edges[j].winding));
+        std::sort(crossings.begin(), crossings.end());
+        
+        // walk the crossings collecting the intervals with non-zero winding
+        int winding = 0;
+        double start = 0;
+        for (const std::pair<double,int> &crossing : crossings) {
+            const int prev = winding;
+            winding += crossing.second;
+            if (prev == 0) {
+                start = crossing.first;
+                continue;
+            }
+            if (winding != 0) continue;
+            
+            // clip the test line to the anchors' bounding box
+            const double xa = std::max(start, min_x);
+            const double xb = std::min(crossing.first, max_x);
+            if (xa >= xb) continue;
+            
+            // skip any line not having both endpoints within anchors
+            // (rotate the endpoints back instead of rotating the anchors)
+            const Point a(coord_t(round(c * xa + s * y)), coord_t(round(-s * xa + c * y)));
+            const Point b(coord_t(round(c * xb + s * y)), coord_t(round(-s * xb + c * y)));
+            if (!anchors->contains(a) || !anchors->contains(b))
+                continue;
+            
+            candidate.max_length = std::max(candidate.max_length, xb - xa);
+            // Calculate coverage as actual covered area, because length of centerlines
+            // is not accurate enough when such lines are slightly skewed and not parallel
+            // to the sides; calculating area will compute them as triangles.
+            // The area is the one of the clip area inside the square-capped extrusion.
+            candidate.coverage += _clipped_area(edges, buckets[r], xa - w/2, xb + w/2, y - w/2, y + w/2);
+        }
+    }
+}
+
+/*  Area of the polygons described by edges within the [x0,x1] x [y0,y1] rectangle.
+    Between edge endpoints the cross section is a fixed set of intervals whose ends
+    move linearly with y; once clamped to [x0,x1] their length stays piecewise linear,
+    so the trapezoid rule is exact over the pieces. */
+double
+BridgeDetector::_clipped_area(const std::vector<RotatedEdge> &edges, const std::vector<size_t> &bucket,
+    double x0, double x1, double y0, double y1)
+{
+    std::vector<double> ys;
+    ys.push_back(y0);
+    ys.push_back(y1);
+    for (size_t j : bucket) {
+        if (edges[j].y0 > y0 && edges[j].y0 < y1) ys.push_back(edges[j].y0);
+        if (edges[j].y1 > y0 && edges[j].y1 < y1) ys.push_back(edges[j].y1);
+    }
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    
+    double area = 0;
+    std::vector<std::pair<double,size_t> > active;
+    for (size_t k = 1; k < ys.size(); ++k) {
+        const double ya = ys[k-1], yb = ys[k];
+        
+        // the set of crossing edges (and their order) doesn't change within the piece
+        const double ym = (ya + yb) / 2;
+        active.clear();
+        for (size_t j : bucket)
+            if (edges[j].y0 <= ym && ym < edges[j].y1)
+                active.push_back(std::make_pair(edges[j].x_at(ym), j));
+        std::sort(active.begin(), active.end());
+        
+        int winding = 0;
+        size_t left = 0;
+        for (const std::pair<double,size_t> &a : active) {
+            const int prev = winding;
+            winding += edges[a.second].winding;
+            if (prev == 0) {
+                left = a.second;
+                continue;
+            }
+            if (winding != 0) continue;
+            
+            const RotatedEdge &l = edges[left];
+            const RotatedEdge &r = edges[a.second];
+            
+            // the clamped length has kinks where either end crosses x0 or x1
+            double t[6] = { ya, yb, ya, ya, ya, ya };
+            size_t n = 2;
+            for (const RotatedEdge* e : { &l, &r }) {
+                if (e->dxdy == 0) continue;
+                for (double x : { x0, x1 }) {
+                    const double y = e->y0 + (x - e->x0) / e->dxdy;
+                    if (y > ya && y < yb) t[n++] = y;
+                }
+            }
+            std::sort(t, t + n);
+            
+            double prev_len = -1;
+            for (size_t m = 0; m < n; ++m) {
+                const double len = std::max(0.,
+                    std::min(r.x_at(t[m]), x1) - std::max(l.x_at(t[m]), x0));
+                if (m > 0) area += (prev_len + len) / 2 * (t[m] - t[m-1]);
+                prev_len = len;
+            }
+        }
+    }
+    return area;
 }
 
 Polygons
@@ -303,4 +471,69 @@ BridgeDetector::unsupported_edges(double angle) const
     */
 }
 
+size_t
+BridgeAngleCache::_hash(const BridgeDetector &bd)
+{
+    uint64_t seed = GeometryHash::SEED;
+    GeometryHash::combine(seed, uint64_t(bd.extrusion_width));
+    GeometryHash::combine(seed, bd.resolution);
+    GeometryHash::combine(seed, bd.expolygon);
+    GeometryHash::combine(seed, bd._anchors);
+    GeometryHash::combine(seed, uint64_t(bd._edges.size()));
+    for (const Polyline &edge : bd._edges)
+        GeometryHash::combine(seed, edge.points);
+    return size_t(seed);
+}
+
+bool
+BridgeAngleCache::_matches(const Key &key, const BridgeDetector &bd)
+{
+    if (key.extrusion_width != bd.extrusion_width
+        || key.resolution != bd.resolution
+        || key.edges.size() != bd._edges.size()
+        || !GeometryHash::equal(key.expolygon, bd.expolygon)
+        || !GeometryHash::equal(key.anchors, bd._anchors))
+        return false;
+    for (size_t i = 0; i < key.edges.size(); ++i)
+        if (key.edges[i].points != bd._edges[i].points) return false;
+    return true;
+}
+
+size_t
+BridgeAngleCache::_memory(const Key &key)
+{
+    size_t memory = sizeof(Key) + sizeof(double) + key.expolygon.contour.points.size() * sizeof(Point);
+    for (const Polygon &hole : key.expolygon.holes)
+        memory += sizeof(Polygon) + hole.points.size() * sizeof(Point);
+    for (const ExPolygon &anchor : key.anchors) {
+        memory += sizeof(ExPolygon) + anchor.contour.points.size() * sizeof(Point);
+        for (const Polygon &hole : anchor.holes)
+            memory += sizeof(Polygon) + hole.points.size() * sizeof(Point);
+    }
+    for (const Polyline &edge : key.edges)
+        memory += sizeof(Polyline) + edge.points.size() * sizeof(Point);
+    return memory;
+}
+
+bool
+BridgeAngleCache::find(const BridgeDetector &bd, double* angle)
+{
+    // guard against hash collisions by comparing the actual input
+    return this->_cache.find(_hash(bd), [&bd](const Key &key) { return _matches(key, bd); }, angle);
+}
+
+void
+BridgeAngleCache::store(const BridgeDetector &bd, double angle)
+{
+    Key key;
+    key.expolygon       = bd.expolygon;
+    key.anchors         = bd._anchors;
+    key.edges           = bd._edges;
+    key.extrusion_width = bd.extrusion_width;
+    key.resolution      = bd.resolution;
+    const size_t memory = _memory(key);
+    this->_cache.store(_hash(bd), [&bd](const Key &key) { return _matches(key, bd); },
+        std::move(key), angle, memory);
+}
+
 }
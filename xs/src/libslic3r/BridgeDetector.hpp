@@ -4,11 +4,58 @@
 #include "libslic3r.h"
 #include "ExPolygon.hpp"
 #include "ExPolygonCollection.hpp"
+#include "ExPolygonGrid.hpp"
+#include "Cache.hpp"
 #include <string>
 
 namespace Slic3r {
 
+class BridgeDetector;
+
+/// Memoizes BridgeDetector::detect_angle() results.
+/// Stacked floors and repeated features produce the same bridge over the same
+/// anchors on many layers, so the angle search only runs the first time a given
+/// (bridge, anchors, supporting edges, extrusion width) combination is seen.
+/// The least recently used entries are evicted beyond max_memory().
+/// All methods are thread-safe.
+class BridgeAngleCache
+{
+    public:
+    /// Default memory budget for the cached results, in bytes.
+    static const size_t DEFAULT_MAX_MEMORY = 16 * 1024 * 1024;
+
+    struct Key {
+        ExPolygon expolygon;
+        ExPolygons anchors;
+        Polylines edges;
+        coord_t extrusion_width;
+        double resolution;
+    };
+    typedef LRUCache<Key, double>::Stats Stats;
+
+    explicit BridgeAngleCache(size_t max_memory = DEFAULT_MAX_MEMORY)
+        : _cache(max_memory) {};
+
+    /// Looks up the angle detected for an identical bridge; -1 is a valid
+    /// cached result meaning that no direction was found.
+    bool find(const BridgeDetector &bd, double* angle);
+    void store(const BridgeDetector &bd, double angle);
+    Stats stats() const { return this->_cache.stats(); };
+    void clear() { this->_cache.clear(); };
+    size_t max_memory() const { return this->_cache.max_memory(); };
+    void set_max_memory(size_t max_memory) { this->_cache.set_max_memory(max_memory); };
+
+    private:
+    LRUCache<Key, double> _cache;
+
+    static size_t _hash(const BridgeDetector &bd);
+    static size_t _memory(const Key &key);
+    static bool _matches(const Key &key, const BridgeDetector &bd);
+};
+
 class BridgeDetector {
+    friend class BridgeAngleCache;
+
 public:
     /// The non-grown hole.
     ExPolygon expolygon;
@@ -20,6 +67,10 @@ public:
     double resolution;
     /// The final optimal angle.
     double angle;
+    /// Maximum number of threads used to score the candidate angles.
+    int threads;
+    /// Optional memoization of the detected angles, shared between layers.
+    BridgeAngleCache* cache;
     
     BridgeDetector(const ExPolygon &_expolygon, const ExPolygonCollection &_lower_slices, coord_t _extrusion_width);
     bool detect_angle();
@@ -36,6 +87,16 @@ private:
     /// Closed polygons representing the supporting areas.
     ExPolygons _anchors;
     
+    /// Edge of the clip area in the frame rotated for a candidate angle,
+    /// oriented so that y0 < y1.
+    struct RotatedEdge {
+        double y0, y1;
+        double x0;      ///< x at y0
+        double dxdy;
+        int winding;
+        double x_at(double y) const { return this->x0 + (y - this->y0) * this->dxdy; };
+    };
+    
     class BridgeDirection {
         public:
         BridgeDirection(double a = -1.) : angle(a), coverage(0.), max_length(0.) {}
@@ -48,6 +109,12 @@ private:
         double coverage;
         double max_length;
     };
+    
+    double _detect_angle() const;
+    void _evaluate_candidate(size_t i, const Polygons* clip_area, const ExPolygonGrid* anchors,
+        std::vector<BridgeDirection>* candidates) const;
+    static double _clipped_area(const std::vector<RotatedEdge> &edges, const std::vector<size_t> &bucket,
+        double x0, double x1, double y0, double y1);
 };
 
 }
@@ -0,0 +1,177 @@
+#ifndef slic3r_Cache_hpp_
+#define slic3r_Cache_hpp_
+
+#include "libslic3r.h"
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <boost/thread.hpp>
+
+namespace Slic3r {
+
+/// Memory-bounded map keeping the most recently used results of an expensive
+/// computation. Entries are looked up by a hash of their input and confirmed
+/// by a caller-supplied comparison against the stored key, so that hash
+/// collisions never return a wrong result and lookups don't need to build a
+/// key. The least recently used entries are evicted beyond max_memory().
+/// All methods are thread-safe.
+template <class Key, class Value>
+class LRUCache
+{
+    public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t entries;
+        size_t memory;      ///< estimated bytes held by the cached entries
+        Stats() : hits(0), misses(0), evictions(0), entries(0), memory(0) {};
+        double hit_rate() const {
+            return (hits + misses) == 0 ? 0. : double(hits) / double(hits + misses);
+        };
+    };
+
+    explicit LRUCache(size_t max_memory) : _max_memory(max_memory) {};
+
+    /// Copies the value stored for the key with the given hash for which
+    /// matches(key) is true into *value, and marks it as recently used.
+    template <class Match>
+    bool find(size_t hash, Match matches, Value* value);
+    /// Stores a value unless an entry matching its key was stored in the
+    /// meantime; memory is the estimated size of key and value in bytes.
+    template <class Match>
+    void store(size_t hash, Match matches, Key key, Value value, size_t memory);
+    Stats stats() const;
+    void clear();
+    size_t max_memory() const { return this->_max_memory; };
+    void set_max_memory(size_t max_memory);
+
+    private:
+    struct Entry {
+        size_t hash;
+        Key key;
+        Value value;
+        size_t memory;
+    };
+    typedef std::list<Entry> Entries;
+
+    size_t _max_memory;
+    /// Most recently used entries are kept at the front.
+    Entries _entries;
+    std::unordered_multimap<size_t, typename Entries::iterator> _index;
+    Stats _stats;
+    mutable boost::mutex _mutex;
+
+    template <class Match>
+    typename Entries::iterator _find(size_t hash, Match matches);
+    void _evict();
+
+    // non-copyable
+    LRUCache(const LRUCache&);
+    LRUCache& operator=(const LRUCache&);
+};
+
+template <class Key, class Value>
+template <class Match>
+typename LRUCache<Key,Value>::Entries::iterator
+LRUCache<Key,Value>::_find(size_t hash, Match matches)
+{
+    auto range = this->_index.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+        if (matches(it->second->key))
+            return it->second;
+    return this->_entries.end();
+}
+
+template <class Key, class Value>
+void
+LRUCache<Key,Value>::_evict()
+{
+    while (this->_stats.memory > this->_max_memory && !this->_entries.empty()) {
+        typename Entries::iterator last = std::prev(this->_entries.end());
+        auto range = this->_index.equal_range(last->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                this->_index.erase(it);
+                break;
+            }
+        }
+        this->_stats.memory -= last->memory;
+        this->_stats.entries--;
+        this->_stats.evictions++;
+        this->_entries.erase(last);
+    }
+}
+
+template <class Key, class Value>
+template <class Match>
+bool
+LRUCache<Key,Value>::find(size_t hash, Match matches, Value* value)
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    typename Entries::iterator it = this->_find(hash, matches);
+    if (it == this->_entries.end()) {
+        this->_stats.misses++;
+        return false;
+    }
+    this->_entries.splice(this->_entries.begin(), this->_entries, it);
+    this->_stats.hits++;
+    *value = it->value;
+    return true;
+}
+
+template <class Key, class Value>
+template <class Match>
+void
+LRUCache<Key,Value>::store(size_t hash, Match matches, Key key, Value value, size_t memory)
+{
+    // don't bother caching values that would evict everything else
+    if (memory > this->_max_memory) return;
+
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    // concurrent misses on the same input compute it more than once
+    if (this->_find(hash, matches) != this->_entries.end()) return;
+
+    Entry entry;
+    entry.hash      = hash;
+    entry.key       = std::move(key);
+    entry.value     = std::move(value);
+    entry.memory    = memory;
+    this->_stats.memory += memory;
+    this->_stats.entries++;
+    this->_entries.push_front(std::move(entry));
+    this->_index.insert(std::make_pair(hash, this->_entries.begin()));
+    this->_evict();
+}
+
+template <class Key, class Value>
+typename LRUCache<Key,Value>::Stats
+LRUCache<Key,Value>::stats() const
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    return this->_stats;
+}
+
+template <class Key, class Value>
+void
+LRUCache<Key,Value>::clear()
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    this->_entries.clear();
+    this->_index.clear();
+    this->_stats = Stats();
+}
+
+template <class Key, class Value>
+void
+LRUCache<Key,Value>::set_max_memory(size_t max_memory)
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    this->_max_memory = max_memory;
+    this->_evict();
+}
+
+}
+
+#endif
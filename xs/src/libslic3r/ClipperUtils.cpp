@@ -1,5 +1,7 @@
 #include "ClipperUtils.hpp"
 #include "Geometry.hpp"
+#include <map>
+#include <boost/bind.hpp>
 
 namespace Slic3r {
 
@@ -35,8 +37,9 @@ T
 ClipperPath_to_Slic3rMultiPoint(const ClipperLib::Path &input)
 {
     T retval;
+    retval.points.reserve(input.size());
     for (ClipperLib::Path::const_iterator pit = input.begin(); pit != input.end(); ++pit)
-        retval.points.push_back(Point( (*pit).X, (*pit).Y ));
+        retval.points.emplace_back((*pit).X, (*pit).Y);
     return retval;
 }
 template Polygon ClipperPath_to_Slic3rMultiPoint<Polygon>(const ClipperLib::Path &input);
@@ -46,6 +49,7 @@ T
 ClipperPaths_to_Slic3rMultiPoints(const ClipperLib::Paths &input)
 {
     T retval;
+    retval.reserve(input.size());
     for (ClipperLib::Paths::const_iterator it = input.begin(); it != input.end(); ++it)
         retval.push_back(ClipperPath_to_Slic3rMultiPoint<typename T::value_type>(*it));
     return retval;
@@ -71,8 +75,43 @@ ClipperLib::Path
 Slic3rMultiPoint_to_ClipperPath(const MultiPoint &input)
 {
     ClipperLib::Path retval;
+    retval.reserve(input.points.size());
     for (Points::const_iterator pit = input.points.begin(); pit != input.points.end(); ++pit)
-        retval.push_back(ClipperLib::IntPoint( (*pit).x, (*pit).y ));
+        retval.emplace_back((*pit).x, (*pit).y);
+    return retval;
+}
+
+void
+Slic3rExPolygon_to_ClipperPaths(const ExPolygon &input, ClipperLib::Paths* output)
+{
+    output->push_back(Slic3rMultiPoint_to_ClipperPath(input.contour));
+    for (const Polygon &hole : input.holes)
+        output->push_back(Slic3rMultiPoint_to_ClipperPath(hole));
+}
+
+ClipperLib::Paths
+Slic3rExPolygons_to_ClipperPaths(const ExPolygons &input)
+{
+    size_t n = 0;
+    for (const ExPolygon &expolygon : input)
+        n += expolygon.holes.size() + 1;
+    ClipperLib::Paths retval;
+    retval.reserve(n);
+    for (const ExPolygon &expolygon : input)
+        Slic3rExPolygon_to_ClipperPaths(expolygon, &retval);
+    return retval;
+}
+
+ClipperLib::Paths
+Slic3rExPolygons_to_ClipperPaths(const Surfaces &input)
+{
+    size_t n = 0;
+    for (const Surface &surface : input)
+        n += surface.expolygon.holes.size() + 1;
+    ClipperLib::Paths retval;
+    retval.reserve(n);
+    for (const Surface &surface : input)
+        Slic3rExPolygon_to_ClipperPaths(surface.expolygon, &retval);
     return retval;
 }
 
@@ -80,9 +119,31 @@ template <class T>
 ClipperLib::Paths
 Slic3rMultiPoints_to_ClipperPaths(const T &input)
 {
-    ClipperLib::Paths retval;
-    for (typename T::const_iterator it = input.begin(); it != input.end(); ++it)
-        retval.push_back(Slic3rMultiPoint_to_ClipperPath(*it));
+    ClipperLib::Paths retval(input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        const Points &points = input[i].points;
+        ClipperLib::Path &path = retval[i];
+        path.reserve(points.size());
+        for (Points::const_iterator pit = points.begin(); pit != points.end(); ++pit)
+            path.emplace_back((*pit).x, (*pit).y);
+    }
+    return retval;
+}
+
+// Same as Slic3rMultiPoints_to_ClipperPaths() followed by scaleClipperPolygons(),
+// in a single pass over the input.
+template <class T>
+static ClipperLib::Paths
+_scaled_clipper_paths(const T &input, const double scale)
+{
+    ClipperLib::Paths retval(input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        const Points &points = input[i].points;
+        ClipperLib::Path &path = retval[i];
+        path.reserve(points.size());
+        for (Points::const_iterator pit = points.begin(); pit != points.end(); ++pit)
+            path.emplace_back(ClipperLib::cInt((*pit).x * scale), ClipperLib::cInt((*pit).y * scale));
+    }
     return retval;
 }
 
@@ -101,11 +162,8 @@ ClipperLib::Paths
 _offset(const Polygons &polygons, const float delta,
     double scale, ClipperLib::JoinType joinType, double miterLimit)
 {
-    // read input
-    ClipperLib::Paths input = Slic3rMultiPoints_to_ClipperPaths(polygons);
-    
-    // scale input
-    scaleClipperPolygons(input, scale);
+    // read and scale input
+    ClipperLib::Paths input = _scaled_clipper_paths(polygons, scale);
     
     // perform offset
     ClipperLib::ClipperOffset co;
@@ -127,11 +185,8 @@ ClipperLib::Paths
 _offset(const Polylines &polylines, const float delta,
     double scale, ClipperLib::JoinType joinType, double miterLimit)
 {
-    // read input
-    ClipperLib::Paths input = Slic3rMultiPoints_to_ClipperPaths(polylines);
-    
-    // scale input
-    scaleClipperPolygons(input, scale);
+    // read and scale input
+    ClipperLib::Paths input = _scaled_clipper_paths(polylines, scale);
     
     // perform offset
     ClipperLib::ClipperOffset co;
@@ -207,16 +262,13 @@ offset_ex(const ExPolygons &expolygons, const float delta,
     return offset_ex(to_polygons(expolygons), delta, scale, joinType, miterLimit);
 }
 
-ClipperLib::Paths
-_offset2(const Polygons &polygons, const float delta1, const float delta2,
-    const double scale, const ClipperLib::JoinType joinType, const double miterLimit)
+// Both offsets of _offset2() on scaled input, leaving the output scaled.
+// The result of the first offset is stored in output1 if not NULL.
+static ClipperLib::Paths
+_offset2_scaled(const ClipperLib::Paths &input, const float delta1, const float delta2,
+    const double scale, const ClipperLib::JoinType joinType, const double miterLimit,
+    ClipperLib::Paths* output1 = NULL)
 {
-    // read input
-    ClipperLib::Paths input = Slic3rMultiPoints_to_ClipperPaths(polygons);
-    
-    // scale input
-    scaleClipperPolygons(input, scale);
-    
     // prepare ClipperOffset object
     ClipperLib::ClipperOffset co;
     if (joinType == jtRound) {
@@ -226,15 +278,27 @@ _offset2(const Polygons &polygons, const float delta1, const float delta2,
     }
     
     // perform first offset
-    ClipperLib::Paths output1;
+    ClipperLib::Paths first;
+    if (output1 == NULL) output1 = &first;
     co.AddPaths(input, joinType, ClipperLib::etClosedPolygon);
-    co.Execute(output1, (delta1*scale));
+    co.Execute(*output1, (delta1*scale));
     
     // perform second offset
     co.Clear();
-    co.AddPaths(output1, joinType, ClipperLib::etClosedPolygon);
+    co.AddPaths(*output1, joinType, ClipperLib::etClosedPolygon);
     ClipperLib::Paths retval;
     co.Execute(retval, (delta2*scale));
+    return retval;
+}
+
+ClipperLib::Paths
+_offset2(const Polygons &polygons, const float delta1, const float delta2,
+    const double scale, const ClipperLib::JoinType joinType, const double miterLimit)
+{
+    // read and scale input
+    ClipperLib::Paths input = _scaled_clipper_paths(polygons, scale);
+    
+    ClipperLib::Paths retval = _offset2_scaled(input, delta1, delta2, scale, joinType, miterLimit);
     
     // unscale output
     scaleClipperPolygons(retval, 1/scale);
@@ -263,15 +327,190 @@ offset2_ex(const Polygons &polygons, const float delta1, const float delta2,
     return ClipperPaths_to_Slic3rExPolygons(output);
 }
 
+static void
+_translate(ClipperLib::Paths* paths, ClipperLib::cInt dx, ClipperLib::cInt dy)
+{
+    for (ClipperLib::Path &path : *paths)
+        for (ClipperLib::IntPoint &p : path) {
+            p.X += dx;
+            p.Y += dy;
+        }
+}
+
+static void
+_merge_bounds(const ClipperLib::Paths &paths, ClipperLib::IntRect* rect)
+{
+    for (const ClipperLib::Path &path : paths)
+        for (const ClipperLib::IntPoint &p : path) {
+            rect->left   = std::min(rect->left,   p.X);
+            rect->top    = std::min(rect->top,    p.Y);
+            rect->right  = std::max(rect->right,  p.X);
+            rect->bottom = std::max(rect->bottom, p.Y);
+        }
+}
+
+// State of offset2_copies(), shared by its worker threads.
+struct Offset2CopiesContext
+{
+    std::vector<ClipperLib::Paths>  input;      ///< scaled polygons of each object
+    const std::vector<Points>*      copies;
+    const std::vector<std::pair<float,float> >* deltas;
+    double                          scale;
+    ClipperLib::JoinType            joinType;
+    double                          miterLimit;
+
+    /// offsets of each object by each pair of deltas, and their bounds
+    /// along with the ones of the input, at object * deltas->size() + delta
+    std::vector<ClipperLib::Paths>  offsets;
+    std::vector<ClipperLib::IntRect> bounds;
+
+    /// copies offset together, as (object, copy) pairs
+    struct Cluster {
+        size_t delta;
+        std::vector<std::pair<size_t,size_t> > copies;
+        ClipperLib::Paths output;
+    };
+    std::vector<Cluster> clusters;
+
+    void offset_object(size_t idx);
+    void make_clusters(size_t delta);
+    void offset_cluster(size_t idx);
+};
+
+void
+Offset2CopiesContext::offset_object(size_t idx)
+{
+    const size_t object = idx / this->deltas->size();
+    const std::pair<float,float> &delta = (*this->deltas)[idx % this->deltas->size()];
+    ClipperLib::Paths output1;
+    this->offsets[idx] = _offset2_scaled(this->input[object], delta.first, delta.second,
+        this->scale, this->joinType, this->miterLimit, &output1);
+    _merge_bounds(this->input[object], &this->bounds[idx]);
+    _merge_bounds(output1, &this->bounds[idx]);
+}
+
+void
+Offset2CopiesContext::make_clusters(size_t delta)
+{
+    // copies with their bounds, sorted by left side
+    struct Item {
+        size_t object, copy;
+        ClipperLib::IntRect rect;
+    };
+    std::vector<Item> items;
+    for (size_t object = 0; object < this->input.size(); ++object) {
+        if (this->input[object].empty()) continue;
+        const ClipperLib::IntRect &rect = this->bounds[object * this->deltas->size() + delta];
+        for (size_t copy = 0; copy < (*this->copies)[object].size(); ++copy) {
+            const Point &shift = (*this->copies)[object][copy];
+            const ClipperLib::cInt dx = ClipperLib::cInt(shift.x * this->scale);
+            const ClipperLib::cInt dy = ClipperLib::cInt(shift.y * this->scale);
+            Item item = { object, copy, { rect.left + dx, rect.top + dy, rect.right + dx, rect.bottom + dy } };
+            items.push_back(item);
+        }
+    }
+    std::sort(items.begin(), items.end(),
+        [](const Item &a, const Item &b) { return a.rect.left < b.rect.left; });
+
+    // copies whose bounds touch are offset together
+    std::vector<size_t> parent(items.size());
+    for (size_t i = 0; i < items.size(); ++i) parent[i] = i;
+    const auto find = [&parent](size_t i) {
+        while (parent[i] != i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+    for (size_t i = 0; i < items.size(); ++i)
+        for (size_t j = i+1; j < items.size() && items[j].rect.left <= items[i].rect.right; ++j)
+            if (items[j].rect.top <= items[i].rect.bottom && items[i].rect.top <= items[j].rect.bottom)
+                parent[find(j)] = find(i);
+
+    std::map<size_t,size_t> cluster_of_root;
+    for (size_t i = 0; i < items.size(); ++i) {
+        const size_t root = find(i);
+        if (cluster_of_root.find(root) == cluster_of_root.end()) {
+            cluster_of_root[root] = this->clusters.size();
+            this->clusters.push_back(Cluster());
+            this->clusters.back().delta = delta;
+        }
+        this->clusters[cluster_of_root[root]].copies.push_back(std::make_pair(items[i].object, items[i].copy));
+    }
+}
+
+void
+Offset2CopiesContext::offset_cluster(size_t idx)
+{
+    Cluster &cluster = this->clusters[idx];
+    const auto shift = [this](size_t object, size_t copy) {
+        const Point &p = (*this->copies)[object][copy];
+        return std::make_pair(ClipperLib::cInt(p.x * this->scale), ClipperLib::cInt(p.y * this->scale));
+    };
+    if (cluster.copies.size() == 1) {
+        // a copy on its own gets the offsets of its object
+        const size_t object = cluster.copies.front().first;
+        cluster.output = this->offsets[object * this->deltas->size() + cluster.delta];
+        const std::pair<ClipperLib::cInt,ClipperLib::cInt> d = shift(object, cluster.copies.front().second);
+        _translate(&cluster.output, d.first, d.second);
+    } else {
+        ClipperLib::Paths input;
+        for (const std::pair<size_t,size_t> &copy : cluster.copies) {
+            ClipperLib::Paths paths = this->input[copy.first];
+            const std::pair<ClipperLib::cInt,ClipperLib::cInt> d = shift(copy.first, copy.second);
+            _translate(&paths, d.first, d.second);
+            input.insert(input.end(), paths.begin(), paths.end());
+        }
+        const std::pair<float,float> &delta = (*this->deltas)[cluster.delta];
+        cluster.output = _offset2_scaled(input, delta.first, delta.second,
+            this->scale, this->joinType, this->miterLimit);
+    }
+    scaleClipperPolygons(cluster.output, 1/this->scale);
+}
+
+Polygons
+offset2_copies(const std::vector<Polygons> &polygons, const std::vector<Points> &copies,
+    const std::vector<std::pair<float,float> > &deltas, const double scale,
+    const ClipperLib::JoinType joinType, const double miterLimit, int threads)
+{
+    Offset2CopiesContext ctx;
+    ctx.copies      = &copies;
+    ctx.deltas      = &deltas;
+    ctx.scale       = scale;
+    ctx.joinType    = joinType;
+    ctx.miterLimit  = miterLimit;
+    for (const Polygons &p : polygons)
+        ctx.input.push_back(_scaled_clipper_paths(p, scale));
+    if (ctx.input.empty() || deltas.empty()) return Polygons();
+
+    const ClipperLib::IntRect empty = { ClipperLib::hiRange, ClipperLib::hiRange, -ClipperLib::hiRange, -ClipperLib::hiRange };
+    ctx.offsets.resize(ctx.input.size() * deltas.size());
+    ctx.bounds.assign(ctx.offsets.size(), empty);
+    parallelize<size_t>(
+        0,
+        ctx.offsets.size()-1,
+        boost::bind(&Offset2CopiesContext::offset_object, &ctx, _1),
+        threads
+    );
+
+    for (size_t delta = 0; delta < deltas.size(); ++delta)
+        ctx.make_clusters(delta);
+    if (ctx.clusters.empty()) return Polygons();
+    parallelize<size_t>(
+        0,
+        ctx.clusters.size()-1,
+        boost::bind(&Offset2CopiesContext::offset_cluster, &ctx, _1),
+        threads
+    );
+
+    Polygons retval;
+    for (const Offset2CopiesContext::Cluster &cluster : ctx.clusters)
+        append_to(retval, ClipperPaths_to_Slic3rMultiPoints<Polygons>(cluster.output));
+    return retval;
+}
+
 template <class T>
 T
-_clipper_do(const ClipperLib::ClipType clipType, const Polygons &subject, 
-    const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
+_clipper_do(const ClipperLib::ClipType clipType, ClipperLib::Paths input_subject, 
+    ClipperLib::Paths input_clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
-    
     // perform safety offset
     if (safety_offset_) {
         if (clipType == ClipperLib::ctUnion) {
@@ -294,6 +533,17 @@ _clipper_do(const ClipperLib::ClipType clipType, const Polygons &subject,
     clipper.Execute(clipType, retval, fillType, fillType);
     return retval;
 }
+template ClipperLib::Paths _clipper_do<ClipperLib::Paths>(const ClipperLib::ClipType clipType, ClipperLib::Paths input_subject, 
+    ClipperLib::Paths input_clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_);
+
+template <class T>
+T
+_clipper_do(const ClipperLib::ClipType clipType, const Polygons &subject, 
+    const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
+{
+    return _clipper_do<T>(clipType, Slic3rMultiPoints_to_ClipperPaths(subject),
+        Slic3rMultiPoints_to_ClipperPaths(clip), fillType, safety_offset_);
+}
 
 // The Clipper library has difficulties processing overlapping polygons.
 // Namely, the function Clipper::JoinCommonEdges() has potentially a terrible time complexity if the output
@@ -301,13 +551,10 @@ _clipper_do(const ClipperLib::ClipType clipType, const Polygons &subject,
 // This function implements a following workaround:
 // 1) Peform the Clipper operation with the output to Paths. This method handles overlaps in a reasonable time.
 // 2) Run Clipper Union once again to extract the PolyTree from the result of 1).
-inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType clipType, const Polygons &subject, 
-    const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
+ClipperLib::PolyTree
+_clipper_do_polytree2(const ClipperLib::ClipType clipType, ClipperLib::Paths input_subject, 
+    ClipperLib::Paths input_clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
-    
     // perform safety offset
     if (safety_offset_) {
         if (clipType == ClipperLib::ctUnion) {
@@ -332,6 +579,13 @@ inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType cli
     return retval;
 }
 
+inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType clipType, const Polygons &subject, 
+    const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
+{
+    return _clipper_do_polytree2(clipType, Slic3rMultiPoints_to_ClipperPaths(subject),
+        Slic3rMultiPoints_to_ClipperPaths(clip), fillType, safety_offset_);
+}
+
 ClipperLib::PolyTree
 _clipper_do(const ClipperLib::ClipType clipType, const Polylines &subject, 
     const Polygons &clip, const ClipperLib::PolyFillType fillType,
@@ -370,16 +624,25 @@ _clipper(ClipperLib::ClipType clipType, const Polygons &subject,
 }
 
 ExPolygons
-_clipper_ex(ClipperLib::ClipType clipType, const Polygons &subject, 
-    const Polygons &clip, bool safety_offset_)
+_clipper_ex(ClipperLib::ClipType clipType, ClipperLib::Paths subject, 
+    ClipperLib::Paths clip, bool safety_offset_)
 {
     // perform operation
-    ClipperLib::PolyTree polytree = _clipper_do_polytree2(clipType, subject, clip, ClipperLib::pftNonZero, safety_offset_);
+    ClipperLib::PolyTree polytree = _clipper_do_polytree2(clipType, std::move(subject), std::move(clip),
+        ClipperLib::pftNonZero, safety_offset_);
     
     // convert into ExPolygons
     return PolyTreeToExPolygons(polytree);
 }
 
+ExPolygons
+_clipper_ex(ClipperLib::ClipType clipType, const Polygons &subject, 
+    const Polygons &clip, bool safety_offset_)
+{
+    return _clipper_ex(clipType, Slic3rMultiPoints_to_ClipperPaths(subject),
+        Slic3rMultiPoints_to_ClipperPaths(clip), safety_offset_);
+}
+
 Polylines
 _clipper_pl(ClipperLib::ClipType clipType, const Polylines &subject, 
     const Polygons &clip, bool safety_offset_)
@@ -31,6 +31,10 @@ void PolyTreeToExPolygons(ClipperLib::PolyTree& polytree, Slic3r::ExPolygons& ex
 ClipperLib::Path Slic3rMultiPoint_to_ClipperPath(const Slic3r::MultiPoint &input);
 template <class T>
 ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const T &input);
+// Contours and holes, in the same order as to_polygons().
+void Slic3rExPolygon_to_ClipperPaths(const Slic3r::ExPolygon &input, ClipperLib::Paths* output);
+ClipperLib::Paths Slic3rExPolygons_to_ClipperPaths(const Slic3r::ExPolygons &input);
+ClipperLib::Paths Slic3rExPolygons_to_ClipperPaths(const Slic3r::Surfaces &input);
 template <class T>
 T ClipperPath_to_Slic3rMultiPoint(const ClipperLib::Path &input);
 template <class T>
@@ -75,10 +79,29 @@ Slic3r::ExPolygons offset2_ex(const Slic3r::Polygons &polygons, const float delt
     const float delta2, double scale = CLIPPER_OFFSET_SCALE, ClipperLib::JoinType joinType = ClipperLib::jtMiter, 
     double miterLimit = 3);
 
+// offset2() of the polygons of each object translated to each of its copies,
+// for each pair of deltas in turn. Each object is offset once and translated
+// to its copies; only the copies whose offsets get close to each other are
+// offset together. Objects, then clusters of copies, are offset in parallel.
+Slic3r::Polygons offset2_copies(const std::vector<Slic3r::Polygons> &polygons,
+    const std::vector<Slic3r::Points> &copies, const std::vector<std::pair<float,float> > &deltas,
+    double scale = CLIPPER_OFFSET_SCALE, ClipperLib::JoinType joinType = ClipperLib::jtMiter, 
+    double miterLimit = 3, int threads = boost::thread::hardware_concurrency());
+
 template <class T>
 T _clipper_do(ClipperLib::ClipType clipType, const Slic3r::Polygons &subject, 
     const Slic3r::Polygons &clip, const ClipperLib::PolyFillType fillType, bool safety_offset_ = false);
 
+// Variants working on Clipper paths, used to chain several operations without
+// converting the intermediate results back to Slic3r polygons.
+template <class T>
+T _clipper_do(ClipperLib::ClipType clipType, ClipperLib::Paths subject, 
+    ClipperLib::Paths clip, const ClipperLib::PolyFillType fillType, bool safety_offset_ = false);
+ClipperLib::PolyTree _clipper_do_polytree2(ClipperLib::ClipType clipType, ClipperLib::Paths subject, 
+    ClipperLib::Paths clip, const ClipperLib::PolyFillType fillType, bool safety_offset_ = false);
+Slic3r::ExPolygons _clipper_ex(ClipperLib::ClipType clipType,
+    ClipperLib::Paths subject, ClipperLib::Paths clip, bool safety_offset_ = false);
+
 ClipperLib::PolyTree _clipper_do(ClipperLib::ClipType clipType, const Slic3r::Polylines &subject, 
     const Slic3r::Polygons &clip, const ClipperLib::PolyFillType fillType, bool safety_offset_ = false);
 
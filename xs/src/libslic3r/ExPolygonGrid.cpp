@@ -0,0 +1,63 @@
+#include "ExPolygonGrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Slic3r {
+
+ExPolygonGrid::ExPolygonGrid(const ExPolygons &expolygons, coord_t cell_size)
+    : _expolygons(&expolygons), _cell_size(cell_size), _columns(0), _rows(0)
+{
+    if (expolygons.empty()) return;
+
+    this->_bboxes.reserve(expolygons.size());
+    for (ExPolygons::const_iterator it = expolygons.begin(); it != expolygons.end(); ++it) {
+        this->_bboxes.push_back(it->bounding_box());
+        this->_bbox.merge(this->_bboxes.back());
+    }
+
+    const Point size = this->_bbox.size();
+    if (this->_cell_size <= 0) {
+        // aim at a few cells per ExPolygon, but don't let the grid grow unbounded
+        const double area = std::max(1., double(size.x) * double(size.y));
+        this->_cell_size = (coord_t)std::sqrt(area / (4. * expolygons.size()));
+    }
+    this->_cell_size = std::max(this->_cell_size, std::max(size.x, size.y) / 1024 + 1);
+    this->_columns   = size.x / this->_cell_size + 1;
+    this->_rows      = size.y / this->_cell_size + 1;
+    this->_cells.resize(this->_columns * this->_rows);
+
+    for (size_t i = 0; i < this->_bboxes.size(); ++i) {
+        const BoundingBox &bb = this->_bboxes[i];
+        const size_t c0 = this->_cell_coord(bb.min.x, this->_bbox.min.x, this->_columns);
+        const size_t c1 = this->_cell_coord(bb.max.x, this->_bbox.min.x, this->_columns);
+        const size_t r0 = this->_cell_coord(bb.min.y, this->_bbox.min.y, this->_rows);
+        const size_t r1 = this->_cell_coord(bb.max.y, this->_bbox.min.y, this->_rows);
+        for (size_t r = r0; r <= r1; ++r)
+            for (size_t c = c0; c <= c1; ++c)
+                this->_cells[r * this->_columns + c].push_back(i);
+    }
+}
+
+size_t
+ExPolygonGrid::_cell_coord(coord_t value, coord_t min, size_t count) const
+{
+    return std::min(count - 1, size_t((value - min) / this->_cell_size));
+}
+
+int
+ExPolygonGrid::find(const Point &point) const
+{
+    if (this->_cells.empty() || !this->_bbox.contains(point)) return -1;
+
+    const std::vector<size_t> &cell = this->_cells[
+        this->_cell_coord(point.y, this->_bbox.min.y, this->_rows) * this->_columns
+        + this->_cell_coord(point.x, this->_bbox.min.x, this->_columns)
+    ];
+    for (std::vector<size_t>::const_iterator i = cell.begin(); i != cell.end(); ++i) {
+        if (this->_bboxes[*i].contains(point) && (*this->_expolygons)[*i].contains(point))
+            return *i;
+    }
+    return -1;
+}
+
+}
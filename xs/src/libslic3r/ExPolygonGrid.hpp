@@ -0,0 +1,41 @@
+#ifndef slic3r_ExPolygonGrid_hpp_
+#define slic3r_ExPolygonGrid_hpp_
+
+#include "libslic3r.h"
+#include "BoundingBox.hpp"
+#include "ExPolygon.hpp"
+
+namespace Slic3r {
+
+/// Uniform grid over the bounding boxes of a set of ExPolygons, used to
+/// answer many point containment queries against the same set without
+/// testing every polygon.
+/// The grid only keeps a pointer to the indexed ExPolygons, so they must
+/// outlive it and must not be modified while it is in use.
+class ExPolygonGrid
+{
+    public:
+    ExPolygonGrid() : _expolygons(NULL), _cell_size(0), _columns(0), _rows(0) {};
+    /// If cell_size is 0, it is chosen so that each ExPolygon spans a few cells.
+    explicit ExPolygonGrid(const ExPolygons &expolygons, coord_t cell_size = 0);
+
+    /// Index of an ExPolygon containing the point, or -1.
+    int find(const Point &point) const;
+    bool contains(const Point &point) const { return this->find(point) != -1; };
+    const BoundingBox& bounding_box() const { return this->_bbox; };
+
+    private:
+    const ExPolygons* _expolygons;
+    std::vector<BoundingBox> _bboxes;
+    BoundingBox _bbox;
+    coord_t _cell_size;
+    size_t _columns, _rows;
+    /// ExPolygon indices overlapping each cell, in row-major order.
+    std::vector<std::vector<size_t> > _cells;
+
+    size_t _cell_coord(coord_t value, coord_t min, size_t count) const;
+};
+
+}
+
+#endif
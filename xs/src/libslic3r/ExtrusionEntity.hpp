@@ -127,6 +127,8 @@ class ExtrusionLoop : public ExtrusionEntity
     ExtrusionLoop(ExtrusionLoopRole role = elrDefault) : role(role) {};
     ExtrusionLoop(const ExtrusionPaths &paths, ExtrusionLoopRole role = elrDefault)
         : paths(paths), role(role) {};
+    ExtrusionLoop(ExtrusionPaths &&paths, ExtrusionLoopRole role = elrDefault)
+        : paths(std::move(paths)), role(role) {};
     ExtrusionLoop(const ExtrusionPath &path, ExtrusionLoopRole role = elrDefault)
         : role(role) {
         this->paths.push_back(path);
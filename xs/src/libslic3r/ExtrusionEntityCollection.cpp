@@ -11,6 +11,13 @@ ExtrusionEntityCollection::ExtrusionEntityCollection(const ExtrusionEntityCollec
     this->append(collection.entities);
 }
 
+ExtrusionEntityCollection::ExtrusionEntityCollection(ExtrusionEntityCollection &&collection)
+    : entities(std::move(collection.entities)), orig_indices(std::move(collection.orig_indices)),
+      no_sort(collection.no_sort)
+{
+    collection.entities.clear();
+}
+
 ExtrusionEntityCollection::ExtrusionEntityCollection(const ExtrusionPaths &paths)
     : no_sort(false)
 {
@@ -24,6 +31,13 @@ ExtrusionEntityCollection& ExtrusionEntityCollection::operator= (const Extrusion
     return *this;
 }
 
+ExtrusionEntityCollection& ExtrusionEntityCollection::operator= (ExtrusionEntityCollection &&other)
+{
+    this->clear();
+    this->swap(other);
+    return *this;
+}
+
 void
 ExtrusionEntityCollection::swap (ExtrusionEntityCollection &c)
 {
@@ -58,11 +72,8 @@ ExtrusionEntityCollection::operator ExtrusionPaths() const
 ExtrusionEntityCollection*
 ExtrusionEntityCollection::clone() const
 {
-    ExtrusionEntityCollection* coll = new ExtrusionEntityCollection(*this);
-    for (size_t i = 0; i < coll->entities.size(); ++i) {
-        coll->entities[i] = this->entities[i]->clone();
-    }
-    return coll;
+    // the copy constructor already clones the entities
+    return new ExtrusionEntityCollection(*this);
 }
 
 void
@@ -119,6 +130,52 @@ ExtrusionEntityCollection::append(const Polylines &polylines, const ExtrusionPat
     }
 }
 
+void
+ExtrusionEntityCollection::append(ExtrusionPath &&path)
+{
+    this->entities.push_back(new ExtrusionPath(std::move(path)));
+}
+
+void
+ExtrusionEntityCollection::append(ExtrusionLoop &&loop)
+{
+    this->entities.push_back(new ExtrusionLoop(std::move(loop)));
+}
+
+void
+ExtrusionEntityCollection::append(ExtrusionEntityCollection &&collection)
+{
+    this->entities.push_back(new ExtrusionEntityCollection(std::move(collection)));
+}
+
+void
+ExtrusionEntityCollection::append(ExtrusionPaths &&paths)
+{
+    this->entities.reserve(this->entities.size() + paths.size());
+    for (ExtrusionPath &path : paths)
+        this->entities.push_back(new ExtrusionPath(std::move(path)));
+    paths.clear();
+}
+
+void
+ExtrusionEntityCollection::append(Polylines &&polylines, const ExtrusionPath &templ)
+{
+    this->entities.reserve(this->entities.size() + polylines.size());
+    for (Polyline &polyline : polylines) {
+        ExtrusionPath *path = templ.clone();
+        path->polyline = std::move(polyline);
+        this->entities.push_back(path);
+    }
+    polylines.clear();
+}
+
+void
+ExtrusionEntityCollection::append(ExtrusionEntitiesPtr &&entities)
+{
+    this->entities.insert(this->entities.end(), entities.begin(), entities.end());
+    entities.clear();
+}
+
 void
 ExtrusionEntityCollection::replace(size_t i, const ExtrusionEntity &entity)
 {
@@ -227,7 +284,7 @@ ExtrusionEntityCollection::flatten(ExtrusionEntityCollection* retval) const
     for (ExtrusionEntitiesPtr::const_iterator it = this->entities.begin(); it != this->entities.end(); ++it) {
         if ((*it)->is_collection()) {
             ExtrusionEntityCollection* collection = dynamic_cast<ExtrusionEntityCollection*>(*it);
-            retval->append(collection->flatten().entities);
+            retval->append(std::move(collection->flatten().entities));
         } else {
             retval->append(**it);
         }
@@ -16,8 +16,10 @@ class ExtrusionEntityCollection : public ExtrusionEntity
     bool no_sort;
     ExtrusionEntityCollection(): no_sort(false) {};
     ExtrusionEntityCollection(const ExtrusionEntityCollection &collection);
+    ExtrusionEntityCollection(ExtrusionEntityCollection &&collection);
     ExtrusionEntityCollection(const ExtrusionPaths &paths);
     ExtrusionEntityCollection& operator= (const ExtrusionEntityCollection &other);
+    ExtrusionEntityCollection& operator= (ExtrusionEntityCollection &&other);
     ~ExtrusionEntityCollection();
     operator ExtrusionPaths() const;
     
@@ -36,6 +38,14 @@ class ExtrusionEntityCollection : public ExtrusionEntity
     void append(const ExtrusionEntitiesPtr &entities);
     void append(const ExtrusionPaths &paths);
     void append(const Polylines &polylines, const ExtrusionPath &templ);
+    /// The rvalue variants move the entities (and their points) instead of cloning them.
+    void append(ExtrusionPath &&path);
+    void append(ExtrusionLoop &&loop);
+    void append(ExtrusionEntityCollection &&collection);
+    void append(ExtrusionPaths &&paths);
+    void append(Polylines &&polylines, const ExtrusionPath &templ);
+    /// Takes ownership of the entities, leaving the source vector empty.
+    void append(ExtrusionEntitiesPtr &&entities);
     void replace(size_t i, const ExtrusionEntity &entity);
     void remove(size_t i);
     ExtrusionEntityCollection chained_path(bool no_reverse = false, std::vector<size_t>* orig_indices = NULL) const;
@@ -1,6 +1,8 @@
 #include <cassert>
 #include <math.h>
 #include <stdio.h>
+#include <map>
+#include <set>
 
 #include "../ClipperUtils.hpp"
 #include "../Geometry.hpp"
@@ -110,4 +112,148 @@ Fill::_infill_direction(const Surface &surface) const
     return direction_t(out_angle, out_shift);
 }
 
+// Clipper's cost grows quickly with the number of vertices, so a grid of cells
+// is first classified as inside, outside or close to the boundary: segments
+// far from the boundary are kept or dropped as they are, and only the runs of
+// segments close to it are clipped. The clipped pieces are then joined back to
+// the runs they were split from.
+Polylines
+Fill::_clip_dense(const Polylines &polylines, const ExPolygon &expolygon, coord_t cell_size)
+{
+    enum { csUnknown, csBoundary, csInside, csOutside };
+    typedef std::pair<coord_t,coord_t> Key;
+    
+    BoundingBox bb = expolygon.contour.bounding_box();
+    // keep the number of cells bounded for fine patterns over large surfaces
+    const coord_t cell = std::max(cell_size, std::max(bb.size().x, bb.size().y) / 1024 + 1);
+    // points outside of the grid are farther than a cell from the expolygon
+    bb.offset(2*cell);
+    const size_t columns = size_t((bb.max.x - bb.min.x) / cell) + 1;
+    const size_t rows    = size_t((bb.max.y - bb.min.y) / cell) + 1;
+    std::vector<char> cells(columns * rows, csUnknown);
+    
+    // Mark the cells crossed by the boundary along with their neighbors, so that
+    // a segment not longer than a cell starting in an unmarked cell can't reach
+    // the boundary.
+    const Polygons polygons = expolygon;
+    for (const Polygon &polygon : polygons) {
+        for (size_t i = 0; i < polygon.points.size(); ++i) {
+            const Point &a = polygon.points[i];
+            const Point &b = polygon.points[(i+1) % polygon.points.size()];
+            const size_t n = size_t(a.distance_to(b) / cell) + 1;
+            for (size_t k = 0; k < n; ++k) {
+                const Point p1(a.x + coord_t((b.x - a.x) * double(k) / n),   a.y + coord_t((b.y - a.y) * double(k) / n));
+                const Point p2(a.x + coord_t((b.x - a.x) * double(k+1) / n), a.y + coord_t((b.y - a.y) * double(k+1) / n));
+                const size_t x1 = size_t((std::min(p1.x, p2.x) - bb.min.x) / cell) - 1;
+                const size_t x2 = size_t((std::max(p1.x, p2.x) - bb.min.x) / cell) + 1;
+                const size_t y1 = size_t((std::min(p1.y, p2.y) - bb.min.y) / cell) - 1;
+                const size_t y2 = size_t((std::max(p1.y, p2.y) - bb.min.y) / cell) + 1;
+                for (size_t y = y1; y <= y2; ++y)
+                    std::fill(cells.begin() + y*columns + x1, cells.begin() + y*columns + x2 + 1, csBoundary);
+            }
+        }
+    }
+    
+    // the remaining connected areas are either fully inside or fully outside
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (cells[i] != csUnknown) continue;
+        const Point center(bb.min.x + coord_t(i % columns) * cell + cell/2, bb.min.y + coord_t(i / columns) * cell + cell/2);
+        const char state = expolygon.contains(center) ? csInside : csOutside;
+        cells[i] = state;
+        stack.push_back(i);
+        while (!stack.empty()) {
+            const size_t j = stack.back();
+            stack.pop_back();
+            const size_t x = j % columns;
+            if (x > 0           && cells[j-1] == csUnknown)       { cells[j-1] = state;       stack.push_back(j-1); }
+            if (x+1 < columns   && cells[j+1] == csUnknown)       { cells[j+1] = state;       stack.push_back(j+1); }
+            if (j >= columns    && cells[j-columns] == csUnknown) { cells[j-columns] = state; stack.push_back(j-columns); }
+            if (j+columns < cells.size() && cells[j+columns] == csUnknown) { cells[j+columns] = state; stack.push_back(j+columns); }
+        }
+    }
+    
+    // split the polylines into runs of segments sharing the same state
+    Polylines pieces, boundary_runs;
+    std::set<Key> joints;
+    Points pts;
+    std::vector<char> states;
+    for (const Polyline &polyline : polylines) {
+        // drop repeated vertices first, so that no run is made of a single point
+        pts.clear();
+        for (const Point &p : polyline.points)
+            if (pts.empty() || !p.coincides_with(pts.back()))
+                pts.push_back(p);
+        states.assign(pts.size(), csBoundary);
+        for (size_t i = 0; i+1 < pts.size(); ++i) {
+            const Point &p = pts[i];
+            if (std::abs(pts[i+1].x - p.x) > cell || std::abs(pts[i+1].y - p.y) > cell) continue;
+            states[i] = (p.x < bb.min.x || p.y < bb.min.y || p.x > bb.max.x || p.y > bb.max.y)
+                ? csOutside
+                : cells[size_t((p.y - bb.min.y) / cell) * columns + size_t((p.x - bb.min.x) / cell)];
+        }
+        for (size_t i = 0; i+1 < pts.size(); ) {
+            size_t j = i+1;
+            while (j+1 < pts.size() && states[j] == states[i]) ++j;
+            // segments i..j-1, from pts[i] to pts[j]
+            if (states[i] != csOutside) {
+                Polylines &out = (states[i] == csInside) ? pieces : boundary_runs;
+                out.push_back(Polyline());
+                out.back().points.assign(pts.begin() + i, pts.begin() + j + 1);
+                // runs next to an inside run meet it at a vertex which is inside
+                if (i > 0 && states[i-1] != csOutside && states[i-1] != states[i])
+                    joints.insert(Key(pts[i].x, pts[i].y));
+            }
+            i = j;
+        }
+    }
+    append_to(pieces, intersection_pl(boundary_runs, polygons));
+    
+    // join the pieces back at the vertices they were split at
+    std::map<Key,std::vector<size_t> > ends;   // piece*2 for the front, piece*2+1 for the back
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        const Point &front = pieces[i].points.front();
+        const Point &back  = pieces[i].points.back();
+        if (joints.count(Key(front.x, front.y))) ends[Key(front.x, front.y)].push_back(i*2);
+        if (joints.count(Key(back.x, back.y)))   ends[Key(back.x, back.y)].push_back(i*2+1);
+    }
+    // the end joined to the given one, or -1
+    auto joined = [&pieces, &ends](size_t end) -> long {
+        const Point &p = (end & 1) ? pieces[end/2].points.back() : pieces[end/2].points.front();
+        std::map<Key,std::vector<size_t> >::const_iterator it = ends.find(Key(p.x, p.y));
+        if (it == ends.end() || it->second.size() != 2) return -1;
+        return long(it->second[0] == end ? it->second[1] : it->second[0]);
+    };
+    Polylines result;
+    std::vector<bool> visited(pieces.size(), false);
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        if (visited[i]) continue;
+        // start from a free end of the chain
+        bool reversed;
+        if (joined(i*2) == -1)
+            reversed = false;
+        else if (joined(i*2+1) == -1)
+            reversed = true;
+        else
+            continue;
+        
+        result.push_back(Polyline());
+        Points &chain = result.back().points;
+        for (size_t current = i; ; ) {
+            visited[current] = true;
+            const Points &pts = pieces[current].points;
+            const size_t skip = chain.empty() ? 0 : 1;
+            if (reversed)
+                chain.insert(chain.end(), pts.rbegin() + skip, pts.rend());
+            else
+                chain.insert(chain.end(), pts.begin() + skip, pts.end());
+            const long next = joined(current*2 + (reversed ? 0 : 1));
+            if (next == -1 || visited[next/2]) break;
+            current  = next/2;
+            reversed = (next & 1) != 0;
+        }
+    }
+    return result;
+}
+
 } // namespace Slic3r
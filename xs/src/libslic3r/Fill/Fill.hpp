@@ -116,6 +116,10 @@ protected:
     };
 
     direction_t _infill_direction(const Surface &surface) const;
+    
+    // Same as intersection_pl(polylines, expolygon), for polylines made of many
+    // segments not longer than cell_size.
+    static Polylines _clip_dense(const Polylines &polylines, const ExPolygon &expolygon, coord_t cell_size);
 };
 
 } // namespace Slic3r
@@ -94,24 +94,29 @@ makeNormalisedGrid(coordf_t z, size_t gridWidth, size_t gridHeight, size_t curve
     bool printHoriz = (fabs(fmod(z, a)) / a*2. < 1);
 
     std::vector<Pointfs> points;
+    // the coordinates along the lines are the same for all of them
     if (printHoriz) {
+        const std::vector<coordf_t> colinear = colinearPoints(offset, 0, gridHeight);
+        points.reserve(gridWidth + 1);
         for (size_t x = 0; x <= gridWidth; ++x) {
             points.push_back(Pointfs());
             Pointfs &newPoints = points.back();
             newPoints = zip(
                 perpendPoints(offset, x, gridHeight),
-                colinearPoints(offset, 0, gridHeight));
+                colinear);
             // trim points to grid edges
             trim(newPoints, coordf_t(0.), coordf_t(0.), coordf_t(gridWidth), coordf_t(gridHeight));
             if (x & 1)
                 std::reverse(newPoints.begin(), newPoints.end());
         }
     } else {
+        const std::vector<coordf_t> colinear = colinearPoints(offset, 0, gridWidth);
+        points.reserve(gridHeight + 1);
         for (size_t y = 0; y <= gridHeight; ++y) {
             points.push_back(Pointfs());
             Pointfs &newPoints = points.back();
             newPoints = zip(
-                colinearPoints(offset, 0, gridWidth),
+                colinear,
                 perpendPoints(offset, y, gridWidth)
             );
             // trim points to grid edges
@@ -173,7 +178,7 @@ Fill3DHoneycomb::_fill_surface_single(
         it->translate(bb.min.x, bb.min.y);
 
     // clip pattern to boundaries
-    polylines = intersection_pl(polylines, (Polygons)expolygon);
+    polylines = _clip_dense(polylines, expolygon, distance);
 
     // connect lines
     if (!this->dont_connect && !polylines.empty()) { // prevent calling leftmost_point() on empty collections
@@ -4,18 +4,63 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <tuple>
+#include <boost/thread.hpp>
 
 #include "FillGyroid.hpp"
 
 namespace Slic3r {
 
-Polyline FillGyroid::makeLineVert(double xPos, double yPos, double width, double height, double currentXBegin, double segmentSize, coord_t scaleFactor, 
-        double zCs, double zSn, bool flip, double decal){
-    double maxSlope = abs(abs(zCs)-abs(zSn));
-    Polyline polyline;
-    polyline.points.push_back(Point(coord_t((std::max(std::min(currentXBegin, xPos+width),xPos) + decal) * scaleFactor), coord_t(yPos * scaleFactor)));
-    for(double y=yPos;y<yPos+height+segmentSize;y+=segmentSize){
-        if(y>yPos+height) y = yPos+height;
+/// number of slices kept in the cache: enough for all the layers being filled
+/// concurrently, each of them having a single z
+static const size_t GYROID_CACHE_SIZE = 64;
+
+std::shared_ptr<const GyroidCurves>
+GyroidCurves::get(coord_t gridZ, coord_t scaleFactor, double segmentSize, double length)
+{
+    typedef std::tuple<coord_t, coord_t, double> Key;
+    static boost::mutex mutex;
+    static std::map<Key, std::shared_ptr<const GyroidCurves> > cache;
+    
+    const Key key(gridZ, scaleFactor, segmentSize);
+    {
+        boost::lock_guard<boost::mutex> l(mutex);
+        auto it = cache.find(key);
+        if (it != cache.end() && it->second->positions.back() > length)
+            return it->second;
+    }
+    
+    // sample outside of the lock so that workers filling other layers don't wait
+    std::shared_ptr<GyroidCurves> curves(new GyroidCurves());
+    curves->gridZ       = gridZ;
+    curves->scaleFactor = scaleFactor;
+    curves->segmentSize = segmentSize;
+    double z = gridZ/(1.0 * scaleFactor);
+    curves->zSn = sin(z);
+    curves->zCs = cos(z);
+    curves->vertical = abs(curves->zSn)<=abs(curves->zCs);
+    // positions are accumulated the same way the lines walk along them,
+    // up to the first one past the requested length
+    for (double pos = 0; ; pos += segmentSize) {
+        curves->positions.push_back(pos);
+        curves->offsets[0].push_back(curves->offset(pos, false));
+        curves->offsets[1].push_back(curves->offset(pos, true));
+        if (pos > length) break;
+    }
+    
+    boost::lock_guard<boost::mutex> l(mutex);
+    if (cache.size() >= GYROID_CACHE_SIZE) cache.clear();
+    std::shared_ptr<const GyroidCurves> &cached = cache[key];
+    // another thread might have sampled a longer one in the meantime
+    if (!cached || cached->positions.back() < curves->positions.back())
+        cached = curves;
+    return curves;
+}
+
+double GyroidCurves::offset(double pos, bool flip) const
+{
+    if (this->vertical) {
+        double y = pos;
         double ySn = sin(y +(zCs<0?3.14:0) + 3.14);
         double yCs = cos(y +(zCs<0?3.14:0) + 3.14+(!flip?0:3.14));
 
@@ -23,35 +68,63 @@ Polyline FillGyroid::makeLineVert(double xPos, double yPos, double width, double
         double b = -zCs;
         double res = zSn*yCs;
         double r = sqrt(a*a + b*b);
-        double x = asin(a/r) + asin(res/r) +3.14;
+        return asin(a/r) + asin(res/r) +3.14;
+    } else {
+        double x = pos;
+        double xSn = sin(x +(zSn<0?3.14:0) +(flip?0:3.14));
+        double xCs = cos(x +(zSn<0?3.14:0) );
+        
+        double a = xCs;
+        double b = -zSn;
+        double res = zCs*xSn;
+        double r = sqrt(a*a + b*b);
+        return asin(a/r) + asin(res/r) +3.14/2;
+    }
+}
+
+Polyline FillGyroid::makeLineVert(const GyroidCurves &curves, double width, double height,
+        double currentXBegin, coord_t scaleFactor, bool flip){
+    double xPos = 0, yPos = 0;
+    Polyline polyline;
+    polyline.points.push_back(Point(coord_t(std::max(std::min(currentXBegin, xPos+width),xPos) * scaleFactor), coord_t(yPos * scaleFactor)));
+    for(size_t i = 0; i < curves.positions.size() && curves.positions[i] < yPos+height+curves.segmentSize; ++i){
+        double y = curves.positions[i];
+        double x;
+        if(y>yPos+height){
+            // the last sample is clamped to the grid edge
+            y = yPos+height;
+            x = curves.offset(y, flip);
+        } else {
+            x = curves.offsets[flip][i];
+        }
         x += currentXBegin;
         
-        double ydeviation = 0.5*(flip?-1:1)*(zSn>0?-1:1)*decal*(1-maxSlope)*(res/r - a/r);
-        polyline.points.push_back(Point(coord_t((std::max(std::min(x, xPos+width),xPos)+decal-ydeviation/2) * scaleFactor), coord_t((y + ydeviation) * scaleFactor)));
+        polyline.points.push_back(Point(coord_t(std::max(std::min(x, xPos+width),xPos) * scaleFactor), coord_t(y * scaleFactor)));
+        if(y == yPos+height) break;
     }
     
     return polyline;
 }
 
-Polyline FillGyroid::makeLineHori(double xPos, double yPos, double width, double height, double currentYBegin, double segmentSize, coord_t scaleFactor, 
-        double zCs, double zSn, bool flip, double decal){
-    double maxSlope = abs(abs(zCs)-abs(zSn));
+Polyline FillGyroid::makeLineHori(const GyroidCurves &curves, double width, double height,
+        double currentYBegin, coord_t scaleFactor, bool flip){
+    double xPos = 0, yPos = 0;
     Polyline polyline;
-    polyline.points.push_back(Point(coord_t(xPos * scaleFactor), coord_t((std::max(std::min(currentYBegin, yPos+height),yPos)+decal) * scaleFactor)));
-    for(double x=xPos;x<xPos+width+segmentSize;x+=segmentSize){
-        if(x>xPos+width) x = xPos+width;
-        double xSn = sin(x +(zSn<0?3.14:0) +(flip?0:3.14));
-        double xCs = cos(x +(zSn<0?3.14:0) );
-        
-        double a = xCs;
-        double b = -zSn;
-        double res = zCs*xSn;
-        double r = sqrt(a*a + b*b);
-        double y = asin(a/r) + asin(res/r) +3.14/2;
+    polyline.points.push_back(Point(coord_t(xPos * scaleFactor), coord_t(std::max(std::min(currentYBegin, yPos+height),yPos) * scaleFactor)));
+    for(size_t i = 0; i < curves.positions.size() && curves.positions[i] < xPos+width+curves.segmentSize; ++i){
+        double x = curves.positions[i];
+        double y;
+        if(x>xPos+width){
+            // the last sample is clamped to the grid edge
+            x = xPos+width;
+            y = curves.offset(x, flip);
+        } else {
+            y = curves.offsets[flip][i];
+        }
         y += currentYBegin;
         
-        double xdeviation = 0.5*(flip?-1:1)*(zCs>0?-1:1)*decal*(1-maxSlope)*(res/r - a/r);
-        polyline.points.push_back(Point(coord_t((x + xdeviation) * scaleFactor), coord_t((std::max(std::min(y, yPos+height),yPos)+decal-xdeviation/2) * scaleFactor)));
+        polyline.points.push_back(Point(coord_t(x * scaleFactor), coord_t(std::max(std::min(y, yPos+height),yPos) * scaleFactor)));
+        if(x == xPos+width) break;
     }
     
     return polyline;
@@ -72,20 +145,15 @@ Polylines FillGyroid::makeGrid(coord_t gridZ, double density, double layer_width
 {
     coord_t  scaleFactor = coord_t(scale_(layer_width) / density);
     Polylines result;
-    Polyline *polyline2;
     double segmentSize = density/2;
-    double decal = layer_width*density;
     double xPos = 0, yPos=0, width=gridWidth, height=gridHeight;
      //scale factor for 5% : 8 712 388
      // 1z = 10^-6 mm ?
-    double z = gridZ/(1.0 * scaleFactor);
-    double zSn = sin(z);
-    double zCs = cos(z);
-    
+    std::shared_ptr<const GyroidCurves> curves = GyroidCurves::get(gridZ, scaleFactor, segmentSize, std::max(width, height));
 
     int numLine = 0;
     
-    if(abs(zSn)<=abs(zCs)){
+    if(curves->vertical){
         //vertical
         //begin to first one
         int iter = 1;
@@ -96,7 +164,7 @@ Polylines FillGyroid::makeGrid(coord_t gridZ, double density, double layer_width
         // bool needNewLine =false;
         while(currentXBegin<xPos+width-PI/2){
             
-            correctOrderAndAdd(numLine, makeLineVert(xPos, yPos, width, height, currentXBegin, segmentSize, scaleFactor, zCs, zSn, flip, 0), result);
+            correctOrderAndAdd(numLine, makeLineVert(*curves, width, height, currentXBegin, scaleFactor, flip), result);
             numLine++;
             
             //then, return by the other side
@@ -106,7 +174,7 @@ Polylines FillGyroid::makeGrid(coord_t gridZ, double density, double layer_width
             
             if(currentXBegin < xPos+width-PI/2){
                 
-                correctOrderAndAdd(numLine, makeLineVert(xPos, yPos, width, height, currentXBegin, segmentSize, scaleFactor, zCs, zSn, flip, 0), result);
+                correctOrderAndAdd(numLine, makeLineVert(*curves, width, height, currentXBegin, scaleFactor, flip), result);
                 numLine++;
 
                 // relance
@@ -131,7 +199,7 @@ Polylines FillGyroid::makeGrid(coord_t gridZ, double density, double layer_width
         
         while(currentYBegin < yPos+width){
 
-            correctOrderAndAdd(numLine, makeLineHori(xPos, yPos, width, height, currentYBegin, segmentSize, scaleFactor, zCs, zSn, flip, 0), result);
+            correctOrderAndAdd(numLine, makeLineHori(*curves, width, height, currentYBegin, scaleFactor, flip), result);
             numLine++;
         
             //then, return by the other side
@@ -141,7 +209,7 @@ Polylines FillGyroid::makeGrid(coord_t gridZ, double density, double layer_width
             
             if(currentYBegin<yPos+width){
                 
-                correctOrderAndAdd(numLine, makeLineHori(xPos, yPos, width, height, currentYBegin, segmentSize, scaleFactor, zCs, zSn, flip, 0), result);
+                correctOrderAndAdd(numLine, makeLineHori(*curves, width, height, currentYBegin, scaleFactor, flip), result);
                 numLine++;
                 
                 //relance
@@ -183,7 +251,7 @@ void FillGyroid::_fill_surface_single(
     
 
     // clip pattern to boundaries
-    polylines = intersection_pl(polylines, (Polygons)expolygon);
+    polylines = _clip_dense(polylines, expolygon, distance);
 
     // connect lines
     if (! dont_connect && ! polylines.empty()) { // prevent calling leftmost_point() on empty collections
@@ -2,6 +2,7 @@
 #define slic3r_FillGyroid_hpp_
 
 #include <map>
+#include <memory>
 
 #include "../libslic3r.h"
 
@@ -9,6 +10,30 @@
 
 namespace Slic3r {
 
+/// Samples of the curves making up a horizontal slice of the gyroid.
+/// All the lines of a slice are the same curve shifted by multiples of PI
+/// (every other one flipped) and sampled at the same positions along the
+/// line, so the trigonometry only depends on the slice and is shared by all
+/// the lines, surfaces and layer regions at the same height.
+struct GyroidCurves
+{
+    coord_t gridZ;
+    coord_t scaleFactor;
+    double  segmentSize;
+    double  zSn, zCs;
+    /// true if the lines run along Y (for each y, compute x)
+    bool    vertical;
+    /// sample positions along the lines, in grid units, starting at 0
+    std::vector<double> positions;
+    /// offset of the curve across the line at each sample, for flip = false/true
+    std::vector<double> offsets[2];
+
+    /// Shared, thread-safe cache of the samples covering at least the given length.
+    static std::shared_ptr<const GyroidCurves> get(coord_t gridZ, coord_t scaleFactor, double segmentSize, double length);
+    /// Offset of the curve across the line at the given position.
+    double offset(double pos, bool flip) const;
+};
+
 class FillGyroid : public Fill
 {
 public:
@@ -37,15 +62,11 @@ protected:
     ///add line poly in reverse if needed into array
     inline void correctOrderAndAdd(const int num, Polyline poly, Polylines &array);
     ///create a curved horinzontal line  (for each x, compute y)
-    Polyline makeLineHori(double xPos, double yPos, double width, double height, 
-        double currentYBegin, double segmentSize, coord_t scaleFactor, 
-        double zCs, double zSn, 
-        bool flip, double decal=0);
+    Polyline makeLineHori(const GyroidCurves &curves, double width, double height,
+        double currentYBegin, coord_t scaleFactor, bool flip);
     ///create a curved vertival line (for each y, compute x)
-    Polyline makeLineVert(double xPos, double yPos, double width, double height, 
-        double currentXBegin, double segmentSize, coord_t scaleFactor, 
-        double zCs, double zSn, 
-        bool flip, double decal=0);
+    Polyline makeLineVert(const GyroidCurves &curves, double width, double height,
+        double currentXBegin, coord_t scaleFactor, bool flip);
 
 };
 
@@ -11,6 +11,7 @@
 #include "../Surface.hpp"
 #include <algorithm>
 #include <cmath>
+#include <unordered_map>
 
 #include "FillRectilinear.hpp"
 
@@ -63,7 +64,9 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
     }
     
     // Find all the polygons points intersecting the rectilinear vertical lines and store
-    // them in an std::map<> (grid) which orders them automatically by x and y.
+    // them in a flat array of nodes; a hash index on their coordinates lets us find
+    // the points we already stored. Once all of them are known they get sorted into
+    // per-scanline lists ordered by y, which is the order we walk them in.
     // For each intersection point we store its position (upper/lower): upper means it's
     // the upper endpoint of an intersection line, and vice versa.
     // Whenever between two intersection points we find vertices of the original polygon,
@@ -84,13 +87,31 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
         // (it doesn't contain *this but it contains the target intersection point)
         Points next;
         
-        IntersectionPoint() : Point() {};
-        IntersectionPoint(coord_t x, coord_t y, ipType _type) : Point(x,y), type(_type) {};
+        // Index of the scanline this point belongs to and of its neighbors along it
+        // (-1 if none); only set once the grid is complete.
+        long line, below, above;
+        
+        IntersectionPoint() : Point(), line(-1), below(-1), above(-1) {};
+        IntersectionPoint(coord_t x, coord_t y, ipType _type) : Point(x,y), type(_type), line(-1), below(-1), above(-1) {};
+    };
+    struct PointHash {
+        size_t operator()(const std::pair<coord_t,coord_t> &p) const {
+            return std::hash<coord_t>()(p.first) * 31 + std::hash<coord_t>()(p.second);
+        }
     };
-    typedef std::map<coord_t,IntersectionPoint> vertical_t; // <y,point>
-    typedef std::map<coord_t,vertical_t>        grid_t;     // <x,<y,point>>
+    typedef std::unordered_map<std::pair<coord_t,coord_t>,size_t,PointHash> index_t;
     
-    grid_t grid;
+    std::vector<IntersectionPoint> grid;    // all the points, including the removed ones
+    index_t index;                          // <x,y> => grid index, for the points still available
+    const auto find = [&index](coord_t x, coord_t y) -> long {
+        index_t::const_iterator it = index.find(std::make_pair(x, y));
+        return it == index.end() ? -1 : long(it->second);
+    };
+    const auto insert = [&grid, &index](const IntersectionPoint &ip) -> size_t {
+        index[std::make_pair(ip.x, ip.y)] = grid.size();
+        grid.push_back(ip);
+        return grid.size() - 1;
+    };
     {
         const Polygons polygons = expolygon;
         for (Polygons::const_iterator polygon = polygons.begin(); polygon != polygons.end(); ++polygon) {
@@ -100,9 +121,9 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
             // point. We'll flush it as soon as we find the next intersection point.
             Points skipped_points;
             
-            // This vector holds the coordinates of the intersection points found while
-            // looping through the polygon.
-            Points ips;
+            // This vector holds the intersection points found while looping through
+            // the polygon.
+            std::vector<size_t> ips;
             
             for (Points::const_iterator p = points.begin(); p != points.end(); ++p) {
                 const Point &prev  = p == points.begin()   ? *(points.end()-1) : *(p-1);
@@ -111,7 +132,6 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
                 // Does the p-next line belong to an intersection line?
                 if (p->x == next.x && ((p->x - bounding_box.min.x) % line_spacing) == 0) {
                     if (p->y == next.y) continue;  // skip coinciding points
-                    vertical_t &v = grid[p->x];
                     
                     // Detect line direction.
                     IntersectionPoint::ipType p_type = IntersectionPoint::ipTypeLower;
@@ -119,33 +139,29 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
                     if (p->y > next.y) std::swap(p_type, n_type);  // line goes downwards
                     
                     // Do we already have 'p' in our grid?
-                    vertical_t::iterator pit = v.find(p->y);
-                    if (pit != v.end()) {
+                    long pit = find(p->x, p->y);
+                    if (pit != -1) {
                         // Yes, we have it. If its not of the same type, it means it's
                         // an intermediate point of a longer line. We store this information
                         // for now and we'll remove it later.
-                        if (pit->second.type != p_type)
-                            pit->second.type = IntersectionPoint::ipTypeMiddle;
+                        if (grid[pit].type != p_type)
+                            grid[pit].type = IntersectionPoint::ipTypeMiddle;
                     } else {
                         // Store the point.
-                        IntersectionPoint ip(p->x, p->y, p_type);
-                        v[p->y] = ip;
-                        ips.push_back(ip);
+                        ips.push_back(insert(IntersectionPoint(p->x, p->y, p_type)));
                     }
                     
                     // Do we already have 'next' in our grid?
-                    pit = v.find(next.y);
-                    if (pit != v.end()) {
+                    pit = find(next.x, next.y);
+                    if (pit != -1) {
                         // Yes, we have it. If its not of the same type, it means it's
                         // an intermediate point of a longer line. We store this information
                         // for now and we'll remove it later.
-                        if (pit->second.type != n_type)
-                            pit->second.type = IntersectionPoint::ipTypeMiddle;
+                        if (grid[pit].type != n_type)
+                            grid[pit].type = IntersectionPoint::ipTypeMiddle;
                     } else {
                         // Store the point.
-                        IntersectionPoint ip(next.x, next.y, n_type);
-                        v[next.y] = ip;
-                        ips.push_back(ip);
+                        ips.push_back(insert(IntersectionPoint(next.x, next.y, n_type)));
                     }
                     continue;
                 }
@@ -203,25 +219,23 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
                         p->y + double(next.y - p->y) * double(x - p->x) / double(next.x - p->x),
                         line_goes_right ? IntersectionPoint::ipTypeLower : IntersectionPoint::ipTypeUpper
                     );
-                    vertical_t &v = grid[ip.x];
                     
                     // Did we already find this point?
                     // (We might have found it as the endpoint of a vertical line.)
                     {
-                        vertical_t::iterator pit = v.find(ip.y);
-                        if (pit != v.end()) {
+                        const long pit = find(ip.x, ip.y);
+                        if (pit != -1) {
                             // Yes, we have it. If its not of the same type, it means it's
                             // an intermediate point of a longer line. We store this information
                             // for now and we'll remove it later.
-                            if (pit->second.type != ip.type)
-                                pit->second.type = IntersectionPoint::ipTypeMiddle;
+                            if (grid[pit].type != ip.type)
+                                grid[pit].type = IntersectionPoint::ipTypeMiddle;
                             continue;
                         }
                     }
                     
                     // Store the skipped polygon vertices along with this point.
-                    ip.skipped = skipped_points;
-                    skipped_points.clear();
+                    std::swap(ip.skipped, skipped_points);
                     
                     #ifdef DEBUG_RECTILINEAR
                     printf("NEW POINT at %f,%f\n", unscale(ip.x), unscale(ip.y));
@@ -230,8 +244,7 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
                     #endif
                     
                     // Store the point.
-                    v[ip.y] = ip;
-                    ips.push_back(ip);
+                    ips.push_back(insert(ip));
                 }
                 
                 // We're now going past the final point, so save it.
@@ -247,9 +260,9 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
                 // separated by a hole polygon: we'll connect them with the hole portion).
                 // We will sweep only from left to right, so we only need to build connections
                 // in this direction.
-                for (Points::const_iterator it = ips.begin(); it != ips.end(); ++it) {
-                    IntersectionPoint &ip   = grid[it->x][it->y];
-                    IntersectionPoint &next = it == ips.end()-1 ? grid[ips.begin()->x][ips.begin()->y] : grid[(it+1)->x][(it+1)->y];
+                for (std::vector<size_t>::const_iterator it = ips.begin(); it != ips.end(); ++it) {
+                    IntersectionPoint &ip   = grid[*it];
+                    IntersectionPoint &next = grid[it == ips.end()-1 ? ips.front() : *(it+1)];
                     
                     #ifdef DEBUG_RECTILINEAR
                     printf("CONNECTING %f,%f to %f,%f\n",
@@ -283,26 +296,64 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
             
             // Do some cleanup: remove the 'skipped' points we used for building 
             // connections and also remove the middle intersection points.
-            for (Points::const_iterator it = ips.begin(); it != ips.end(); ++it) {
-                vertical_t &v = grid[it->x];
-                IntersectionPoint &ip = v[it->y];
-                ip.skipped.clear();
+            for (std::vector<size_t>::const_iterator it = ips.begin(); it != ips.end(); ++it) {
+                IntersectionPoint &ip = grid[*it];
+                Points().swap(ip.skipped);
                 if (ip.type == IntersectionPoint::ipTypeMiddle)
-                    v.erase(it->y);
+                    index.erase(std::make_pair(ip.x, ip.y));
             }
         }
     }
     
+    // Sort the available points by x and y, and link the ones sharing the same x
+    // into scanlines.
+    std::vector<size_t> sorted;
+    sorted.reserve(index.size());
+    for (index_t::const_iterator it = index.begin(); it != index.end(); ++it)
+        sorted.push_back(it->second);
+    std::sort(sorted.begin(), sorted.end(), [&grid](size_t a, size_t b) {
+        return grid[a].x < grid[b].x || (grid[a].x == grid[b].x && grid[a].y < grid[b].y);
+    });
+    std::vector<long> lines;    // lowest available point of each scanline, or -1
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        IntersectionPoint &ip = grid[sorted[i]];
+        if (i == 0 || grid[sorted[i-1]].x != ip.x) {
+            lines.push_back(sorted[i]);
+        } else {
+            ip.below = sorted[i-1];
+            grid[sorted[i-1]].above = sorted[i];
+        }
+        ip.line = lines.size() - 1;
+    }
+    
+    // Remove a point from its scanline and from the index.
+    const auto remove = [&grid, &index, &lines](size_t i) {
+        IntersectionPoint &ip = grid[i];
+        if (ip.below == -1)
+            lines[ip.line] = ip.above;
+        else
+            grid[ip.below].above = ip.above;
+        if (ip.above != -1)
+            grid[ip.above].below = ip.below;
+        index.erase(std::make_pair(ip.x, ip.y));
+    };
+    // Remove all the points of a scanline.
+    const auto remove_line = [&grid, &index, &lines](long line) {
+        for (long i = lines[line]; i != -1; i = grid[i].above)
+            index.erase(std::make_pair(grid[i].x, grid[i].y));
+        lines[line] = -1;
+    };
+    
     #ifdef DEBUG_RECTILINEAR
     SVG svg("grid.svg");
     svg.draw(expolygon);
     
     printf("GRID:\n");
-    for (grid_t::const_iterator it = grid.begin(); it != grid.end(); ++it) {
-        printf("x = %f:\n", unscale(it->first));
-        for (vertical_t::const_iterator v = it->second.begin(); v != it->second.end(); ++v) {
-            const IntersectionPoint &ip = v->second;
-            printf("   y = %f (%s, next = %f,%f, extra = %zu)\n", unscale(v->first),
+    for (size_t line = 0; line < lines.size(); ++line) {
+        printf("x = %f:\n", unscale(grid[lines[line]].x));
+        for (long i = lines[line]; i != -1; i = grid[i].above) {
+            const IntersectionPoint &ip = grid[i];
+            printf("   y = %f (%s, next = %f,%f, extra = %zu)\n", unscale(ip.y),
                 ip.type == IntersectionPoint::ipTypeLower ? "lower"
                 : ip.type == IntersectionPoint::ipTypeMiddle ? "middle" : "upper",
                 (ip.next.empty() ? -1 : unscale(ip.next.back().x)),
@@ -322,76 +373,65 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
     const size_t n_polylines_out_old = out->size();
     
     // Loop until we have no more vertical lines available.
-    while (!grid.empty()) {
-        // Get the first x coordinate.
-        vertical_t &v = grid.begin()->second;
-        
-        // If this x coordinate does not have any y coordinate, remove it.
-        if (v.empty()) {
-            grid.erase(grid.begin());
+    for (size_t line = 0; line < lines.size(); ) {
+        // If this x coordinate does not have any y coordinate, move to the next one.
+        if (lines[line] == -1) {
+            ++line;
             continue;
         }
         
-        // We expect every x coordinate to contain an even number of y coordinates 
-        // because they are the endpoints of vertical intersection lines:
-        // lower/upper, lower/upper etc.
-        assert(v.size() % 2 == 0);
-        
         // Get the first lower point.
-        vertical_t::iterator it = v.begin();  // minimum x,y
-        IntersectionPoint p = it->second;
-        if (p.type != IntersectionPoint::ipTypeLower) {
+        long it = lines[line];  // minimum x,y
+        const IntersectionPoint* p = &grid[it];
+        if (p->type != IntersectionPoint::ipTypeLower) {
             // Degenerate polygon, this shouldn't happen.
             // We used to have an assert here, but let's be tolerant.
-            grid.erase(p.x);
+            remove_line(p->line);
             continue;
         }
         
         // Start our polyline.
         Polyline polyline;
-        polyline.append(p);
+        polyline.append(*p);
         polyline.points.back().y -= this->endpoints_overlap;
         
         while (true) {
             // Complete the vertical line by finding the corresponding upper or lower point.
-            if (p.type == IntersectionPoint::ipTypeUpper) {
+            if (p->type == IntersectionPoint::ipTypeUpper) {
                 // find first point along c.x with y < c.y
-                if (it == grid[p.x].begin()) {
+                if (grid[it].below == -1) {
                     // Degenerate polygon, this shouldn't happen.
                     // We used to have an assert here, but let's be tolerant.
-                    grid.erase(p.x);
+                    remove_line(p->line);
                     break;
                 }
-                --it;
+                it = grid[it].below;
             } else {
                 // find first point along c.x with y > c.y
-                ++it;
-                if (it == grid[p.x].end()) {
+                if (grid[it].above == -1) {
                     // Degenerate polygon, this shouldn't happen.
                     // We used to have an assert here, but let's be tolerant.
-                    grid.erase(p.x);
+                    remove_line(p->line);
                     break;
                 }
+                it = grid[it].above;
             }
             
             // Append the point to our polyline.
-            IntersectionPoint b = it->second;
-            if (b.type == p.type) {
+            const IntersectionPoint &b = grid[it];
+            if (b.type == p->type) {
                 // Degenerate polygon, this shouldn't happen.
                 // We used to have an assert here, but let's be tolerant.
-                grid.erase(p.x);
+                remove_line(p->line);
                 break;
             }
             polyline.append(b);
             polyline.points.back().y += this->endpoints_overlap * (b.type == IntersectionPoint::ipTypeUpper ? 1 : -1);
 
             // Remove the two endpoints of this vertical line from the grid.
-            {
-                vertical_t &v = grid[p.x];
-                v.erase(p.y);
-                v.erase(it);
-                if (v.empty()) grid.erase(p.x);
-            }
+            remove(p - grid.data());
+            remove(it);
+            
             // Do we have a connection starting from here?
             // If not, stop the polyline.
             if (b.next.empty())
@@ -415,8 +455,8 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
             }
             
             // Is the final point still available?
-            if (grid.count(b.next.back().x) == 0
-                || grid[b.next.back().x].count(b.next.back().y) == 0)
+            it = find(b.next.back().x, b.next.back().y);
+            if (it == -1)
                 // We already used this point or we might have removed this
                 // point while building the grid because it's collinear (middle); in either
                 // cases the connection line from the previous one is legit and worth having.
@@ -424,15 +464,14 @@ FillRectilinear::_fill_single_direction(ExPolygon expolygon,
             
             // Retrieve the intersection point. The next loop will find the correspondent
             // endpoint of the vertical line.
-            it = grid[ b.next.back().x ].find(b.next.back().y);
-            p  = it->second;
+            p = &grid[it];
             
             // If the connection brought us to another x coordinate, we expect the point 
             // type to be the same.
-            if (!(p.type == b.type && p.x > b.x) && !(p.type != b.type && p.x == b.x)) {
+            if (!(p->type == b.type && p->x > b.x) && !(p->type != b.type && p->x == b.x)) {
                 // Degenerate polygon, this shouldn't happen.
                 // We used to have an assert here, but let's be tolerant.
-                grid.erase(p.x);
+                remove_line(p->line);
                 break;
             }
         }
@@ -10,16 +10,44 @@ namespace Slic3r {
 
 AvoidCrossingPerimeters::AvoidCrossingPerimeters()
     : use_external_mp(false), use_external_mp_once(false), disable_once(true),
-        _external_mp(NULL), _layer_mp(NULL)
+        _external_mp(NULL), _layer_mp(NULL), _layer_mp_owned(false)
 {
 }
 
+AvoidCrossingPerimeters::AvoidCrossingPerimeters(const AvoidCrossingPerimeters &other)
+    : use_external_mp(other.use_external_mp), use_external_mp_once(other.use_external_mp_once),
+        disable_once(other.disable_once),
+        _external_mp(NULL), _layer_mp(NULL), _layer_mp_owned(false)
+{
+}
+
+AvoidCrossingPerimeters&
+AvoidCrossingPerimeters::operator=(const AvoidCrossingPerimeters &other)
+{
+    if (this == &other) return *this;
+    
+    this->use_external_mp       = other.use_external_mp;
+    this->use_external_mp_once  = other.use_external_mp_once;
+    this->disable_once          = other.disable_once;
+    
+    if (this->_external_mp != NULL)
+        delete this->_external_mp;
+    this->_external_mp = NULL;
+    
+    if (this->_layer_mp_owned)
+        delete this->_layer_mp;
+    this->_layer_mp = NULL;
+    this->_layer_mp_owned = false;
+    
+    return *this;
+}
+
 AvoidCrossingPerimeters::~AvoidCrossingPerimeters()
 {
     if (this->_external_mp != NULL)
         delete this->_external_mp;
     
-    if (this->_layer_mp != NULL)
+    if (this->_layer_mp_owned)
         delete this->_layer_mp;
 }
 
@@ -35,10 +63,21 @@ AvoidCrossingPerimeters::init_external_mp(const ExPolygons &islands)
 void
 AvoidCrossingPerimeters::init_layer_mp(const ExPolygons &islands)
 {
-    if (this->_layer_mp != NULL)
+    if (this->_layer_mp_owned)
         delete this->_layer_mp;
     
     this->_layer_mp = new MotionPlanner(islands);
+    this->_layer_mp_owned = true;
+}
+
+void
+AvoidCrossingPerimeters::set_layer_mp(MotionPlanner* mp)
+{
+    if (this->_layer_mp_owned)
+        delete this->_layer_mp;
+    
+    this->_layer_mp = mp;
+    this->_layer_mp_owned = false;
 }
 
 Polyline
@@ -290,8 +329,14 @@ GCode::change_layer(const Layer &layer)
     this->first_layer = (layer.id() == 0);
     
     // avoid computing islands and overhangs if they're not needed
-    if (this->config.avoid_crossing_perimeters)
-        this->avoid_crossing_perimeters.init_layer_mp(union_ex(layer.slices, true));
+    if (this->config.avoid_crossing_perimeters) {
+        // use the planner built by PrintObject::build_motion_planners() if any
+        if (layer.motion_planner != NULL) {
+            this->avoid_crossing_perimeters.set_layer_mp(layer.motion_planner);
+        } else {
+            this->avoid_crossing_perimeters.init_layer_mp(union_ex(layer.slices, true));
+        }
+    }
     
     std::string gcode;
     if (this->layer_count > 0) {
@@ -507,7 +552,13 @@ GCode::_extrude(ExtrusionPath path, std::string description, double speed)
     description = path.is_bridge() ? description + " (bridge)" : description;
     
     // go to first point of extrusion path
-    if (!this->_last_pos_defined || !this->_last_pos.coincides_with(path.first_point())) {
+    if (this->deferred_travel.defer) {
+        this->deferred_travel.defer     = false;
+        this->deferred_travel.pending   = true;
+        this->deferred_travel.point     = path.first_point();
+        this->deferred_travel.role      = path.role;
+        this->deferred_travel.comment   = "move to first " + description + " point";
+    } else if (!this->_last_pos_defined || !this->_last_pos.coincides_with(path.first_point())) {
         gcode += this->travel_to(
             path.first_point(),
             path.role,
@@ -29,14 +29,20 @@ class AvoidCrossingPerimeters {
     bool disable_once;
     
     AvoidCrossingPerimeters();
+    // copies the flags but not the planners, which have to be set up again
+    AvoidCrossingPerimeters(const AvoidCrossingPerimeters &other);
+    AvoidCrossingPerimeters& operator=(const AvoidCrossingPerimeters &other);
     ~AvoidCrossingPerimeters();
     void init_external_mp(const ExPolygons &islands);
     void init_layer_mp(const ExPolygons &islands);
+    // uses a planner owned by someone else (e.g. prebuilt by the layer)
+    void set_layer_mp(MotionPlanner* mp);
     Polyline travel_to(GCode &gcodegen, Point point);
     
     private:
     MotionPlanner* _external_mp;
     MotionPlanner* _layer_mp;
+    bool _layer_mp_owned;
 };
 
 class OozePrevention {
@@ -63,6 +69,19 @@ class Wipe {
     std::string wipe(GCode &gcodegen, bool toolchange = false);
 };
 
+/// A travel move left out of the G-code by GCode::_extrude(), to be
+/// generated later by the caller (see LayerBodies).
+class DeferredTravel {
+    public:
+    bool defer;         ///< set to leave out the next travel to an extrusion
+    bool pending;       ///< set once a travel was left out
+    Point point;
+    ExtrusionRole role;
+    std::string comment;
+    
+    DeferredTravel() : defer(false), pending(false), role(erNone) {};
+};
+
 class GCode {
     public:
     
@@ -92,6 +111,7 @@ class GCode {
     // second it does not account for the velocity profiles of the printer.
     float elapsed_time, elapsed_time_bridges, elapsed_time_external; // seconds
     double volumetric_speed;
+    DeferredTravel deferred_travel;
     
     GCode();
     const Point& last_pos() const;
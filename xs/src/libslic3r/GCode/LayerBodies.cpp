@@ -0,0 +1,477 @@
+#include "LayerBodies.hpp"
+#include <algorithm>
+#include <set>
+#include <boost/bind.hpp>
+
+namespace Slic3r {
+
+// Layers whose bodies are generated at once by each thread; the G-code of
+// a batch is kept in memory until it's stitched.
+static const size_t LAYER_BODIES_BATCH_SIZE = 8;
+
+LayerBodies::LayerBodies(GCode &gcodegen, const Print &print, int threads)
+    : _gcodegen(&gcodegen), _print(&print), _threads(std::max(threads, 1)), _next(0)
+{
+    const PrintConfig &config = print.config;
+
+    // these flavors don't support resetting the extrusion axis
+    this->_enabled = !config.spiral_vase
+        && (config.use_relative_e_distances
+            || (config.gcode_flavor != gcfMach3
+                && config.gcode_flavor != gcfMakerWare
+                && config.gcode_flavor != gcfSailfish));
+}
+
+void
+LayerBodies::add(const Layer &layer, const Point &copy)
+{
+    const PrintObject* object = layer.object();
+    if (this->_prototypes.count(object) == 0) {
+        GCode &prototype = this->_prototypes[object];
+        prototype.apply_print_config(this->_print->config);
+        std::vector<unsigned int> extruder_ids;
+        for (std::map<unsigned int,Extruder>::const_iterator it = this->_gcodegen->writer.extruders.begin();
+            it != this->_gcodegen->writer.extruders.end(); ++it)
+            extruder_ids.push_back(it->first);
+        prototype.set_extruders(extruder_ids);
+        prototype.config.apply(object->config, true);
+    }
+
+    this->_bodies.push_back(Body(&layer, copy));
+}
+
+std::string
+LayerBodies::stitch(const Layer &layer, const Point &copy)
+{
+    GCode &gcodegen = *this->_gcodegen;
+
+    // extrude the layer here if it wasn't queued in this order
+    if (this->_next >= this->_bodies.size()
+        || this->_bodies[this->_next].layer != &layer
+        || !this->_bodies[this->_next].copy.coincides_with(copy))
+        return LayerBodies::extrude(gcodegen, *this->_print, layer);
+
+    if (this->_enabled && !this->_bodies[this->_next].generated)
+        this->_generate_batch();
+    Body &body = this->_bodies[this->_next++];
+
+    // the body was extruded with the settings of the generator at the time
+    // the batch was generated, which might have been changed since
+    if (body.gcodegen
+        && (body.gcodegen->volumetric_speed != gcodegen.volumetric_speed
+            || body.gcodegen->enable_loop_clipping != gcodegen.enable_loop_clipping
+            || body.gcodegen->enable_cooling_markers != gcodegen.enable_cooling_markers))
+        body.gcodegen.reset();
+
+    std::string gcode;
+    if (!body.gcodegen) {
+        gcode = LayerBodies::extrude(gcodegen, *this->_print, layer);
+    } else if (body.extruder_id >= 0) {
+        gcode += gcodegen.set_extruder(body.extruder_id);
+    }
+    if (body.gcodegen && body.gcodegen->deferred_travel.pending) {
+        const GCode &bodygen = *body.gcodegen;
+        const DeferredTravel &travel = bodygen.deferred_travel;
+
+        gcode += gcodegen.travel_to(travel.point, travel.role, travel.comment);
+        gcode += gcodegen.unretract();
+        // the body starts with the extrusion axis at zero and the
+        // default acceleration
+        gcode += gcodegen.writer.reset_e();
+        gcode += gcodegen.writer.set_acceleration(gcodegen.config.default_acceleration.value);
+        gcode += body.gcode;
+
+        gcodegen.writer.continue_from(bodygen.writer);
+        gcodegen.set_last_pos(bodygen.last_pos());
+        gcodegen.wipe.path = bodygen.wipe.path;
+        std::map<const PrintObject*,Point>::const_iterator seam = bodygen._seam_position.find(layer.object());
+        if (seam != bodygen._seam_position.end())
+            gcodegen._seam_position[layer.object()] = seam->second;
+        gcodegen.elapsed_time           += bodygen.elapsed_time;
+        gcodegen.elapsed_time_bridges   += bodygen.elapsed_time_bridges;
+        gcodegen.elapsed_time_external  += bodygen.elapsed_time_external;
+    }
+
+    // release the memory early
+    std::string().swap(body.gcode);
+    body.gcodegen.reset();
+    return gcode;
+}
+
+void
+LayerBodies::_generate_batch()
+{
+    // Bodies of the same layer are generated by the same thread, as they
+    // share the layer's motion planner.
+    this->_batch.clear();
+    std::map<const Layer*,size_t> batch_idx;
+    for (size_t i = this->_next; i < this->_bodies.size(); ++i) {
+        const Layer* layer = this->_bodies[i].layer;
+        std::map<const Layer*,size_t>::const_iterator it = batch_idx.find(layer);
+        if (it == batch_idx.end()) {
+            if (this->_batch.size() == LAYER_BODIES_BATCH_SIZE * this->_threads) break;
+            it = batch_idx.insert(std::make_pair(layer, this->_batch.size())).first;
+            this->_batch.push_back(std::vector<size_t>());
+        }
+        this->_batch[it->second].push_back(i);
+    }
+
+    parallelize<size_t>(
+        0,
+        this->_batch.size()-1,
+        boost::bind(&LayerBodies::_generate, this, _1),
+        this->_threads
+    );
+}
+
+void
+LayerBodies::_generate(size_t idx)
+{
+    for (size_t i : this->_batch[idx]) {
+        Body &body = this->_bodies[i];
+        // errors are left to stitch(), which extrudes the layer itself
+        try {
+            this->_generate_body(body);
+        } catch (...) {
+            body.gcodegen.reset();
+            std::string().swap(body.gcode);
+        }
+        body.generated = true;
+    }
+}
+
+void
+LayerBodies::_generate_body(Body &body)
+{
+    const GCode &live = *this->_gcodegen;
+    const Layer &layer = *body.layer;
+    const PrintObject &object = *layer.object();
+    const IslandsByExtruder by_extruder = LayerBodies::_group_by_extruder(*this->_print, layer);
+
+    // bodies using several extruders are extruded by stitch()
+    std::set<unsigned int> extruders;
+    if (const SupportLayer* support_layer = dynamic_cast<const SupportLayer*>(&layer)) {
+        if (!support_layer->support_interface_fills.entities.empty())
+            extruders.insert(object.config.support_material_interface_extruder.value - 1);
+        if (!support_layer->support_fills.entities.empty())
+            extruders.insert(object.config.support_material_extruder.value - 1);
+    }
+    for (IslandsByExtruder::const_iterator it = by_extruder.begin(); it != by_extruder.end(); ++it)
+        extruders.insert(it->first);
+    if (extruders.size() > 1) return;
+
+    // the copy gets its own planners below and never uses a placeholder
+    // parser, so it can run alongside the other bodies
+    GCode* gcodegen = new GCode(this->_prototypes.find(&object)->second);
+    body.gcodegen.reset(gcodegen);
+    gcodegen->enable_loop_clipping      = live.enable_loop_clipping;
+    gcodegen->enable_cooling_markers    = live.enable_cooling_markers;
+    gcodegen->volumetric_speed          = live.volumetric_speed;
+    LayerBodies::autospeed(*gcodegen, *this->_print, layer);
+
+    // what GCode::change_layer() does, without moving
+    gcodegen->layer         = &layer;
+    gcodegen->first_layer   = (layer.id() == 0);
+    if (gcodegen->config.avoid_crossing_perimeters) {
+        if (layer.motion_planner != NULL) {
+            gcodegen->avoid_crossing_perimeters.set_layer_mp(layer.motion_planner);
+        } else {
+            gcodegen->avoid_crossing_perimeters.init_layer_mp(union_ex(layer.slices, true));
+        }
+        // a new generator skips the planner for its first travel, which is
+        // the one left to stitch() here
+        gcodegen->avoid_crossing_perimeters.disable_once = false;
+    }
+    gcodegen->set_origin(Pointf(unscale(body.copy.x), unscale(body.copy.y)));
+
+    // the state stitch() brings the actual generator to, set silently
+    if (!extruders.empty()) {
+        body.extruder_id = *extruders.begin();
+        gcodegen->writer.toolchange(body.extruder_id);
+    }
+    gcodegen->writer.travel_to_z(layer.print_z);
+    gcodegen->writer.set_acceleration(gcodegen->config.default_acceleration.value);
+
+    // islands are chained and seams are aligned starting from the rear of
+    // the object, instead of from where the previous layer ended
+    {
+        const BoundingBox bb = object.bounding_box();
+        const Point start(bb.center().x, bb.max.y);
+        gcodegen->set_last_pos(start);
+        gcodegen->_seam_position[&object] = start;
+    }
+
+    gcodegen->deferred_travel.defer = true;
+    body.gcode = LayerBodies::_extrude(*gcodegen, *this->_print, layer, by_extruder);
+    gcodegen->deferred_travel.defer = false;
+}
+
+// Bodies extruded ahead of time have no placeholder parser, and their only
+// extruder already selected.
+static std::string
+_set_extruder(GCode &gcodegen, unsigned int extruder_id)
+{
+    if (gcodegen.placeholder_parser == NULL && !gcodegen.writer.need_toolchange(extruder_id))
+        return "";
+    return gcodegen.set_extruder(extruder_id);
+}
+
+static std::string
+_extrude_entity(GCode &gcodegen, const ExtrusionEntity &entity, const std::string &description, double speed)
+{
+    if (const ExtrusionEntityCollection* collection = dynamic_cast<const ExtrusionEntityCollection*>(&entity)) {
+        std::string gcode;
+        for (const ExtrusionEntity* e : collection->entities)
+            gcode += _extrude_entity(gcodegen, *e, description, speed);
+        return gcode;
+    }
+    return gcodegen.extrude(entity, description, speed);
+}
+
+// Region ids in the order of Perl's sort(), which compares them as strings.
+static std::vector<size_t>
+_sorted_region_ids(const std::map<size_t,std::vector<const ExtrusionEntity*> > &entities_by_region)
+{
+    std::vector<size_t> region_ids;
+    for (std::map<size_t,std::vector<const ExtrusionEntity*> >::const_iterator it = entities_by_region.begin();
+        it != entities_by_region.end(); ++it)
+        region_ids.push_back(it->first);
+    std::sort(region_ids.begin(), region_ids.end(), [](size_t a, size_t b) {
+        return std::to_string(a) < std::to_string(b);
+    });
+    return region_ids;
+}
+
+std::string
+LayerBodies::extrude(GCode &gcodegen, const Print &print, const Layer &layer)
+{
+    return LayerBodies::_extrude(gcodegen, print, layer, LayerBodies::_group_by_extruder(print, layer));
+}
+
+// We define a strategy for building perimeters and fills. The separation
+// between regions doesn't matter in terms of printing order, as we follow
+// another logic instead:
+// - we group all extrusions by extruder so that we minimize toolchanges
+// - we start from the last used extruder
+// - for each extruder, we group extrusions by island
+// - for each island, we extrude perimeters first, unless user set the
+//   infill_first option
+// (Still, we have to keep track of regions because we need to apply their config)
+std::string
+LayerBodies::_extrude(GCode &gcodegen, const Print &print, const Layer &layer, const IslandsByExtruder &by_extruder)
+{
+    std::string gcode;
+    const PrintObject &object = *layer.object();
+
+    // extrude support material before other things because it might use a lower Z
+    // and also because we avoid travelling on other things when printing it
+    if (const SupportLayer* support_layer = dynamic_cast<const SupportLayer*>(&layer)) {
+        if (!support_layer->support_interface_fills.entities.empty()) {
+            gcode += _set_extruder(gcodegen, object.config.support_material_interface_extruder.value - 1);
+            const double speed = object.config.get_abs_value("support_material_interface_speed");
+            ExtrusionEntityCollection chained;
+            support_layer->support_interface_fills.chained_path_from(gcodegen.last_pos(), &chained);
+            for (const ExtrusionEntity* entity : chained.entities)
+                gcode += _extrude_entity(gcodegen, *entity, "support material interface", speed);
+        }
+        if (!support_layer->support_fills.entities.empty()) {
+            gcode += _set_extruder(gcodegen, object.config.support_material_extruder.value - 1);
+            const double speed = object.config.get_abs_value("support_material_speed");
+            ExtrusionEntityCollection chained;
+            support_layer->support_fills.chained_path_from(gcodegen.last_pos(), &chained);
+            for (const ExtrusionEntity* entity : chained.entities)
+                gcode += _extrude_entity(gcodegen, *entity, "support material", speed);
+        }
+    }
+
+    // start from the last used extruder to save toolchanges
+    std::vector<unsigned int> extruders;
+    for (IslandsByExtruder::const_iterator it = by_extruder.begin(); it != by_extruder.end(); ++it)
+        extruders.push_back(it->first);
+    if (extruders.size() > 1 && gcodegen.writer.extruder() != NULL) {
+        std::vector<unsigned int>::iterator last = std::find(extruders.begin(), extruders.end(),
+            gcodegen.writer.extruder()->id);
+        if (last != extruders.end())
+            std::rotate(extruders.begin(), last, last + 1);
+    }
+
+    for (unsigned int extruder_id : extruders) {
+        gcode += _set_extruder(gcodegen, extruder_id);
+        for (const Island &island : by_extruder.find(extruder_id)->second) {
+            if (print.config.infill_first) {
+                gcode += LayerBodies::_extrude_infill(gcodegen, print, island.infill);
+                gcode += LayerBodies::_extrude_perimeters(gcodegen, print, island.perimeters);
+            } else {
+                gcode += LayerBodies::_extrude_perimeters(gcodegen, print, island.perimeters);
+                gcode += LayerBodies::_extrude_infill(gcodegen, print, island.infill);
+            }
+        }
+    }
+    return gcode;
+}
+
+// Groups the extrusions by extruder and then by island.
+LayerBodies::IslandsByExtruder
+LayerBodies::_group_by_extruder(const Print &print, const Layer &layer)
+{
+    IslandsByExtruder by_extruder;
+
+    // cache bounding boxes of layer slices
+    const ExPolygons &slices = layer.slices.expolygons;
+    std::vector<BoundingBox> slices_bb;
+    for (const ExPolygon &slice : slices)
+        slices_bb.push_back(slice.contour.bounding_box());
+
+    // entities not fitting inside any slice go with the last one
+    const size_t n_slices = slices.size();
+    auto island_idx = [&](const Point &point) -> size_t {
+        for (size_t i = 0; i + 1 < n_slices; ++i)
+            if (slices_bb[i].contains(point) && slices[i].contour.contains(point))
+                return i;
+        return n_slices - 1;
+    };
+    auto island = [&](unsigned int extruder_id, size_t i) -> Island& {
+        std::vector<Island> &islands = by_extruder[extruder_id];
+        if (islands.size() <= i) islands.resize(i + 1);
+        return islands[i];
+    };
+
+    for (size_t region_id = 0; region_id < print.regions.size(); ++region_id) {
+        if (region_id >= layer.regions.size()) break;
+        const LayerRegion &layerm = *layer.regions[region_id];
+        const PrintRegionConfig &config = print.regions[region_id]->config;
+
+        // each perimeter collection represents a single slice
+        const unsigned int perimeter_extruder = config.perimeter_extruder.value - 1;
+        for (const ExtrusionEntity* entity : layerm.perimeters.entities) {
+            const ExtrusionEntityCollection* perimeter_coll = dynamic_cast<const ExtrusionEntityCollection*>(entity);
+            if (perimeter_coll != NULL && perimeter_coll->empty()) continue;
+
+            // init the extruder only if we actually use it
+            by_extruder[perimeter_extruder];
+            if (n_slices == 0) continue;
+
+            std::vector<const ExtrusionEntity*> &perimeters = island(perimeter_extruder, island_idx(entity->first_point())).perimeters[region_id];
+            if (perimeter_coll != NULL) {
+                perimeters.insert(perimeters.end(), perimeter_coll->entities.begin(), perimeter_coll->entities.end());
+            } else {
+                perimeters.push_back(entity);
+            }
+        }
+
+        // each fill collection holds the paths of an infill "group", which
+        // have to be extruded together
+        for (const ExtrusionEntity* entity : layerm.fills.entities) {
+            const ExtrusionEntityCollection* fill = dynamic_cast<const ExtrusionEntityCollection*>(entity);
+            if (fill == NULL || fill->empty()) continue;
+
+            bool solid = false;
+            if (const ExtrusionPath* path = dynamic_cast<const ExtrusionPath*>(fill->entities.front())) {
+                solid = path->is_solid_infill();
+            } else if (const ExtrusionLoop* loop = dynamic_cast<const ExtrusionLoop*>(fill->entities.front())) {
+                solid = loop->is_solid_infill();
+            }
+            const unsigned int extruder_id = solid
+                ? config.solid_infill_extruder.value - 1
+                : config.infill_extruder.value - 1;
+
+            by_extruder[extruder_id];
+            if (n_slices == 0) continue;
+
+            island(extruder_id, island_idx(fill->first_point())).infill[region_id].push_back(fill);
+        }
+    }
+    return by_extruder;
+}
+
+// Extrudes perimeters, whose seams are placed by GCode::extrude_loop().
+std::string
+LayerBodies::_extrude_perimeters(GCode &gcodegen, const Print &print, const LayerBodies::EntitiesByRegion &entities_by_region)
+{
+    std::string gcode;
+    for (size_t region_id : _sorted_region_ids(entities_by_region)) {
+        gcodegen.config.apply(print.regions[region_id]->config, true);
+        for (const ExtrusionEntity* entity : entities_by_region.find(region_id)->second)
+            gcode += _extrude_entity(gcodegen, *entity, "perimeter", -1);
+    }
+    return gcode;
+}
+
+// Chains the paths hierarchically by a greedy algorithm to minimize travel distance.
+std::string
+LayerBodies::_extrude_infill(GCode &gcodegen, const Print &print, const LayerBodies::EntitiesByRegion &entities_by_region)
+{
+    std::string gcode;
+    for (size_t region_id : _sorted_region_ids(entities_by_region)) {
+        gcodegen.config.apply(print.regions[region_id]->config, true);
+
+        ExtrusionEntityCollection collection;
+        for (const ExtrusionEntity* entity : entities_by_region.find(region_id)->second)
+            collection.append(*entity);
+        ExtrusionEntityCollection chained;
+        collection.chained_path_from(gcodegen.last_pos(), &chained);
+        for (const ExtrusionEntity* fill : chained.entities) {
+            if (const ExtrusionEntityCollection* fill_coll = dynamic_cast<const ExtrusionEntityCollection*>(fill)) {
+                ExtrusionEntityCollection fill_chained;
+                fill_coll->chained_path_from(gcodegen.last_pos(), &fill_chained);
+                for (const ExtrusionEntity* entity : fill_chained.entities)
+                    gcode += _extrude_entity(gcodegen, *entity, "infill", -1);
+            } else {
+                gcode += _extrude_entity(gcodegen, *fill, "infill", -1);
+            }
+        }
+    }
+    return gcode;
+}
+
+void
+LayerBodies::autospeed(GCode &gcodegen, const Print &print, const Layer &layer)
+{
+    // get the minimum cross-section used in the layer
+    std::vector<double> mm3_per_mm;
+    for (size_t region_id = 0; region_id < print.regions.size(); ++region_id) {
+        if (region_id >= layer.regions.size()) break;
+        const PrintRegionConfig &config = print.regions[region_id]->config;
+        const LayerRegion &layerm = *layer.regions[region_id];
+        if (config.get_abs_value("perimeter_speed") == 0
+            || config.get_abs_value("small_perimeter_speed") == 0
+            || config.get_abs_value("external_perimeter_speed") == 0
+            || config.get_abs_value("bridge_speed") == 0)
+            mm3_per_mm.push_back(layerm.perimeters.min_mm3_per_mm());
+        if (config.get_abs_value("infill_speed") == 0
+            || config.get_abs_value("solid_infill_speed") == 0
+            || config.get_abs_value("top_solid_infill_speed") == 0
+            || config.get_abs_value("bridge_speed") == 0
+            || config.get_abs_value("gap_fill_speed") == 0)
+            mm3_per_mm.push_back(layerm.fills.min_mm3_per_mm());
+    }
+    if (const SupportLayer* support_layer = dynamic_cast<const SupportLayer*>(&layer)) {
+        const PrintObjectConfig &config = layer.object()->config;
+        if (config.get_abs_value("support_material_speed") == 0
+            || config.get_abs_value("support_material_interface_speed") == 0) {
+            mm3_per_mm.push_back(support_layer->support_fills.min_mm3_per_mm());
+            mm3_per_mm.push_back(support_layer->support_interface_fills.min_mm3_per_mm());
+        }
+    }
+
+    // ignore too thin segments
+    double min_mm3_per_mm = -1;
+    for (double v : mm3_per_mm)
+        if (v > 0.01 && (min_mm3_per_mm < 0 || v < min_mm3_per_mm))
+            min_mm3_per_mm = v;
+    if (min_mm3_per_mm < 0) return;
+
+    // In order to honor max_print_speed we need to find a target volumetric
+    // speed that we can use throughout the print. So we define this target
+    // volumetric speed as the volumetric speed produced by printing the
+    // smallest cross-section at the maximum speed: any larger cross-section
+    // will need slower feedrates.
+    double volumetric_speed = min_mm3_per_mm * print.config.max_print_speed.value;
+
+    // limit such volumetric speed with max_volumetric_speed if set
+    if (print.config.max_volumetric_speed.value > 0)
+        volumetric_speed = std::min(volumetric_speed, print.config.max_volumetric_speed.value);
+    gcodegen.volumetric_speed = volumetric_speed;
+}
+
+}
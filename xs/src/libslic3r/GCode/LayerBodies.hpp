@@ -0,0 +1,95 @@
+#ifndef slic3r_LayerBodies_hpp_
+#define slic3r_LayerBodies_hpp_
+
+#include "libslic3r.h"
+#include "GCode.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+/*
+Generates the extrusions of the layers ahead of time, in parallel threads.
+
+The body of a layer, i.e. the support material, perimeters and infill of one
+object copy as extruded by extrude(), only depends on the preceding layers
+through the state of the G-code generator: position, extrusion axis,
+retraction and seam position. Each body is thus extruded by a generator of
+its own, starting from a fixed point of the object with the extrusion axis
+at zero and leaving out the travel to its first extrusion. stitch() then
+emits that travel with the actual generator, resets the extrusion axis,
+appends the body and carries the final state over.
+Bodies using more than one extruder are extruded by stitch() itself.
+Slic3r::Print::GCode::process_layer() calls extrude() directly when bodies
+aren't generated ahead of time, so both ways share the same code.
+*/
+
+class LayerBodies {
+    public:
+    LayerBodies(GCode &gcodegen, const Print &print, int threads);
+
+    /// Queues the body of a layer for an object copy, in the order they
+    /// will be stitched.
+    void add(const Layer &layer, const Point &copy);
+    /// Returns the G-code of the next queued body, generating the following
+    /// ones as needed. gcodegen must be set up for the layer and the copy.
+    std::string stitch(const Layer &layer, const Point &copy);
+
+    /// Extrudes the body of a layer for the copy gcodegen is set up for.
+    static std::string extrude(GCode &gcodegen, const Print &print, const Layer &layer);
+    /// Sets the volumetric speed of gcodegen from the smallest cross-section
+    /// of the layer printed at automatic speed, if any.
+    static void autospeed(GCode &gcodegen, const Print &print, const Layer &layer);
+
+    private:
+    typedef std::map<size_t,std::vector<const ExtrusionEntity*> > EntitiesByRegion;
+    // Extrusions of an island.
+    struct Island {
+        EntitiesByRegion perimeters;
+        EntitiesByRegion infill;
+    };
+    typedef std::map<unsigned int,std::vector<Island> > IslandsByExtruder;
+
+    struct Body {
+        const Layer* layer;
+        Point copy;
+        bool generated;
+        std::string gcode;
+        int extruder_id;        ///< -1 if nothing is extruded
+        /// generator the body was extruded with, NULL if it has to be
+        /// extruded by stitch()
+        std::unique_ptr<GCode> gcodegen;
+
+        Body(const Layer* layer, const Point &copy)
+            : layer(layer), copy(copy), generated(false), extruder_id(-1) {};
+    };
+
+    GCode* _gcodegen;
+    const Print* _print;
+    int _threads;
+    /// false if all bodies have to be extruded by stitch()
+    bool _enabled;
+    /// generators set up for each object, copied for each body as
+    /// applying configs is slow; they never extrude, so copies share no
+    /// state with them (copies of planners are left unset, and there is
+    /// no placeholder parser)
+    std::map<const PrintObject*,GCode> _prototypes;
+    std::vector<Body> _bodies;
+    size_t _next;           ///< next body to be stitched
+    std::vector<std::vector<size_t> > _batch;   ///< bodies generated together, by layer
+
+    void _generate_batch();
+    void _generate(size_t idx);
+    void _generate_body(Body &body);
+
+    static std::string _extrude(GCode &gcodegen, const Print &print, const Layer &layer, const IslandsByExtruder &by_extruder);
+    static IslandsByExtruder _group_by_extruder(const Print &print, const Layer &layer);
+    static std::string _extrude_perimeters(GCode &gcodegen, const Print &print, const EntitiesByRegion &entities_by_region);
+    static std::string _extrude_infill(GCode &gcodegen, const Print &print, const EntitiesByRegion &entities_by_region);
+};
+
+}
+
+#endif
@@ -54,7 +54,8 @@ namespace asio = boost::asio;
 
 GCodeSender::GCodeSender()
     : io(), serial(io), can_send(false), sent(0), open(false), error(false),
-      connected(false), queue_paused(false)
+      connected(false), queue_paused(false), rx_buffer_size(0), in_flight_bytes(0),
+      writing(false), resend_from(0), ignore_resends(0)
 {}
 
 GCodeSender::~GCodeSender()
@@ -63,7 +64,7 @@ GCodeSender::~GCodeSender()
 }
 
 bool
-GCodeSender::connect(std::string devname, unsigned int baud_rate)
+GCodeSender::connect(std::string devname, unsigned int baud_rate, size_t rx_buffer_size)
 {
     this->disconnect();
     this->set_error_status(false);
@@ -90,8 +91,16 @@ GCodeSender::connect(std::string devname, unsigned int baud_rate)
     }
     
     // a reset firmware expect line numbers to start again from 1
-    this->sent = 0;
-    this->last_sent.clear();
+    {
+        boost::lock_guard<boost::mutex> l(this->queue_mutex);
+        this->sent = 0;
+        this->last_sent.clear();
+        this->rx_buffer_size = rx_buffer_size;
+        this->in_flight.clear();
+        this->in_flight_bytes = 0;
+        this->writing = false;
+        this->ignore_resends = 0;
+    }
     
     /* Initialize debugger */
 #ifdef DEBUG_SERIAL
@@ -336,51 +345,42 @@ GCodeSender::on_read(const boost::system::error_code& error,
         
         // note that line might contain \r at its end
         // parse incoming line
+        const bool ok = boost::starts_with(line, "ok");
         if (!this->connected
             && (boost::starts_with(line, "start")
              || boost::starts_with(line, "Grbl ")
-             || boost::starts_with(line, "ok")
+             || ok
              || boost::contains(line, "T:"))) {
             this->connected = true;
             {
                 boost::lock_guard<boost::mutex> l(this->queue_mutex);
                 this->can_send = true;
+                if (ok) {
+                    this->on_ok();
+                } else {
+                    // a starting firmware dropped what it was sent before
+                    this->in_flight.clear();
+                    this->in_flight_bytes = 0;
+                }
             }
             this->send();
-        } else if (boost::starts_with(line, "ok")) {
+        } else if (ok) {
             {
                 boost::lock_guard<boost::mutex> l(this->queue_mutex);
-                this->can_send = true;
+                this->on_ok();
             }
             this->send();
         } else if (boost::istarts_with(line, "resend")  // Marlin uses "Resend: "
                 || boost::istarts_with(line, "rs")) {
             // extract the first number from line
             boost::algorithm::trim_left_if(line, !boost::algorithm::is_digit());
-            size_t toresend = boost::lexical_cast<size_t>(line.substr(0, line.find_first_not_of("0123456789")));
-            toresend++; // N is 0-based
-            if (toresend >= this->sent - this->last_sent.size() && toresend < this->last_sent.size()) {
-                {
-                    boost::lock_guard<boost::mutex> l(this->queue_mutex);
-                    
-                    // move the unsent lines to priqueue
-                    this->priqueue.insert(
-                        this->priqueue.begin(),  // insert at the beginning
-                        this->last_sent.begin() + toresend - (this->sent - this->last_sent.size()) - 1,
-                        this->last_sent.end()
-                    );
-                    
-                    // we can empty last_sent because it's not useful anymore
-                    this->last_sent.clear();
-                    
-                    // start resending with the requested line number
-                    this->sent = toresend - 1;
-                    this->can_send = true;
-                }
-                this->send();
-            } else {
-                printf("Cannot resend %zu (oldest we have is %zu)\n", toresend, this->sent - this->last_sent.size());
+            line = line.substr(0, line.find_first_not_of("0123456789"));
+            if (!line.empty()) {
+                boost::lock_guard<boost::mutex> l(this->queue_mutex);
+                this->on_resend(boost::lexical_cast<size_t>(line));
             }
+            // the lines are sent again once the ok following the request
+            // frees the buffer
         } else if (boost::starts_with(line, "wait")) {
             // ignore
         } else {
@@ -451,61 +451,133 @@ GCodeSender::do_send()
 {
     boost::lock_guard<boost::mutex> l(this->queue_mutex);
     
-    // printer is not connected or we're still waiting for the previous ack
-    if (!this->can_send) return;
+    // printer is not connected or we're still writing the previous lines
+    if (!this->can_send || this->writing) return;
     
-    std::string line;
-    while (!this->priqueue.empty() || (!this->queue.empty() && !this->queue_paused)) {
-        if (!this->priqueue.empty()) {
-            line = this->priqueue.front();
+    std::ostream os(&this->write_buffer);
+    while (true) {
+        // look for the next line, dropping comments and empty ones
+        std::string line;
+        bool priority = false;
+        while (line.empty()) {
+            if (!this->priqueue.empty()) {
+                line = this->priqueue.front();
+                priority = true;
+            } else if (!this->queue.empty() && !this->queue_paused) {
+                line = this->queue.front();
+                priority = false;
+            } else {
+                break;
+            }
+            
+            // strip comments
+            size_t comment_pos = line.find_first_of(';');
+            if (comment_pos != std::string::npos)
+                line.erase(comment_pos, std::string::npos);
+            boost::algorithm::trim(line);
+            
+            // if line is empty, process next item in queue
+            if (line.empty()) {
+                if (priority) {
+                    this->priqueue.pop_front();
+                } else {
+                    this->queue.pop();
+                }
+            }
+        }
+        if (line.empty()) break;
+        
+        // compute full line
+        std::string full_line = "N" + boost::lexical_cast<std::string>(this->sent + 1) + " " + line;
+        
+        // calculate checksum
+        int cs = 0;
+        for (std::string::const_iterator it = full_line.begin(); it != full_line.end(); ++it)
+           cs = cs ^ *it;
+        full_line += "*";
+        full_line += boost::lexical_cast<std::string>(cs);
+        full_line += "\n";
+        
+        if (!this->fits(full_line)) break;
+        
+        if (priority) {
             this->priqueue.pop_front();
         } else {
-            line = this->queue.front();
             this->queue.pop();
         }
         
-        // strip comments
-        size_t comment_pos = line.find_first_of(';');
-        if (comment_pos != std::string::npos)
-            line.erase(comment_pos, std::string::npos);
-        boost::algorithm::trim(line);
+#ifdef DEBUG_SERIAL
+        fs << ">> " << full_line << std::flush;
+#endif
+        
+        this->sent++;
+        this->last_sent.push_back(line);
+        this->in_flight.push_back(full_line.size());
+        this->in_flight_bytes += full_line.size();
         
-        // if line is not empty, send it
-        if (!line.empty()) break;
-        // if line is empty, process next item in queue
+        // keep the lines that might be asked for again
+        while (this->last_sent.size() > std::max<size_t>(KEEP_SENT, this->in_flight.size()))
+            this->last_sent.pop_front();
+        
+        os << full_line;
     }
-    if (line.empty()) return;
-    
-    // compute full line
-    std::string full_line = "N" + boost::lexical_cast<std::string>(this->sent) + " " + line;
-    this->sent++;
-    
-    // calculate checksum
-    int cs = 0;
-    for (std::string::const_iterator it = full_line.begin(); it != full_line.end(); ++it)
-       cs = cs ^ *it;
+    if (this->write_buffer.size() == 0) return;
     
-    // write line to device
-    full_line += "*";
-    full_line += boost::lexical_cast<std::string>(cs);
-    full_line += "\n";
+    // the lines are collected in write_buffer as their storage has to outlive
+    // async_write(); no other write may start before this one completes
+    this->writing = true;
+    asio::async_write(this->serial, this->write_buffer, boost::bind(&GCodeSender::on_write, this, boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred));
+}
+
+// Whether a line can be sent before the acknowledgement of the ones in
+// flight: without a receive buffer size, each line waits for the ok of the
+// previous one. Must be called with queue_mutex held.
+bool
+GCodeSender::fits(const std::string &full_line) const
+{
+    return this->in_flight.empty()
+        || (this->rx_buffer_size > 0 && this->in_flight_bytes + full_line.size() <= this->rx_buffer_size);
+}
+
+// The firmware acknowledges the lines in the order it got them: an ok frees
+// the room of the oldest line in flight. Must be called with queue_mutex held.
+void
+GCodeSender::on_ok()
+{
+    if (this->in_flight.empty()) return;
+    this->in_flight_bytes -= this->in_flight.front();
+    this->in_flight.pop_front();
+}
+
+// Queues the lines from line_number on again, ahead of anything else.
+// The firmware rejects each line sent after the bad one with a request
+// for the same line, and an ok, so those requests are ignored.
+// Must be called with queue_mutex held.
+void
+GCodeSender::on_resend(size_t line_number)
+{
+    if (line_number == this->resend_from && this->ignore_resends > 0) {
+        --this->ignore_resends;
+        return;
+    }
     
-#ifdef DEBUG_SERIAL
-    fs << ">> " << full_line << std::flush;
-#endif
+    const size_t oldest = this->sent + 1 - this->last_sent.size();
+    if (line_number < oldest || line_number > this->sent) {
+        printf("Cannot resend %zu (oldest we have is %zu)\n", line_number, oldest);
+        return;
+    }
     
-    this->last_sent.push_back(line);
-    this->can_send = false;
+    // move the lines to resend to priqueue
+    std::deque<std::string>::iterator first = this->last_sent.begin() + (line_number - oldest);
+    this->priqueue.insert(this->priqueue.begin(), first, this->last_sent.end());
+    this->last_sent.erase(first, this->last_sent.end());
     
-    if (this->last_sent.size() > KEEP_SENT)
-        this->last_sent.erase(this->last_sent.begin(), this->last_sent.end() - KEEP_SENT);
+    this->resend_from       = line_number;
+    this->ignore_resends    = this->sent - line_number;
     
-    // we can't supply asio::buffer(full_line) to async_write() because full_line is on the
-    // stack and the buffer would lose its underlying storage causing memory corruption
-    std::ostream os(&this->write_buffer);
-    os << full_line;
-    asio::async_write(this->serial, this->write_buffer, boost::bind(&GCodeSender::on_write, this, boost::asio::placeholders::error,
-                boost::asio::placeholders::bytes_transferred));
+    // start resending with the requested line number
+    this->sent = line_number - 1;
 }
 
 void
@@ -513,6 +585,10 @@ GCodeSender::on_write(const boost::system::error_code& error,
     size_t bytes_transferred)
 {
     this->set_error_status(false);
+    {
+        boost::lock_guard<boost::mutex> l(this->queue_mutex);
+        this->writing = false;
+    }
     if (error) {
         if (this->open) {
             this->do_close();
@@ -3,6 +3,7 @@
 #ifdef BOOST_LIBS
 
 #include "libslic3r.h"
+#include <deque>
 #include <queue>
 #include <string>
 #include <vector>
@@ -30,7 +31,11 @@ class GCodeSender : private boost::noncopyable {
     public:
     GCodeSender();
     ~GCodeSender();
-    bool connect(std::string devname, unsigned int baud_rate);
+    /// With a non-zero rx_buffer_size, lines are sent ahead of the
+    /// acknowledgements as long as the unacknowledged ones fit in the
+    /// receive buffer of the firmware. Otherwise each line waits for
+    /// the ok of the previous one.
+    bool connect(std::string devname, unsigned int baud_rate, size_t rx_buffer_size = 0);
     void send(const std::vector<std::string> &lines, bool priority = false);
     void send(const std::string &s, bool priority = false);
     void disconnect();
@@ -57,14 +62,21 @@ class GCodeSender : private boost::noncopyable {
     bool error;
     mutable boost::mutex error_mutex;
 
-    // this mutex guards queue, priqueue, can_send, queue_paused, sent, last_sent
+    // this mutex guards queue, priqueue, can_send, queue_paused, sent, last_sent,
+    // in_flight, in_flight_bytes, writing, resend_from, ignore_resends
     mutable boost::mutex queue_mutex;
     std::queue<std::string> queue;
     std::list<std::string> priqueue;
     bool can_send;
     bool queue_paused;
-    size_t sent;
-    std::vector<std::string> last_sent;
+    size_t sent;                            ///< number of the last line sent
+    std::deque<std::string> last_sent;      ///< lines up to number sent, for resends
+    size_t rx_buffer_size;                  ///< 0 to send one line at a time
+    std::deque<size_t> in_flight;           ///< lengths of the lines waiting for an ok
+    size_t in_flight_bytes;
+    bool writing;                           ///< whether an async_write() is pending
+    size_t resend_from;                     ///< line of the last resend request
+    size_t ignore_resends;                  ///< repeated requests still expected for it
 
     // this mutex guards log, T, B
     mutable boost::mutex log_mutex;
@@ -74,6 +86,9 @@ class GCodeSender : private boost::noncopyable {
     void set_baud_rate(unsigned int baud_rate);
     void set_error_status(bool e);
     void do_send();
+    bool fits(const std::string &full_line) const;
+    void on_ok();
+    void on_resend(size_t line_number);
     void on_write(const boost::system::error_code& error, size_t bytes_transferred);
     void do_close();
     void do_read();
@@ -14,6 +14,25 @@
 
 namespace Slic3r {
 
+GCodeWriter::GCodeWriter(const GCodeWriter &other)
+    : config(other.config), multiple_extruders(other.multiple_extruders),
+        _extrusion_axis(other._extrusion_axis), _extruder(NULL),
+        _last_acceleration(other._last_acceleration), _last_fan_speed(other._last_fan_speed),
+        _lifted(other._lifted), _pos(other._pos)
+{
+    // extruders refer to the config of their writer
+    for (std::map<unsigned int,Extruder>::const_iterator it = other.extruders.begin(); it != other.extruders.end(); ++it) {
+        Extruder extruder(it->first, &this->config);
+        extruder.E              = it->second.E;
+        extruder.absolute_E     = it->second.absolute_E;
+        extruder.retracted      = it->second.retracted;
+        extruder.restart_extra  = it->second.restart_extra;
+        this->extruders.insert(std::make_pair(it->first, extruder));
+    }
+    if (other._extruder != NULL)
+        this->_extruder = &this->extruders.find(other._extruder->id)->second;
+}
+
 void
 GCodeWriter::apply_print_config(const PrintConfig &print_config)
 {
@@ -314,6 +333,22 @@ GCodeWriter::toolchange(unsigned int extruder_id)
     return gcode.str();
 }
 
+void
+GCodeWriter::continue_from(const GCodeWriter &other)
+{
+    this->_pos      = other._pos;
+    this->_lifted   = other._lifted;
+    if (other._last_acceleration != 0)
+        this->_last_acceleration = other._last_acceleration;
+    
+    if (this->_extruder != NULL && other._extruder != NULL) {
+        this->_extruder->E              = other._extruder->E;
+        this->_extruder->retracted      = other._extruder->retracted;
+        this->_extruder->restart_extra  = other._extruder->restart_extra;
+        this->_extruder->absolute_E    += other._extruder->absolute_E;
+    }
+}
+
 std::string
 GCodeWriter::set_speed(double F, const std::string &comment,
                        const std::string &cooling_marker) const
@@ -19,6 +19,7 @@ public:
         : multiple_extruders(false), _extrusion_axis("E"), _extruder(NULL),
             _last_acceleration(0), _last_fan_speed(0), _lifted(0)
         {};
+    GCodeWriter(const GCodeWriter &other);
     Extruder* extruder() const { return this->_extruder; }
     std::string extrusion_axis() const { return this->_extrusion_axis; }
     void apply_print_config(const PrintConfig &print_config);
@@ -51,6 +52,9 @@ public:
     std::string lift();
     std::string unlift();
     Pointf3 get_position() const { return this->_pos; }
+    /// Takes over the state reached by another writer, started afresh with
+    /// the same extruder, whose output is appended to ours.
+    void continue_from(const GCodeWriter &other);
 private:
     std::string _extrusion_axis;
     Extruder* _extruder;
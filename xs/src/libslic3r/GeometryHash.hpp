@@ -0,0 +1,85 @@
+#ifndef slic3r_GeometryHash_hpp_
+#define slic3r_GeometryHash_hpp_
+
+#include "libslic3r.h"
+#include "ExPolygon.hpp"
+#include <cstdint>
+#include <cstring>
+
+namespace Slic3r {
+
+/// Content hashes of planar geometry (64 bit FNV-1a), used to detect repeated
+/// inputs across layers. Only X and Y are hashed; callers that need an exact
+/// match must still compare the actual geometry.
+namespace GeometryHash {
+
+const uint64_t SEED = 14695981039346656037ULL;
+
+inline void
+combine(uint64_t &seed, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) {
+        seed ^= (value >> (i * 8)) & 0xff;
+        seed *= 1099511628211ULL;
+    }
+}
+
+inline void
+combine(uint64_t &seed, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    combine(seed, bits);
+}
+
+inline void
+combine(uint64_t &seed, const Points &points)
+{
+    combine(seed, uint64_t(points.size()));
+    for (const Point &p : points) {
+        combine(seed, uint64_t(p.x));
+        combine(seed, uint64_t(p.y));
+    }
+}
+
+inline void
+combine(uint64_t &seed, const ExPolygon &expolygon)
+{
+    combine(seed, expolygon.contour.points);
+    combine(seed, uint64_t(expolygon.holes.size()));
+    for (const Polygon &hole : expolygon.holes)
+        combine(seed, hole.points);
+}
+
+inline void
+combine(uint64_t &seed, const ExPolygons &expolygons)
+{
+    combine(seed, uint64_t(expolygons.size()));
+    for (const ExPolygon &expolygon : expolygons)
+        combine(seed, expolygon);
+}
+
+inline bool
+equal(const ExPolygon &a, const ExPolygon &b)
+{
+    if (a.contour.points != b.contour.points || a.holes.size() != b.holes.size())
+        return false;
+    for (size_t i = 0; i < a.holes.size(); ++i)
+        if (a.holes[i].points != b.holes[i].points) return false;
+    return true;
+}
+
+inline bool
+equal(const ExPolygons &a, const ExPolygons &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (!equal(a[i], b[i])) return false;
+    return true;
+}
+
+}
+
+}
+
+#endif
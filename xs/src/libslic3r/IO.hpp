@@ -30,7 +30,7 @@ class AMF
 {
     public:
     static bool read(std::string input_file, Model* model);
-    static bool write(Model& model, std::string output_file);
+    static bool write(Model& model, std::string output_file, bool compressed = false);
 };
 
 class POV
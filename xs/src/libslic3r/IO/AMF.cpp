@@ -1,9 +1,13 @@
 #include "../IO.hpp"
+#include "FastFloat.hpp"
+#include "../../Zip/ZipArchive.hpp"
 #include <iostream>
 #include <fstream>
 #include <string.h>
 #include <map>
 #include <string>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/move/move.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/iostream.hpp>
@@ -333,9 +337,9 @@ void AMFParserContext::endElement(const char *name)
     case NODE_TYPE_VERTEX:
         assert(m_object);
         // Parse the vertex data
-        m_object_vertices.push_back(atof(m_value[0].c_str()));
-        m_object_vertices.push_back(atof(m_value[1].c_str()));
-        m_object_vertices.push_back(atof(m_value[2].c_str()));
+        m_object_vertices.push_back(fast_atof(m_value[0].c_str()));
+        m_object_vertices.push_back(fast_atof(m_value[1].c_str()));
+        m_object_vertices.push_back(fast_atof(m_value[2].c_str()));
         m_value[0].clear();
         m_value[1].clear();
         m_value[2].clear();
@@ -447,62 +451,119 @@ void AMFParserContext::endDocument()
     }
 }
 
-bool
-AMF::read(std::string input_file, Model* model)
+// Feeds a chunk of the document to expat, reporting parse errors.
+static bool
+_parse_chunk(XML_Parser parser, const char* data, size_t size, bool is_final)
 {
-    XML_Parser parser = XML_ParserCreate(NULL); // encoding
-    if (! parser) {
-        printf("Couldn't allocate memory for parser\n");
+    if (XML_Parse(parser, data, int(size), is_final) == XML_STATUS_ERROR) {
+        printf("AMF parser: Parse error at line %lu:\n%s\n",
+              XML_GetCurrentLineNumber(parser),
+              XML_ErrorString(XML_GetErrorCode(parser)));
         return false;
     }
-    
+    return true;
+}
+
+// Compressed AMF files are zip archives holding the XML document,
+// detected by the signature of their first local file header.
+static bool
+_is_zip(const std::string &input_file)
+{
+    boost::nowide::ifstream fin(input_file, std::ios::in | std::ios::binary);
+    char signature[4];
+    return fin.read(signature, sizeof(signature)) && memcmp(signature, "PK\x03\x04", sizeof(signature)) == 0;
+}
+
+// Streams the inflated document into expat without extracting it to disk.
+// The archive should hold a single file; if there are several, the first
+// one with the .amf extension is read.
+static bool
+_read_zipped(const std::string &input_file, XML_Parser parser)
+{
+    ZipArchive zip(input_file, 'R');
+    if (!zip.z_stats()) {
+        boost::nowide::cerr << "Cannot open file: " << input_file << std::endl;
+        return false;
+    }
+
+    const std::vector<std::string> entries = zip.entries();
+    if (entries.empty()) {
+        printf("AMF parser: The archive contains no file\n");
+        return false;
+    }
+    std::string entry = entries.front();
+    for (const std::string &path : entries) {
+        if (boost::iequals(boost::filesystem::path(path).extension().string(), ".amf")) {
+            entry = path;
+            break;
+        }
+    }
+
+    bool parsed = true;
+    const bool extracted = zip.extract_entry(entry, [parser, &parsed](const char* data, size_t size) {
+        parsed = _parse_chunk(parser, data, size, false);
+        return parsed;
+    });
+    if (!parsed) return false;
+    if (!extracted) {
+        printf("AMF parser: Read error\n");
+        return false;
+    }
+    return _parse_chunk(parser, nullptr, 0, true);
+}
+
+static bool
+_read_plain(const std::string &input_file, XML_Parser parser)
+{
     boost::nowide::ifstream fin(input_file, std::ios::in);
     if (!fin.is_open()) {
         boost::nowide::cerr << "Cannot open file: " << input_file << std::endl;
         return false;
     }
 
-    AMFParserContext ctx(parser, model);
-    XML_SetUserData(parser, (void*)&ctx);
-    XML_SetElementHandler(parser, AMFParserContext::startElement, AMFParserContext::endElement);
-    XML_SetCharacterDataHandler(parser, AMFParserContext::characters);
-
     char buff[8192];
-    bool result = false;
     while (!fin.eof()) {
-		fin.read(buff, sizeof(buff));
+        fin.read(buff, sizeof(buff));
         if (fin.bad()) {
             printf("AMF parser: Read error\n");
-            break;
-        }
-        if (XML_Parse(parser, buff, fin.gcount(), fin.eof()) == XML_STATUS_ERROR) {
-            printf("AMF parser: Parse error at line %lu:\n%s\n",
-                  XML_GetCurrentLineNumber(parser),
-                  XML_ErrorString(XML_GetErrorCode(parser)));
-            break;
-        }
-        if (fin.eof()) {
-            result = true;
-            break;
+            return false;
         }
+        if (!_parse_chunk(parser, buff, fin.gcount(), fin.eof()))
+            return false;
     }
+    return true;
+}
+
+bool
+AMF::read(std::string input_file, Model* model)
+{
+    XML_Parser parser = XML_ParserCreate(NULL); // encoding
+    if (! parser) {
+        printf("Couldn't allocate memory for parser\n");
+        return false;
+    }
+
+    AMFParserContext ctx(parser, model);
+    XML_SetUserData(parser, (void*)&ctx);
+    XML_SetElementHandler(parser, AMFParserContext::startElement, AMFParserContext::endElement);
+    XML_SetCharacterDataHandler(parser, AMFParserContext::characters);
+
+    const bool result = _is_zip(input_file)
+        ? _read_zipped(input_file, parser)
+        : _read_plain(input_file, parser);
 
     XML_ParserFree(parser);
-    fin.close();
 
     if (result)
         ctx.endDocument();
     return result;
 }
 
-bool
-AMF::write(Model& model, std::string output_file)
+static void
+_write(Model& model, std::ostream &file)
 {
     using namespace std;
     
-    boost::nowide::ofstream file;
-    file.open(output_file, ios::out | ios::trunc);
-    
     file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << endl
          << "<amf unit=\"millimeter\">" << endl
          << "  <metadata type=\"cad\">Slic3r " << SLIC3R_VERSION << "</metadata>" << endl;
@@ -611,9 +672,28 @@ AMF::write(Model& model, std::string output_file)
              << "  </constellation>" << endl;
     
     file << "</amf>" << endl;
-    
-    file.close();
-    return true;
+}
+
+bool
+AMF::write(Model& model, std::string output_file, bool compressed)
+{
+    if (!compressed) {
+        boost::nowide::ofstream file;
+        file.open(output_file, std::ios::out | std::ios::trunc);
+        _write(model, file);
+        file.close();
+        return true;
+    }
+
+    // The document is deflated in memory and stored as the only entry
+    // of the archive, named after the output file.
+    ZipDeflateStream stream;
+    _write(model, stream);
+
+    ZipArchive zip(output_file, 'W');
+    if (!zip.z_stats()) return false;
+    const bool added = zip.add_entry(boost::filesystem::path(output_file).filename().string(), stream);
+    return zip.finalize() && added;
 }
 
 } }
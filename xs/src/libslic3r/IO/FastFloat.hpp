@@ -0,0 +1,80 @@
+#ifndef slic3r_IO_FastFloat_hpp_
+#define slic3r_IO_FastFloat_hpp_
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace Slic3r { namespace IO {
+
+/// Drop-in replacement for atof() when parsing the numbers of model files.
+/// Plain decimal numbers with at most 19 significant digits and a decimal
+/// exponent within +-22 are converted with a single exact floating point
+/// operation, which gives the correctly rounded result; anything else
+/// (longer mantissas, large exponents, hex, inf, nan) is left to strtod().
+/// The result is thus always the one of atof() in the C locale.
+inline double
+fast_atof(const char *str)
+{
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *p = str;
+    while (*p == ' ' || (*p >= '\t' && *p <= '\r'))
+        ++p;
+    const bool negative = (*p == '-');
+    if (*p == '-' || *p == '+')
+        ++p;
+
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    for (; *p >= '0' && *p <= '9'; ++p) {
+        has_digits = true;
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa != 0 && ++significant_digits > 19)
+            return strtod(str, nullptr);
+    }
+    if (*p == '.') {
+        for (++p; *p >= '0' && *p <= '9'; ++p) {
+            has_digits = true;
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0 && ++significant_digits > 19)
+                return strtod(str, nullptr);
+            --exponent;
+        }
+    }
+    // no digits at all, or a hexadecimal number
+    if (!has_digits || *p == 'x' || *p == 'X')
+        return strtod(str, nullptr);
+
+    if (*p == 'e' || *p == 'E') {
+        const char *q = p + 1;
+        const bool negative_exponent = (*q == '-');
+        if (*q == '-' || *q == '+')
+            ++q;
+        // without digits the exponent is not part of the number
+        if (*q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; *q >= '0' && *q <= '9'; ++q) {
+                e = e * 10 + (*q - '0');
+                if (e > 1000)
+                    return strtod(str, nullptr);
+            }
+            exponent += negative_exponent ? -e : e;
+        }
+    }
+
+    // doubles represent integers up to 2^53 exactly
+    if (mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+        return strtod(str, nullptr);
+    double value = double(mantissa);
+    value = (exponent < 0) ? value / pow10[-exponent] : value * pow10[exponent];
+    return negative ? -value : value;
+}
+
+} }
+
+#endif
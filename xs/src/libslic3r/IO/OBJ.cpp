@@ -0,0 +1,312 @@
+#include "../IO.hpp"
+#include "FastFloat.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/version.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/nowide/convert.hpp>
+
+namespace Slic3r { namespace IO {
+
+// Size of the slices of the file handed to the worker threads.
+static const size_t OBJ_CHUNK_SIZE = 4 * 1024 * 1024;
+
+static inline bool
+_is_space(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+static inline bool
+_is_newline(char c)
+{
+    return c == '\n' || c == '\r';
+}
+
+// What a chunk of the file contributes to the model. Vertex indices are
+// stored zero-based; relative (negative) indices can't be resolved before
+// the number of vertices of the previous chunks is known, so they're stored
+// relative to the first vertex of the chunk and listed in relative_indices.
+struct OBJChunk
+{
+    const char*         begin;
+    const char*         end;
+    std::vector<float>  vertices;
+    std::vector<int>    indices;            ///< three per triangle
+    std::vector<size_t> relative_indices;   ///< positions in indices
+    std::vector<size_t> breaks;             ///< triangle counts at g/o lines
+    size_t              vertices_offset;
+    size_t              triangles_offset;
+    bool                valid;              ///< false if an index is out of range
+
+    OBJChunk(const char* begin, const char* end)
+        : begin(begin), end(end), vertices_offset(0), triangles_offset(0), valid(true) {};
+};
+
+// Wavefront OBJ reader following the tiny_obj_loader semantics for the
+// subset we use: vertices, faces (triangulated as fans) and g/o lines,
+// which start a new volume. Lines of the file never span two chunks,
+// and every chunk ends with a line terminator.
+struct OBJParserContext
+{
+    std::vector<OBJChunk>   chunks;
+    std::vector<float>      vertices;
+    std::vector<size_t>     volumes;            ///< first triangle of each volume, plus the end
+    std::vector<stl_file*>  volume_stl;
+
+    /// Splits data into chunks of about OBJ_CHUNK_SIZE bytes at line ends.
+    void split(const char* data, size_t size);
+
+    void parse_chunk(size_t idx);
+    void copy_vertices(size_t idx);
+    void make_facets(size_t idx);
+};
+
+void
+OBJParserContext::parse_chunk(size_t idx)
+{
+    OBJChunk &chunk = this->chunks[idx];
+    chunk.vertices.reserve((chunk.end - chunk.begin) / 16);
+    chunk.indices.reserve((chunk.end - chunk.begin) / 8);
+
+    std::vector<int> face;
+    std::vector<bool> face_relative;
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        // skip leading spaces
+        while (_is_space(*p)) ++p;
+        const char* eol = p;
+        while (!_is_newline(*eol)) ++eol;
+
+        if (p[0] == 'v' && _is_space(p[1])) {
+            p += 2;
+            // missing coordinates default to zero
+            for (int i = 0; i < 3; ++i) {
+                while (_is_space(*p)) ++p;
+                if (_is_newline(*p)) {
+                    chunk.vertices.push_back(0.f);
+                    continue;
+                }
+                chunk.vertices.push_back(float(fast_atof(p)));
+                while (!_is_space(*p) && !_is_newline(*p)) ++p;
+            }
+        } else if (p[0] == 'f' && _is_space(p[1])) {
+            p += 2;
+            face.clear();
+            face_relative.clear();
+            while (true) {
+                while (_is_space(*p)) ++p;
+                if (_is_newline(*p)) break;
+                // i, i/j, i//k or i/j/k: only the vertex index matters
+                const bool negative = (*p == '-');
+                if (*p == '-' || *p == '+') ++p;
+                int value = 0;
+                for (; *p >= '0' && *p <= '9'; ++p)
+                    if (value < 100000000) value = value * 10 + (*p - '0');
+                while (!_is_space(*p) && !_is_newline(*p)) ++p;
+
+                const bool relative = negative && value > 0;
+                face.push_back(relative ? int(chunk.vertices.size() / 3) - value
+                    : (value > 0 ? value - 1 : 0));
+                face_relative.push_back(relative);
+            }
+            // triangle fan
+            for (size_t k = 2; k < face.size(); ++k) {
+                const size_t corners[3] = { 0, k-1, k };
+                for (size_t c : corners) {
+                    if (face_relative[c])
+                        chunk.relative_indices.push_back(chunk.indices.size());
+                    chunk.indices.push_back(face[c]);
+                }
+            }
+        } else if ((p[0] == 'g' || p[0] == 'o') && _is_space(p[1])) {
+            chunk.breaks.push_back(chunk.indices.size() / 3);
+        }
+
+        // skip to the next line
+        p = eol;
+        while (p < chunk.end && _is_newline(*p)) ++p;
+    }
+}
+
+void
+OBJParserContext::split(const char* data, size_t size)
+{
+    const char* end = data + size;
+    // the last line gets its terminator in parse()
+    while (end > data && !_is_newline(end[-1])) --end;
+
+    const char* begin = data;
+    while (begin < end) {
+        const char* chunk_end = (size_t(end - begin) > OBJ_CHUNK_SIZE) ? begin + OBJ_CHUNK_SIZE : end;
+        while (chunk_end < end && !_is_newline(chunk_end[-1])) ++chunk_end;
+        this->chunks.push_back(OBJChunk(begin, chunk_end));
+        begin = chunk_end;
+    }
+}
+
+void
+OBJParserContext::copy_vertices(size_t idx)
+{
+    OBJChunk &chunk = this->chunks[idx];
+    std::copy(chunk.vertices.begin(), chunk.vertices.end(),
+        this->vertices.begin() + chunk.vertices_offset * 3);
+
+    for (size_t i : chunk.relative_indices)
+        chunk.indices[i] += int(chunk.vertices_offset);
+    const int vertices_count = int(this->vertices.size() / 3);
+    for (int i : chunk.indices)
+        if (i < 0 || i >= vertices_count) chunk.valid = false;
+
+    std::vector<float>().swap(chunk.vertices);
+}
+
+void
+OBJParserContext::make_facets(size_t idx)
+{
+    const OBJChunk &chunk = this->chunks[idx];
+    const size_t triangles = chunk.indices.size() / 3;
+    if (triangles == 0) return;
+
+    // volume holding the first triangle of the chunk
+    size_t volume_idx = std::upper_bound(this->volumes.begin(), this->volumes.end(),
+        chunk.triangles_offset) - this->volumes.begin() - 1;
+    for (size_t i = 0; i < triangles; ++i) {
+        const size_t t = chunk.triangles_offset + i;
+        while (t >= this->volumes[volume_idx + 1]) ++volume_idx;
+        // the facets were zeroed by stl_allocate(), so the normal and
+        // the extra bytes are already set
+        stl_facet &facet = this->volume_stl[volume_idx]->facet_start[t - this->volumes[volume_idx]];
+        for (int j = 0; j < 3; ++j)
+            memcpy(&facet.vertex[j].x, &this->vertices[size_t(chunk.indices[i*3 + j]) * 3], 3 * sizeof(float));
+    }
+}
+
+bool
+OBJ::read(std::string input_file, TriangleMesh* mesh)
+{
+    Model model;
+    OBJ::read(input_file, &model);
+    *mesh = model.mesh();
+    
+    return true;
+}
+
+bool
+OBJ::read(std::string input_file, Model* model)
+{
+    // The file is memory-mapped and parsed in chunks by parallel threads;
+    // facets are then written straight into the meshes of the volumes.
+    // non-ASCII paths need the wide character API on Windows, as in stl_open();
+    // Boost.Interprocess only has it since 1.77
+#if defined(_WIN32) && BOOST_VERSION >= 107700
+    const std::wstring path = boost::nowide::widen(input_file);
+#else
+    const std::string &path = input_file;
+#endif
+    boost::system::error_code ec;
+    const uintmax_t size = boost::filesystem::file_size(path, ec);
+    if (ec)
+        throw std::runtime_error("Error while reading OBJ file");
+
+    OBJParserContext ctx;
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+    std::string last_line;
+    if (size > 0) {
+        try {
+            boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only).swap(file);
+            boost::interprocess::mapped_region(file, boost::interprocess::read_only).swap(region);
+        } catch (const boost::interprocess::interprocess_exception &) {
+            throw std::runtime_error("Error while reading OBJ file");
+        }
+        const char* data = static_cast<const char*>(region.get_address());
+        ctx.split(data, region.get_size());
+
+        // a last line without terminator is parsed from a copy
+        const char* parsed_end = ctx.chunks.empty() ? data : ctx.chunks.back().end;
+        if (parsed_end < data + region.get_size()) {
+            last_line.assign(parsed_end, data + region.get_size());
+            last_line += '\n';
+            ctx.chunks.push_back(OBJChunk(last_line.data(), last_line.data() + last_line.size()));
+        }
+    }
+
+    std::vector<size_t> breaks;
+    size_t vertices_count = 0, triangles_count = 0;
+    if (!ctx.chunks.empty()) {
+        parallelize<size_t>(
+            0,
+            ctx.chunks.size()-1,
+            boost::bind(&OBJParserContext::parse_chunk, &ctx, _1)
+        );
+
+        for (OBJChunk &chunk : ctx.chunks) {
+            chunk.vertices_offset   = vertices_count;
+            chunk.triangles_offset  = triangles_count;
+            for (size_t b : chunk.breaks)
+                breaks.push_back(triangles_count + b);
+            vertices_count  += chunk.vertices.size() / 3;
+            triangles_count += chunk.indices.size() / 3;
+        }
+
+        ctx.vertices.resize(vertices_count * 3);
+        parallelize<size_t>(
+            0,
+            ctx.chunks.size()-1,
+            boost::bind(&OBJParserContext::copy_vertices, &ctx, _1)
+        );
+        for (const OBJChunk &chunk : ctx.chunks)
+            if (!chunk.valid)
+                throw std::runtime_error("Error while reading OBJ file");
+    }
+
+    ModelObject* object = model->add_object();
+    object->name        = boost::filesystem::path(input_file).filename().string();
+    object->input_file  = input_file;
+
+    // Each g or o line starts a new volume, unless no facets were read
+    // since the previous one.
+    breaks.push_back(triangles_count);
+    size_t start = 0;
+    for (size_t b : breaks) {
+        if (b > start) ctx.volumes.push_back(start);
+        start = b;
+    }
+    ctx.volumes.push_back(triangles_count);
+
+    for (size_t i = 0; i + 1 < ctx.volumes.size(); ++i) {
+        ModelVolume* volume = object->add_volume(TriangleMesh());
+        volume->name        = object->name;
+
+        stl_file &stl = volume->mesh.stl;
+        stl.stats.type = inmemory;
+        stl.stats.number_of_facets = int(ctx.volumes[i+1] - ctx.volumes[i]);
+        stl.stats.original_num_facets = stl.stats.number_of_facets;
+        stl_allocate(&stl);
+        ctx.volume_stl.push_back(&stl);
+    }
+
+    if (!ctx.volume_stl.empty()) {
+        parallelize<size_t>(
+            0,
+            ctx.chunks.size()-1,
+            boost::bind(&OBJParserContext::make_facets, &ctx, _1)
+        );
+    }
+
+    for (ModelVolume* volume : object->volumes) {
+        stl_get_size(&volume->mesh.stl);
+        volume->mesh.check_topology();
+    }
+
+    return true;
+}
+
+} }
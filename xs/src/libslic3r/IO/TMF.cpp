@@ -5,10 +5,7 @@ namespace Slic3r { namespace IO {
 bool
 TMFEditor::write_types()
 {
-    // Create a new .[Content_Types].xml file to add to the zip file later.
-    boost::nowide::ofstream fout(".[Content_Types].xml", std::ios::out | std::ios::trunc);
-    if(!fout.is_open())
-        return false;
+    ZipDeflateStream fout;
 
     // Write 3MF Types.
     fout << "<?xml version=\"1.0\" encoding=\"UTF-8\"?> \n";
@@ -16,51 +13,30 @@ TMFEditor::write_types()
     fout << "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>\n";
     fout << "<Default Extension=\"model\" ContentType=\"application/vnd.ms-package.3dmanufacturing-3dmodel+xml\"/>\n";
     fout << "</Types>\n";
-    fout.close();
 
     // Create [Content_Types].xml in the zip archive.
-    if(!zip_archive->add_entry("[Content_Types].xml", ".[Content_Types].xml"))
-        return false;
-
-    // Remove the created .[Content_Types].xml file.
-    if (remove(".[Content_Types].xml") != 0)
-        return false;
-
-    return true;
+    return zip_archive->add_entry("[Content_Types].xml", fout);
 }
 
 bool
 TMFEditor::write_relationships()
 {
-    // Create a new .rels file to add to the zip file later.
-    boost::nowide::ofstream fout(".rels", std::ios::out | std::ios::trunc);
-    if(!fout.is_open())
-        return false;
+    ZipDeflateStream fout;
 
     // Write the primary 3dmodel relationship.
     fout << "<?xml version=\"1.0\" encoding=\"UTF-8\"?> \n"
                           << "<Relationships xmlns=\"" << namespaces.at("relationships") <<
                   "\">\n<Relationship Id=\"rel0\" Target=\"/3D/3dmodel.model\" Type=\"http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel\" /></Relationships>\n";
-    fout.close();
 
     // Create .rels in "_rels" folder in the zip archive.
-    if(!zip_archive->add_entry("_rels/.rels", ".rels"))
-        return false;
-
-    // Remove the created .rels file.
-    if (remove(".rels") != 0)
-        return false;
-
-    return true;
+    return zip_archive->add_entry("_rels/.rels", fout);
 }
 
 bool
 TMFEditor::write_model()
 {
-    // Create a new .3dmodel.model file to add to the zip file later.
-    boost::nowide::ofstream fout(".3dmodel.model", std::ios::out | std::ios::trunc);
-    if(!fout.is_open())
-        return false;
+    // The model is deflated as it is written, only the compressed data is buffered.
+    ZipDeflateStream fout;
 
     // Add the XML document header.
     fout << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
@@ -89,21 +65,13 @@ TMFEditor::write_model()
 
     // Close the model element.
     fout << "</model>\n";
-    fout.close();
 
     // Create .3dmodel.model in "3D" folder in the zip archive.
-    if(!zip_archive->add_entry("3D/3dmodel.model", ".3dmodel.model"))
-        return false;
-
-    // Remove the created .rels file.
-    if (remove(".3dmodel.model") != 0)
-        return false;
-
-    return true;
+    return zip_archive->add_entry("3D/3dmodel.model", fout);
 }
 
 bool
-TMFEditor::write_metadata(boost::nowide::ofstream& fout)
+TMFEditor::write_metadata(std::ostream& fout)
 {
     // Write the model metadata.
     for (const auto metadata : model->metadata){
@@ -117,7 +85,7 @@ TMFEditor::write_metadata(boost::nowide::ofstream& fout)
 }
 
 bool
-TMFEditor::write_object(boost::nowide::ofstream& fout, const ModelObject* object, int index)
+TMFEditor::write_object(std::ostream& fout, const ModelObject* object, int index)
 {
     // Create the new object element.
     fout << "        <object id=\"" << (index + object_id) << "\" type=\"model\"";
@@ -234,7 +202,7 @@ TMFEditor::write_object(boost::nowide::ofstream& fout, const ModelObject* object
 }
 
 bool
-TMFEditor::write_build(boost::nowide::ofstream& fout)
+TMFEditor::write_build(std::ostream& fout)
 {
     // Create build element.
     fout << "    <build> \n";
@@ -284,56 +252,40 @@ TMFEditor::write_build(boost::nowide::ofstream& fout)
 bool
 TMFEditor::read_model()
 {
-    // Extract 3dmodel.model entry.
-    if(!zip_archive->extract_entry("3D/3dmodel.model", "3dmodel.model"))
-        return false;
-
-    // Read 3D/3dmodel.model file.
     XML_Parser parser = XML_ParserCreate(NULL);
     if (! parser) {
         std::cout << ("Couldn't allocate memory for parser\n");
         return false;
     }
 
-    boost::nowide::ifstream fin("3dmodel.model", std::ios::in);
-    if (!fin.is_open()) {
-        boost::nowide::cerr << "Cannot open file: " << "3dmodel.model" << std::endl;
-        return false;
-    }
-
     // Create model parser.
     TMFParserContext ctx(parser, model);
     XML_SetUserData(parser, (void*)&ctx);
     XML_SetElementHandler(parser, TMFParserContext::startElement, TMFParserContext::endElement);
     XML_SetCharacterDataHandler(parser, TMFParserContext::characters);
 
-    char buff[8192];
-    bool result = false;
-    while (!fin.eof()) {
-        fin.read(buff, sizeof(buff));
-        if (fin.bad()) {
-            printf("3MF model parser: Read error\n");
-            break;
-        }
-        if (XML_Parse(parser, buff, fin.gcount(), fin.eof()) == XML_STATUS_ERROR) {
-            printf("3MF model parser: Parse error at line %lu:\n%s\n",
-                   XML_GetCurrentLineNumber(parser),
-                   XML_ErrorString(XML_GetErrorCode(parser)));
-            break;
-        }
-        if (fin.eof()) {
-            result = true;
-            break;
+    // Inflate 3D/3dmodel.model straight into the parser.
+    bool parse_error = false;
+    bool result = zip_archive->extract_entry("3D/3dmodel.model", [parser, &parse_error](const char* data, size_t size) {
+        if (XML_Parse(parser, data, int(size), 0) == XML_STATUS_ERROR) {
+            parse_error = true;
+            return false;
         }
+        return true;
+    });
+    if (result && XML_Parse(parser, nullptr, 0, 1) == XML_STATUS_ERROR)
+        parse_error = true;
+    if (parse_error) {
+        printf("3MF model parser: Parse error at line %lu:\n%s\n",
+               XML_GetCurrentLineNumber(parser),
+               XML_ErrorString(XML_GetErrorCode(parser)));
+        result = false;
+    } else if (!result) {
+        printf("3MF model parser: Read error\n");
     }
 
-    // Free the parser and close the file.
+    // Free the parser.
     XML_ParserFree(parser);
-    fin.close();
-
-    // Remove the extracted 3dmodel.model file.
-    if (remove("3dmodel.model") != 0)
-        return false;
 
     if (result)
         ctx.endDocument();
@@ -605,9 +557,9 @@ TMFParserContext::startElement(const char *name, const char **atts)
                 const char* z = get_attribute(atts, "z");
                 if ( !x || !y || !z)
                     this->stop();
-                m_object_vertices.push_back(atof(x));
-                m_object_vertices.push_back(atof(y));
-                m_object_vertices.push_back(atof(z));
+                m_object_vertices.push_back(fast_atof(x));
+                m_object_vertices.push_back(fast_atof(y));
+                m_object_vertices.push_back(fast_atof(z));
                 node_type_new = NODE_TYPE_VERTEX;
             } else if (strcmp(name, "triangle") == 0) {
                 const char* v1 = get_attribute(atts, "v1");
@@ -3,6 +3,7 @@
 
 #include "../IO.hpp"
 #include "../Zip/ZipArchive.hpp"
+#include "FastFloat.hpp"
 #include <cstdio>
 #include <string>
 #include <cstring>
@@ -11,7 +12,6 @@
 #include <algorithm>
 #include <cmath>
 #include <boost/move/move.hpp>
-#include <boost/nowide/fstream.hpp>
 #include <boost/nowide/iostream.hpp>
 #include <expat/expat.h>
 
@@ -58,17 +58,17 @@ private:
     bool write_model();
 
     /// Write the metadata of the model. This function is called by writeModel() function.
-    bool write_metadata(boost::nowide::ofstream& fout);
+    bool write_metadata(std::ostream& fout);
 
     /// Write object of the current model. This function is called by writeModel() function.
-    /// \param fout boost::nowide::ofstream& fout output stream.
+    /// \param fout std::ostream& fout output stream.
     /// \param object ModelObject* a pointer to the object to be written.
     /// \param index int the index of the object to be read
     /// \return bool 1: write operation is successful , otherwise not.
-    bool write_object(boost::nowide::ofstream& fout, const ModelObject* object, int index);
+    bool write_object(std::ostream& fout, const ModelObject* object, int index);
 
     /// Write the build element.
-    bool write_build(boost::nowide::ofstream& fout);
+    bool write_build(std::ostream& fout);
 
     /// Read the Model.
     bool read_model();
@@ -1,6 +1,7 @@
 #include "Layer.hpp"
 #include "ClipperUtils.hpp"
 #include "Geometry.hpp"
+#include "GeometryHash.hpp"
 #include "Print.hpp"
 
 namespace Slic3r {
@@ -17,6 +18,9 @@ Layer::Layer(size_t id, PrintObject *object, coordf_t height, coordf_t print_z,
     print_z(print_z),
     height(height),
     slices(),
+    motion_planner(NULL),
+    perimeters_source(NULL),
+    fills_source(NULL),
     _id(id),
     _object(object)
 {
@@ -35,6 +39,7 @@ Layer::~Layer()
     }
 
     this->clear_regions();
+    delete this->motion_planner;
 }
 
 /// Getter for this->_id
@@ -95,12 +100,12 @@ Layer::make_slices()
         // optimization: if we only have one region, take its slices
         slices = this->regions.front()->slices;
     } else {
-        Polygons slices_p;
+        ClipperLib::Paths slices_p;
         FOREACH_LAYERREGION(this, layerm) {
-            Polygons region_slices_p = (*layerm)->slices;
-            slices_p.insert(slices_p.end(), region_slices_p.begin(), region_slices_p.end());
+            for (const Surface &surface : (*layerm)->slices.surfaces)
+                Slic3rExPolygon_to_ClipperPaths(surface.expolygon, &slices_p);
         }
-        slices = union_ex(slices_p);
+        slices = _clipper_ex(ClipperLib::ctUnion, std::move(slices_p), ClipperLib::Paths());
     }
 
     this->slices.expolygons.clear();
@@ -261,6 +266,171 @@ Layer::make_fills()
     }
 }
 
+/// Layers holding nonplanar surfaces are never considered identical since
+/// their paths get projected on the mesh afterwards.
+bool
+Layer::has_nonplanar_surfaces() const
+{
+    for (const LayerRegion* layerm : this->regions) {
+        if (!layerm->nonplanar_surfaces.empty()) return true;
+        for (const Surface &s : layerm->slices.surfaces)
+            if (s.is_nonplanar()) return true;
+        for (const Surface &s : layerm->fill_surfaces.surfaces)
+            if (s.is_nonplanar()) return true;
+    }
+    return false;
+}
+
+static void
+_hash_surfaces(uint64_t &seed, const Surfaces &surfaces)
+{
+    GeometryHash::combine(seed, uint64_t(surfaces.size()));
+    for (const Surface &s : surfaces) {
+        GeometryHash::combine(seed, uint64_t(s.surface_type));
+        GeometryHash::combine(seed, uint64_t(s.extra_perimeters));
+        GeometryHash::combine(seed, uint64_t(s.thickness_layers));
+        GeometryHash::combine(seed, s.thickness);
+        GeometryHash::combine(seed, s.bridge_angle);
+        GeometryHash::combine(seed, s.expolygon);
+    }
+}
+
+static bool
+_same_surfaces(const Surfaces &a, const Surfaces &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].surface_type       != b[i].surface_type
+            || a[i].extra_perimeters != b[i].extra_perimeters
+            || a[i].thickness_layers != b[i].thickness_layers
+            || a[i].thickness        != b[i].thickness
+            || a[i].bridge_angle     != b[i].bridge_angle
+            || !GeometryHash::equal(a[i].expolygon, b[i].expolygon))
+            return false;
+    }
+    return true;
+}
+
+size_t
+Layer::perimeters_inputs_hash() const
+{
+    uint64_t seed = GeometryHash::SEED;
+    GeometryHash::combine(seed, this->height);
+    GeometryHash::combine(seed, uint64_t(this->id() == 0));
+    for (const LayerRegion* layerm : this->regions)
+        _hash_surfaces(seed, layerm->slices.surfaces);
+    // overhang detection reads the islands of the layer below
+    if (this->lower_layer != NULL)
+        GeometryHash::combine(seed, this->lower_layer->slices.expolygons);
+    return size_t(seed);
+}
+
+bool
+Layer::same_perimeters_inputs(const Layer &other) const
+{
+    if (this->height != other.height
+        || (this->id() == 0) != (other.id() == 0)
+        || this->regions.size() != other.regions.size()
+        || (this->lower_layer == NULL) != (other.lower_layer == NULL)
+        || this->has_nonplanar_surfaces() || other.has_nonplanar_surfaces())
+        return false;
+    for (size_t region_id = 0; region_id < this->regions.size(); ++region_id)
+        if (!_same_surfaces(this->regions[region_id]->slices.surfaces, other.regions[region_id]->slices.surfaces))
+            return false;
+    return this->lower_layer == NULL
+        || GeometryHash::equal(this->lower_layer->slices.expolygons, other.lower_layer->slices.expolygons);
+}
+
+void
+Layer::copy_perimeters_from(const Layer &other)
+{
+    for (size_t region_id = 0; region_id < this->regions.size(); ++region_id) {
+        LayerRegion &layerm             = *this->regions[region_id];
+        const LayerRegion &other_layerm = *other.regions[region_id];
+        layerm.perimeters       = other_layerm.perimeters;
+        layerm.thin_fills       = other_layerm.thin_fills;
+        layerm.fill_surfaces    = other_layerm.fill_surfaces;
+    }
+    this->perimeters_source = &other;
+}
+
+/// Patterns whose geometry depends on the layer Z and not only on the layer index.
+static bool
+_is_z_dependent(InfillPattern pattern)
+{
+    return pattern == ipCubic || pattern == ip3DHoneycomb || pattern == ipGyroid;
+}
+
+/// Infill direction alternates with (layer_id / thickness_layers); 6 is a multiple
+/// of all the periods used by Fill::_layer_angle() implementations.
+static size_t
+_fill_phase(size_t layer_id, const Surface &surface)
+{
+    return (layer_id / std::max<unsigned short>(surface.thickness_layers, 1)) % 6;
+}
+
+size_t
+Layer::fills_inputs_hash() const
+{
+    uint64_t seed = GeometryHash::SEED;
+    GeometryHash::combine(seed, this->height);
+    GeometryHash::combine(seed, uint64_t(this->id() == 0));
+    for (const LayerRegion* layerm : this->regions) {
+        _hash_surfaces(seed, layerm->fill_surfaces.surfaces);
+        for (const Surface &s : layerm->fill_surfaces.surfaces)
+            GeometryHash::combine(seed, uint64_t(_fill_phase(this->id(), s)));
+    }
+    return size_t(seed);
+}
+
+bool
+Layer::same_fills_inputs(const Layer &other) const
+{
+    if (this->height != other.height
+        || (this->id() == 0) != (other.id() == 0)
+        || this->regions.size() != other.regions.size()
+        || this->has_nonplanar_surfaces() || other.has_nonplanar_surfaces())
+        return false;
+    for (size_t region_id = 0; region_id < this->regions.size(); ++region_id) {
+        const LayerRegion &layerm       = *this->regions[region_id];
+        const LayerRegion &other_layerm = *other.regions[region_id];
+        const PrintRegionConfig &config = layerm.region()->config;
+        if (_is_z_dependent(config.fill_pattern.value)
+            || _is_z_dependent(config.top_infill_pattern.value)
+            || _is_z_dependent(config.bottom_infill_pattern.value))
+            return false;
+        if (!_same_surfaces(layerm.fill_surfaces.surfaces, other_layerm.fill_surfaces.surfaces))
+            return false;
+        for (size_t i = 0; i < layerm.fill_surfaces.surfaces.size(); ++i)
+            if (_fill_phase(this->id(), layerm.fill_surfaces.surfaces[i])
+                != _fill_phase(other.id(), other_layerm.fill_surfaces.surfaces[i]))
+                return false;
+    }
+    return true;
+}
+
+void
+Layer::copy_fills_from(const Layer &other)
+{
+    for (size_t region_id = 0; region_id < this->regions.size(); ++region_id) {
+        LayerRegion &layerm             = *this->regions[region_id];
+        const LayerRegion &other_layerm = *other.regions[region_id];
+
+        // LayerRegion::make_fill() appends one collection per thin fill after the
+        // infill collections: copy the latter and rebuild the former from our own.
+        const size_t other_infills = other_layerm.fills.entities.size() - other_layerm.thin_fills.entities.size();
+        layerm.fills.clear();
+        for (size_t i = 0; i < other_infills; ++i)
+            layerm.fills.append(*other_layerm.fills.entities[i]);
+        for (const ExtrusionEntity* thin_fill : layerm.thin_fills.entities) {
+            ExtrusionEntityCollection* coll = new ExtrusionEntityCollection();
+            layerm.fills.entities.push_back(coll);
+            coll->append(*thin_fill);
+        }
+    }
+    this->fills_source = &other;
+}
+
 void
 Layer::project_nonplanar_surfaces()
 {
@@ -280,186 +450,197 @@ Layer::project_nonplanar_surfaces()
 /// If a part of a region is of S_TYPE_BOTTOM and S_TYPE_TOP, the S_TYPE_BOTTOM wins.
 void
 Layer::detect_surfaces_type()
+{
+    for (size_t region_id = 0; region_id < this->regions.size(); ++region_id) {
+        const Polygons upper_region_slices = (this->upper_layer != NULL)
+            ? (Polygons)this->upper_layer->get_region(region_id)->slices : Polygons();
+        const Polygons lower_region_slices = (this->lower_layer != NULL)
+            ? (Polygons)this->lower_layer->get_region(region_id)->slices : Polygons();
+        this->detect_surfaces_type(region_id, upper_region_slices, lower_region_slices);
+    }
+}
+
+/// Classifies the slices of a single region (see above).
+/// The slices of the same region in the neighbor layers are only read when
+/// interface_shells is enabled; they are supplied by the caller so that all
+/// layers and regions can be classified concurrently from a snapshot taken
+/// before any of them is rewritten.
+void
+Layer::detect_surfaces_type(size_t region_id, const Polygons &upper_region_slices,
+    const Polygons &lower_region_slices)
 {
     PrintObject &object = *this->object();
 
-    for (size_t region_id = 0; region_id < this->regions.size(); ++region_id) {
-        LayerRegion &layerm = *this->regions[region_id];
-
-        // comparison happens against the *full* slices (considering all regions)
-        // unless internal shells are requested
-
-        // We call layer->slices or layerm->slices on these neighbor layers
-        // and we convert them into Polygons so we only care about their total
-        // coverage. We only write to layerm->slices so we can read layer->slices safely.
-        Layer* const &upper_layer = this->upper_layer;
-        Layer* const &lower_layer = this->lower_layer;
-
-        // collapse very narrow parts (using the safety offset in the diff is not enough)
-        // TODO: this offset2 makes this method not idempotent (see #3764), so we should
-        // move it to where we generate fill_surfaces instead and leave slices unaltered
-        const float offs = layerm.flow(frExternalPerimeter).scaled_width() / 10.f;
-
-        const Polygons layerm_slices_surfaces = layerm.slices;
-
-        //Find mark nonplanar surfaces
-        SurfaceCollection nonplanar_surfaces;
-        for(auto& surface : layerm.nonplanar_surfaces){
-            nonplanar_surfaces.append(
-                intersection_ex(surface.horizontal_projection(),
-                union_ex(layerm_slices_surfaces)),
-                (surface.stats.max.z <= this->slice_z + this->height ? stTopNonplanar : stInternalSolidNonplanar)
-            );
-        }
-        
-        //remove non planar surfaces form all surfaces to get planar surfaces
-        Polygons planar_surfaces = diff(layerm_slices_surfaces,nonplanar_surfaces,true);
-
-        // find top surfaces (difference between current surfaces
-        // of current layer and upper one)
-        SurfaceCollection top;
-        if (upper_layer != NULL) {
-            Polygons upper_slices;
-            if (object.config.interface_shells.value) {
-                const LayerRegion* upper_layerm = upper_layer->get_region(region_id);
-                boost::lock_guard<boost::mutex> l(upper_layerm->_slices_mutex);
-                upper_slices = upper_layerm->slices;
-            } else {
-                upper_slices = upper_layer->slices;
-            }
-            //difference between all surfaces and upper surfaces subtracted by nonplanar surfaces
-            top.append(
-                offset2_ex(
-                    diff(diff(layerm_slices_surfaces, upper_slices, true),nonplanar_surfaces,true),
-                    -offs, offs
-                ),
-                stTop
-            );
+    LayerRegion &layerm = *this->regions[region_id];
+
+    // comparison happens against the *full* slices (considering all regions)
+    // unless internal shells are requested
+
+    // We call layer->slices or layerm->slices on these neighbor layers
+    // and we convert them into Polygons so we only care about their total
+    // coverage. We only write to layerm->slices so we can read layer->slices safely.
+    Layer* const &upper_layer = this->upper_layer;
+    Layer* const &lower_layer = this->lower_layer;
+
+    // collapse very narrow parts (using the safety offset in the diff is not enough)
+    // TODO: this offset2 makes this method not idempotent (see #3764), so we should
+    // move it to where we generate fill_surfaces instead and leave slices unaltered
+    const float offs = layerm.flow(frExternalPerimeter).scaled_width() / 10.f;
+
+    const Polygons layerm_slices_surfaces = layerm.slices;
+
+    //Find mark nonplanar surfaces
+    SurfaceCollection nonplanar_surfaces;
+    for(auto& surface : layerm.nonplanar_surfaces){
+        nonplanar_surfaces.append(
+            intersection_ex(surface.horizontal_projection(),
+            union_ex(layerm_slices_surfaces)),
+            (surface.stats.max.z <= this->slice_z + this->height ? stTopNonplanar : stInternalSolidNonplanar)
+        );
+    }
+    
+    //remove non planar surfaces form all surfaces to get planar surfaces
+    Polygons planar_surfaces = diff(layerm_slices_surfaces,nonplanar_surfaces,true);
+
+    // find top surfaces (difference between current surfaces
+    // of current layer and upper one)
+    SurfaceCollection top;
+    if (upper_layer != NULL) {
+        Polygons upper_slices;
+        if (object.config.interface_shells.value) {
+            upper_slices = upper_region_slices;
         } else {
-            // all planar surfaces are top surfaces1
-            top.append(
-                union_ex(planar_surfaces,true),
-                stTop
-            );
+            upper_slices = upper_layer->slices;
         }
+        //difference between all surfaces and upper surfaces subtracted by nonplanar surfaces
+        top.append(
+            offset2_ex(
+                diff(diff(layerm_slices_surfaces, upper_slices, true),nonplanar_surfaces,true),
+                -offs, offs
+            ),
+            stTop
+        );
+    } else {
+        // all planar surfaces are top surfaces1
+        top.append(
+            union_ex(planar_surfaces,true),
+            stTop
+        );
+    }
 
-        // find bottom surfaces (difference between current surfaces
-        // of current layer and lower one)
-        SurfaceCollection bottom;
-        if (lower_layer != NULL) {
-            // If we have soluble support material, don't bridge. The overhang will be squished against a soluble layer separating
-            // the support from the print.
-            const SurfaceType surface_type_bottom =
-                (object.config.support_material.value && object.config.support_material_contact_distance.value == 0)
-                ? stBottom
-                : stBottomBridge;
-
-            // Any surface lying on the void is a true bottom bridge (an overhang)
+    // find bottom surfaces (difference between current surfaces
+    // of current layer and lower one)
+    SurfaceCollection bottom;
+    if (lower_layer != NULL) {
+        // If we have soluble support material, don't bridge. The overhang will be squished against a soluble layer separating
+        // the support from the print.
+        const SurfaceType surface_type_bottom =
+            (object.config.support_material.value && object.config.support_material_contact_distance.value == 0)
+            ? stBottom
+            : stBottomBridge;
+
+        // Any surface lying on the void is a true bottom bridge (an overhang)
+        bottom.append(
+            offset2_ex(
+                diff(diff(layerm_slices_surfaces, lower_layer->slices, true),nonplanar_surfaces,true),
+                -offs, offs
+            ),
+            surface_type_bottom
+        );
+
+        // if user requested internal shells, we need to identify surfaces
+        // lying on other slices not belonging to this region
+        if (object.config.interface_shells) {
+            // non-bridging bottom surfaces: any part of this layer lying
+            // on something else, excluding those lying on our own region
             bottom.append(
                 offset2_ex(
-                    diff(diff(layerm_slices_surfaces, lower_layer->slices, true),nonplanar_surfaces,true),
-                    -offs, offs
-                ),
-                surface_type_bottom
-            );
-
-            // if user requested internal shells, we need to identify surfaces
-            // lying on other slices not belonging to this region
-            if (object.config.interface_shells) {
-                // non-bridging bottom surfaces: any part of this layer lying
-                // on something else, excluding those lying on our own region
-                const LayerRegion* lower_layerm = lower_layer->get_region(region_id);
-                boost::lock_guard<boost::mutex> l(lower_layerm->_slices_mutex);
-                bottom.append(
-                    offset2_ex(
+                    diff(
                         diff(
-                            diff(
-                                intersection(layerm_slices_surfaces, lower_layer->slices), // supported
-                                lower_layerm->slices,
-                                true
-                            ),
-                            nonplanar_surfaces,
+                            intersection(layerm_slices_surfaces, lower_layer->slices), // supported
+                            lower_region_slices,
                             true
                         ),
-                        -offs, offs
+                        nonplanar_surfaces,
+                        true
                     ),
-                    stBottom
-                );
-            }
-        } else {
-            // if no lower layer, all surfaces of this one are solid
-            // we clone surfaces because we're going to clear the slices collection
-            bottom = layerm.slices;
-
-            // if we have raft layers, consider bottom layer as a bridge
-            // just like any other bottom surface lying on the void
-            const SurfaceType surface_type_bottom =
-                (object.config.raft_layers.value > 0 && object.config.support_material_contact_distance.value > 0)
-                ? stBottomBridge
-                : stBottom;
-            for (Surface &s : bottom.surfaces) s.surface_type = surface_type_bottom;
-        }
-
-        // now, if the object contained a thin membrane, we could have overlapping bottom
-        // and top surfaces; let's do an intersection to discover them and consider them
-        // as bottom surfaces (to allow for bridge detection)
-        if (!top.empty() && !bottom.empty()) {
-            const Polygons top_polygons = to_polygons(STDMOVE(top));
-            top.clear();
-            top.append(
-                // TODO: maybe we don't need offset2?
-                offset2_ex(diff(top_polygons, bottom, true), -offs, offs),
-                stTop
+                    -offs, offs
+                ),
+                stBottom
             );
         }
+    } else {
+        // if no lower layer, all surfaces of this one are solid
+        // we clone surfaces because we're going to clear the slices collection
+        bottom = layerm.slices;
+
+        // if we have raft layers, consider bottom layer as a bridge
+        // just like any other bottom surface lying on the void
+        const SurfaceType surface_type_bottom =
+            (object.config.raft_layers.value > 0 && object.config.support_material_contact_distance.value > 0)
+            ? stBottomBridge
+            : stBottom;
+        for (Surface &s : bottom.surfaces) s.surface_type = surface_type_bottom;
+    }
+
+    // now, if the object contained a thin membrane, we could have overlapping bottom
+    // and top surfaces; let's do an intersection to discover them and consider them
+    // as bottom surfaces (to allow for bridge detection)
+    if (!top.empty() && !bottom.empty()) {
+        const Polygons top_polygons = to_polygons(STDMOVE(top));
+        top.clear();
+        top.append(
+            // TODO: maybe we don't need offset2?
+            offset2_ex(diff(top_polygons, bottom, true), -offs, offs),
+            stTop
+        );
+    }
 
-        // save surfaces to layer
+    // save surfaces to layer
+    {
+        layerm.slices.clear();
+        layerm.slices.append(STDMOVE(top));
+        layerm.slices.append(STDMOVE(bottom));
+        layerm.slices.append(STDMOVE(nonplanar_surfaces));
+
+        // find internal surfaces (difference between top/bottom surfaces and others)
         {
-            boost::lock_guard<boost::mutex> l(layerm._slices_mutex);
-            layerm.slices.clear();
-            layerm.slices.append(STDMOVE(top));
-            layerm.slices.append(STDMOVE(bottom));
-            layerm.slices.append(STDMOVE(nonplanar_surfaces));
-
-            // find internal surfaces (difference between top/bottom surfaces and others)
-            {
-                Polygons solid_surfaces = top;
-                append_to(solid_surfaces, (Polygons)bottom);
-                append_to(solid_surfaces, (Polygons)nonplanar_surfaces);
-
-                layerm.slices.append(
-                    // TODO: maybe we don't need offset2?
-                    offset2_ex(
-                        diff(layerm_slices_surfaces, solid_surfaces, true),
-                        -offs, offs
-                    ),
-                    stInternal
-                );
-            }
+            Polygons solid_surfaces = top;
+            append_to(solid_surfaces, (Polygons)bottom);
+            append_to(solid_surfaces, (Polygons)nonplanar_surfaces);
+
+            layerm.slices.append(
+                // TODO: maybe we don't need offset2?
+                offset2_ex(
+                    diff(layerm_slices_surfaces, solid_surfaces, true),
+                    -offs, offs
+                ),
+                stInternal
+            );
         }
+    }
 
-        #ifdef SLIC3R_DEBUG
-        printf("  layer %zu has %zu bottom, %zu top and %zu internal surfaces\n",
-            this->id(), bottom.size(), top.size(),
-            layerm.slices.size()-bottom.size()-top.size());
-        #endif
+    #ifdef SLIC3R_DEBUG
+    printf("  layer %zu has %zu bottom, %zu top and %zu internal surfaces\n",
+        this->id(), bottom.size(), top.size(),
+        layerm.slices.size()-bottom.size()-top.size());
+    #endif
 
-        {
-            /*  Fill in layerm->fill_surfaces by trimming the layerm->slices by the cummulative layerm->fill_surfaces.
-                Note: this method should be idempotent, but fill_surfaces gets modified
-                in place. However we're now only using its boundaries (which are invariant)
-                so we're safe. This guarantees idempotence of prepare_infill() also in case
-                that combine_infill() turns some fill_surface into VOID surfaces.  */
-            const Polygons fill_boundaries = layerm.fill_surfaces;
-            layerm.fill_surfaces.clear();
-            // No other instance of this function is writing to this layer, so we can read safely.
-            for (const Surface &surface : layerm.slices.surfaces) {
-                // No other instance of this function modifies fill_surfaces.
-                layerm.fill_surfaces.append(
-                    intersection_ex(surface, fill_boundaries),
-                    surface.surface_type
-                );
-            }
+    {
+        /*  Fill in layerm->fill_surfaces by trimming the layerm->slices by the cummulative layerm->fill_surfaces.
+            Note: this method should be idempotent, but fill_surfaces gets modified
+            in place. However we're now only using its boundaries (which are invariant)
+            so we're safe. This guarantees idempotence of prepare_infill() also in case
+            that combine_infill() turns some fill_surface into VOID surfaces.  */
+        const Polygons fill_boundaries = layerm.fill_surfaces;
+        layerm.fill_surfaces.clear();
+        // No other instance of this function is writing to this layer, so we can read safely.
+        for (const Surface &surface : layerm.slices.surfaces) {
+            // No other instance of this function modifies fill_surfaces.
+            layerm.fill_surfaces.append(
+                intersection_ex(surface, fill_boundaries),
+                surface.surface_type
+            );
         }
     }
 }
@@ -472,4 +653,12 @@ Layer::process_external_surfaces()
         layerm->process_external_surfaces();
 }
 
+void
+Layer::build_motion_planner()
+{
+    delete this->motion_planner;
+    this->motion_planner = new MotionPlanner(union_ex(this->slices.expolygons, true));
+    this->motion_planner->build();
+}
+
 }
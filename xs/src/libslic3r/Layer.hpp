@@ -6,6 +6,7 @@
 #include "SurfaceCollection.hpp"
 #include "ExtrusionEntityCollection.hpp"
 #include "ExPolygonCollection.hpp"
+#include "MotionPlanner.hpp"
 #include "PolylineCollection.hpp"
 #include "NonplanarSurface.hpp"
 #include <boost/thread.hpp>
@@ -91,8 +92,6 @@ class LayerRegion
     Layer *_layer;
     /// Pointer to associated PrintRegion
     PrintRegion *_region;
-    /// Mutex object for slices.
-    mutable boost::mutex _slices_mutex;
 
     ///Constructor
     LayerRegion(Layer *layer, PrintRegion *region)
@@ -126,6 +125,9 @@ class Layer {
 
     ExPolygonCollection slices; ///< collection of expolygons generated by slicing the original geometry;
                                 ///< also known as 'islands' (all regions and surface types are merged here)
+    MotionPlanner* motion_planner;  ///< prebuilt planner for avoid_crossing_perimeters, or NULL
+    const Layer* perimeters_source; ///< identical layer the perimeters were copied from, or NULL
+    const Layer* fills_source;      ///< identical layer the fills were copied from, or NULL
 
     /// Returns the number of regions
     size_t region_count() const;
@@ -148,12 +150,31 @@ class Layer {
     void make_perimeters();
     /// Makes fills for all the LayerRegion
     void make_fills();
+    /// Hash of everything make_perimeters() reads, for detecting identical layers
+    size_t perimeters_inputs_hash() const;
+    /// True iff make_perimeters() would produce the same result on both layers
+    bool same_perimeters_inputs(const Layer &other) const;
+    /// Copies perimeters, thin fills and fill surfaces of an identical layer
+    void copy_perimeters_from(const Layer &other);
+    /// Hash of everything make_fills() reads, for detecting identical layers
+    size_t fills_inputs_hash() const;
+    /// True iff make_fills() would produce the same result on both layers
+    bool same_fills_inputs(const Layer &other) const;
+    /// Copies the fills of an identical layer, keeping our own thin fills
+    void copy_fills_from(const Layer &other);
+    /// True if any region holds nonplanar surfaces
+    bool has_nonplanar_surfaces() const;
     /// Projects nonplanar surfaces downwards regarding the structure of the stl mesh.
     void project_nonplanar_surfaces();
     /// Determines the type of surface (top/bottombridge/bottom/internal) each region is
     void detect_surfaces_type();
+    /// Same for a single region, given a snapshot of the neighbor layers' region slices
+    void detect_surfaces_type(size_t region_id, const Polygons &upper_region_slices,
+        const Polygons &lower_region_slices);
     /// Processes the external surfaces
     void process_external_surfaces();
+    /// Builds the motion planner of this layer's islands
+    void build_motion_planner();
 
     protected:
     size_t _id;     ///< sequential number of layer, 0-based
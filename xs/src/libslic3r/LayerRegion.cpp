@@ -66,6 +66,7 @@ LayerRegion::make_perimeters(const SurfaceCollection &slices, SurfaceCollection*
     g.ext_perimeter_flow    = this->flow(frExternalPerimeter);
     g.overhang_flow         = this->region()->flow(frPerimeter, -1, true, false, -1, *this->layer()->object());
     g.solid_infill_flow     = this->flow(frSolidInfill);
+    g.medial_axis_cache     = &this->layer()->object()->medial_axis_cache;
     
     g.process();
 }
@@ -129,6 +130,8 @@ LayerRegion::process_external_surfaces()
                 this->layer()->lower_layer->slices,
                 this->flow(frInfill, true).scaled_width()
             );
+            bd.threads  = this->layer()->object()->print()->config.threads.value;
+            bd.cache    = &this->layer()->object()->bridge_angle_cache;
             
             #ifdef SLIC3R_DEBUG
             printf("Processing bridge at layer %zu (z = %f):\n", this->layer()->id(), this->layer()->print_z);
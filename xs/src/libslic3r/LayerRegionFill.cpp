@@ -5,9 +5,31 @@
 #include "Print.hpp"
 #include "PrintConfig.hpp"
 #include "Surface.hpp"
+#include <map>
+#include <memory>
+#include <boost/thread/tss.hpp>
 
 namespace Slic3r {
 
+/// Fillers of a thread, by pattern. They are reused for all the surfaces
+/// the thread fills, which saves allocating them and keeps the caches
+/// of the patterns having one, like the hexagon math of FillHoneycomb.
+/// make_fill() sets all the parameters it uses before each fill.
+class ThreadFillers
+{
+    public:
+    Fill* get(InfillPattern pattern) {
+        std::unique_ptr<Fill> &filler = this->_fillers[pattern];
+        if (!filler) filler.reset(Fill::new_from_type(pattern));
+        return filler.get();
+    };
+
+    private:
+    std::map<InfillPattern,std::unique_ptr<Fill> > _fillers;
+};
+
+static boost::thread_specific_ptr<ThreadFillers> thread_fillers;
+
 /// Struct for the main attributes of a Surface
 /// Used for comparing properties
 struct SurfaceGroupAttrib
@@ -38,6 +60,8 @@ LayerRegion::make_fill()
     const coord_t perimeter_spacing    = this->flow(frPerimeter).scaled_spacing();
 
     SurfaceCollection surfaces;
+    if (thread_fillers.get() == NULL) thread_fillers.reset(new ThreadFillers());
+    ThreadFillers &fillers = *thread_fillers;
 
     // merge adjacent surfaces
     // in case of bridge surfaces, the ones with defined angle will be attached to the ones
@@ -90,6 +114,8 @@ LayerRegion::make_fill()
         }
 
         // Give priority to oriented bridges. Process the bridges in the first round, the rest of the surfaces in the 2nd round.
+        // processed holds the polygons of surfaces, so that they aren't converted again for each group.
+        Polygons processed;
         for (size_t round = 0; round < 2; ++ round) {
             for (std::vector<SurfacesConstPtr>::const_iterator it_group = groups.begin(); it_group != groups.end(); ++ it_group) {
                 const SurfacesConstPtr &group = *it_group;
@@ -106,10 +132,9 @@ LayerRegion::make_fill()
 
                 // subtract any other surface already processed
                 //FIXME Vojtech: Because the bridge surfaces came first, they are subtracted twice!
-                surfaces.append(
-                    diff_ex(union_p, to_polygons(surfaces), true),
-                    *group.front()  // template
-                );
+                const ExPolygons expp = diff_ex(union_p, processed, true);
+                append_to(processed, to_polygons(expp));
+                surfaces.append(expp, *group.front());  // template
             }
         }
     }
@@ -181,28 +206,15 @@ LayerRegion::make_fill()
             continue;
         
         // get filler object
-        #if SLIC3R_CPPVER >= 11
-            std::unique_ptr<Fill> f = std::unique_ptr<Fill>(Fill::new_from_type(fill_pattern));
-        #else
-            std::auto_ptr<Fill> f = std::auto_ptr<Fill>(Fill::new_from_type(fill_pattern));
-        #endif
+        Fill* f = fillers.get(fill_pattern);
 
         // switch to rectilinear if this pattern doesn't support solid infill
         if (density > 99 && !f->can_solid())
-            #if SLIC3R_CPPVER >= 11
-                f = std::unique_ptr<Fill>(Fill::new_from_type(ipRectilinear));
-            #else
-                f = std::auto_ptr<Fill>(Fill::new_from_type(ipRectilinear));
-            #endif
+            f = fillers.get(ipRectilinear);
         
         //set fill pattern to rectilinear for all nonplanar surfaces
-        if (surface.is_nonplanar()) {
-            #if SLIC3R_CPPVER >= 11
-                f = std::unique_ptr<Fill>(Fill::new_from_type(ipRectilinear));
-            #else
-                f = std::auto_ptr<Fill>(Fill::new_from_type(ipRectilinear));
-            #endif
-        }
+        if (surface.is_nonplanar())
+            f = fillers.get(ipRectilinear);
             
         f->bounding_box = this->layer()->object()->bounding_box();
 
@@ -0,0 +1,56 @@
+#include "MedialAxisCache.hpp"
+#include "GeometryHash.hpp"
+
+namespace Slic3r {
+
+size_t
+MedialAxisCache::_hash(const ExPolygon &expolygon, double max_width, double min_width)
+{
+    uint64_t seed = GeometryHash::SEED;
+    GeometryHash::combine(seed, max_width);
+    GeometryHash::combine(seed, min_width);
+    GeometryHash::combine(seed, expolygon);
+    return size_t(seed);
+}
+
+size_t
+MedialAxisCache::_memory(const Key &key, const ThickPolylines &result)
+{
+    size_t memory = sizeof(Key) + sizeof(ThickPolylines) + key.expolygon.contour.points.size() * sizeof(Point);
+    for (const Polygon &hole : key.expolygon.holes)
+        memory += sizeof(Polygon) + hole.points.size() * sizeof(Point);
+    for (const ThickPolyline &tp : result)
+        memory += sizeof(ThickPolyline)
+            + tp.points.size() * sizeof(Point)
+            + tp.width.size() * sizeof(coordf_t);
+    return memory;
+}
+
+void
+MedialAxisCache::medial_axis(const ExPolygon &expolygon, double max_width, double min_width,
+    ThickPolylines* polylines)
+{
+    const size_t hash = _hash(expolygon, max_width, min_width);
+    // guard against hash collisions by comparing the actual input
+    auto matches = [&](const Key &key) {
+        return key.max_width == max_width
+            && key.min_width == min_width
+            && GeometryHash::equal(key.expolygon, expolygon);
+    };
+
+    ThickPolylines result;
+    if (!this->_cache.find(hash, matches, &result)) {
+        // build the Voronoi diagram without holding the lock, so that
+        // concurrent misses don't serialize
+        expolygon.medial_axis(max_width, min_width, &result);
+        Key key;
+        key.expolygon = expolygon;
+        key.max_width = max_width;
+        key.min_width = min_width;
+        const size_t memory = _memory(key, result);
+        this->_cache.store(hash, matches, std::move(key), result, memory);
+    }
+    polylines->insert(polylines->end(), result.begin(), result.end());
+}
+
+}
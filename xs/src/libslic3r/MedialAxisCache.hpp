@@ -0,0 +1,50 @@
+#ifndef slic3r_MedialAxisCache_hpp_
+#define slic3r_MedialAxisCache_hpp_
+
+#include "libslic3r.h"
+#include "ExPolygon.hpp"
+#include "Polyline.hpp"
+#include "Cache.hpp"
+
+namespace Slic3r {
+
+/// Memoizes ExPolygon::medial_axis() results.
+/// Prismatic objects produce the same thin wall and gap fill areas on many
+/// consecutive layers, so the Voronoi diagram is only built the first time a
+/// given (expolygon, max_width, min_width) triple is seen.
+/// All methods are thread-safe; the Voronoi construction itself happens
+/// outside of the lock so that concurrent misses don't serialize.
+class MedialAxisCache
+{
+    public:
+    /// Default memory budget for the cached results, in bytes.
+    static const size_t DEFAULT_MAX_MEMORY = 64 * 1024 * 1024;
+
+    struct Key {
+        ExPolygon expolygon;
+        double max_width;
+        double min_width;
+    };
+    typedef LRUCache<Key, ThickPolylines>::Stats Stats;
+
+    explicit MedialAxisCache(size_t max_memory = DEFAULT_MAX_MEMORY)
+        : _cache(max_memory) {};
+
+    /// Same contract as ExPolygon::medial_axis(): results are appended to polylines.
+    void medial_axis(const ExPolygon &expolygon, double max_width, double min_width,
+        ThickPolylines* polylines);
+    Stats stats() const { return this->_cache.stats(); };
+    void clear() { this->_cache.clear(); };
+    size_t max_memory() const { return this->_cache.max_memory(); };
+    void set_max_memory(size_t max_memory) { this->_cache.set_max_memory(max_memory); };
+
+    private:
+    LRUCache<Key, ThickPolylines> _cache;
+
+    static size_t _hash(const ExPolygon &expolygon, double max_width, double min_width);
+    static size_t _memory(const Key &key, const ThickPolylines &result);
+};
+
+}
+
+#endif
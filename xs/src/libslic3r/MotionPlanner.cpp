@@ -1,6 +1,11 @@
 #include "BoundingBox.hpp"
 #include "MotionPlanner.hpp"
+#include "GeometryHash.hpp"
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <limits> // for numeric_limits
+#include <queue>
 #include <assert.h>
 
 #include "boost/polygon/voronoi.hpp"
@@ -10,7 +15,7 @@ using boost::polygon::voronoi_diagram;
 namespace Slic3r {
 
 MotionPlanner::MotionPlanner(const ExPolygons &islands)
-    : initialized(false)
+    : build_time(0), initialized(false), path_cache(MP_PATH_CACHE_MAX_MEMORY)
 {
     ExPolygons expp;
     for (const ExPolygon &island : islands)
@@ -18,6 +23,10 @@ MotionPlanner::MotionPlanner(const ExPolygons &islands)
     
     for (const ExPolygon &island : expp)
         this->islands.push_back(MotionPlannerEnv(island));
+    
+    // index the islands for locating the endpoints of travel moves
+    this->islands_ex = expp;
+    this->islands_grid = ExPolygonGrid(this->islands_ex);
 }
 
 MotionPlanner::~MotionPlanner()
@@ -32,6 +41,20 @@ MotionPlanner::islands_count() const
     return this->islands.size();
 }
 
+void
+MotionPlanner::build()
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    this->initialize();
+    if (this->initialized) {
+        for (int island_idx = -1; island_idx < (int)this->islands.size(); ++island_idx)
+            this->init_graph(island_idx);
+    }
+    
+    this->build_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 void
 MotionPlanner::initialize()
 {
@@ -66,6 +89,10 @@ MotionPlanner::initialize()
     
     this->outer.env = ExPolygonCollection(diff_ex(contour, offset(outer_holes, +MP_OUTER_MARGIN)));
     
+    // grow our environment slightly in order for the endpoint pruning in
+    // shortest_path() to work best by considering moves on boundaries valid as well
+    this->outer_grown_env = ExPolygonCollection(offset_ex((Polygons)this->outer.env, +SCALED_EPSILON));
+    
     this->graphs.resize(this->islands.size() + 1, NULL);
     this->initialized = true;
 }
@@ -88,16 +115,16 @@ MotionPlanner::shortest_path(const Point &from, const Point &to)
         return Line(from, to);
     
     // Are both points in the same island?
-    int island_idx = -1;
-    for (std::vector<MotionPlannerEnv>::const_iterator island = this->islands.begin(); island != this->islands.end(); ++island) {
-        if (island->island.contains(from) && island->island.contains(to)) {
+    int island_idx = this->islands_grid.find(from);
+    if (island_idx != -1) {
+        const ExPolygon &island = this->islands[island_idx].island;
+        if (island.contains(to)) {
             // since both points are in the same island, is a direct move possible?
             // if so, we avoid generating the visibility environment
-            if (island->island.contains(Line(from, to)))
+            if (island.contains(Line(from, to)))
                 return Line(from, to);
-            
-            island_idx = island - this->islands.begin();
-            break;
+        } else {
+            island_idx = -1;
         }
     }
     
@@ -105,7 +132,7 @@ MotionPlanner::shortest_path(const Point &from, const Point &to)
     this->initialize();
     
     // get environment
-    MotionPlannerEnv env = this->get_env(island_idx);
+    const MotionPlannerEnv &env = this->get_env(island_idx);
     if (env.env.expolygons.empty()) {
         // if this environment is empty (probably because it's too small), perform straight move
         // and avoid running the algorithms on empty dataset
@@ -133,18 +160,15 @@ MotionPlanner::shortest_path(const Point &from, const Point &to)
     }
     
     // perform actual path search
-    MotionPlannerGraph* graph = this->init_graph(island_idx);
-    Polyline polyline = graph->shortest_path(graph->find_node(inner_from), graph->find_node(inner_to));
+    Polyline polyline = this->graph_path(island_idx, inner_from, inner_to);
     
     polyline.points.insert(polyline.points.begin(), from);
     polyline.points.push_back(to);
     
     {
-        // grow our environment slightly in order for simplify_by_visibility()
-        // to work best by considering moves on boundaries valid as well
-        ExPolygonCollection grown_env(offset_ex((Polygons)env.env, +SCALED_EPSILON));
-        
         if (island_idx == -1) {
+            const ExPolygonCollection &grown_env = this->outer_grown_env;
+            
             /*  If 'from' or 'to' are not inside our env, they were connected using the 
                 nearest_env_point() search which maybe produce ugly paths since it does not
                 include the endpoint in the Dijkstra search; the simplify_by_visibility() 
@@ -180,10 +204,10 @@ MotionPlanner::shortest_path(const Point &from, const Point &to)
         SVG svg("shortest_path.svg");
         svg.draw(grown_env.expolygons);
         svg.arrows = false;
-        for (MotionPlannerGraph::adjacency_list_t::const_iterator it = graph->adjacency_list.begin(); it != graph->adjacency_list.end(); ++it) {
-            Point a = graph->nodes[it - graph->adjacency_list.begin()];
-            for (std::vector<MotionPlannerGraph::neighbor>::const_iterator n = it->begin(); n != it->end(); ++n) {
-                Point b = graph->nodes[n->target];
+        for (size_t i = 0; i + 1 < graph->offsets.size(); ++i) {
+            Point a = graph->nodes[i];
+            for (size_t e = graph->offsets[i]; e < graph->offsets[i+1]; ++e) {
+                Point b = graph->nodes[graph->edges[e].target];
                 svg.draw(Line(a, b));
             }
         }
@@ -200,6 +224,31 @@ MotionPlanner::shortest_path(const Point &from, const Point &to)
     return polyline;
 }
 
+Polyline
+MotionPlanner::graph_path(int island_idx, const Point &from, const Point &to)
+{
+    MotionPlannerGraph* graph = this->init_graph(island_idx);
+    const size_t from_node = graph->find_node(from);
+    const size_t to_node   = graph->find_node(to);
+    
+    // travel moves often go back and forth between the same places, which
+    // snap to the same graph nodes
+    const PathKey key(island_idx, std::make_pair(from_node, to_node));
+    uint64_t hash = GeometryHash::SEED;
+    GeometryHash::combine(hash, uint64_t(island_idx));
+    GeometryHash::combine(hash, uint64_t(from_node));
+    GeometryHash::combine(hash, uint64_t(to_node));
+    auto matches = [&key](const PathKey &other) { return other == key; };
+    
+    Polyline polyline;
+    if (this->path_cache.find(size_t(hash), matches, &polyline)) return polyline;
+    
+    polyline = graph->shortest_path(from_node, to_node);
+    this->path_cache.store(size_t(hash), matches, key, polyline,
+        sizeof(PathKey) + sizeof(Polyline) + polyline.points.size() * sizeof(Point));
+    return polyline;
+}
+
 MotionPlannerGraph*
 MotionPlanner::init_graph(int island_idx)
 {
@@ -218,7 +267,7 @@ MotionPlanner::init_graph(int island_idx)
         t_vd_vertices vd_vertices;
         
         // get boundaries as lines
-        MotionPlannerEnv env = this->get_env(island_idx);
+        const MotionPlannerEnv &env = this->get_env(island_idx);
         Lines lines = env.env.lines();
         boost::polygon::construct_voronoi(lines.begin(), lines.end(), &vd);
         
@@ -256,6 +305,7 @@ MotionPlanner::init_graph(int island_idx)
             double dist = graph->nodes[v0_idx].distance_to(graph->nodes[v1_idx]);
             graph->add_edge(v0_idx, v1_idx, dist);
         }
+        graph->finalize();
         
         return graph;
     }
@@ -319,89 +369,166 @@ MotionPlannerEnv::nearest_env_point(const Point &from, const Point &to) const
 void
 MotionPlannerGraph::add_edge(node_t from, node_t to, double weight)
 {
-    // extend adjacency list until this start node
-    if (this->adjacency_list.size() < (size_t)from+1)
-        this->adjacency_list.resize(from+1);
+    this->pending_edges.push_back(std::make_pair(from, neighbor(to, weight)));
+}
+
+void
+MotionPlannerGraph::finalize()
+{
+    // count the edges leaving each node, then place them with a counting sort
+    // (which keeps the insertion order of the neighbors of each node)
+    this->offsets.assign(this->nodes.size() + 1, 0);
+    for (const std::pair<node_t,neighbor> &e : this->pending_edges)
+        this->offsets[e.first + 1]++;
+    for (size_t i = 1; i < this->offsets.size(); ++i)
+        this->offsets[i] += this->offsets[i-1];
+    
+    std::vector<size_t> next(this->offsets.begin(), this->offsets.end() - 1);
+    this->edges.assign(this->pending_edges.size(), neighbor(-1, 0));
+    for (const std::pair<node_t,neighbor> &e : this->pending_edges)
+        this->edges[next[e.first]++] = e.second;
     
-    this->adjacency_list[from].push_back(neighbor(to, weight));
+    std::vector< std::pair<node_t,neighbor> >().swap(this->pending_edges);
+    
+    this->index_nodes();
+}
+
+void
+MotionPlannerGraph::index_nodes()
+{
+    if (this->nodes.empty()) return;
+    
+    // aim at a couple of nodes per cell
+    this->nodes_bb = BoundingBox(this->nodes);
+    const Point size = this->nodes_bb.size();
+    const double area = std::max(1., double(size.x) * double(size.y));
+    this->cell_size = std::max((coord_t)std::sqrt(2. * area / this->nodes.size()), std::max(size.x, size.y) / 1024 + 1);
+    this->columns   = size.x / this->cell_size + 1;
+    this->rows      = size.y / this->cell_size + 1;
+    
+    std::vector<size_t> node_cells(this->nodes.size());
+    this->cell_offsets.assign(this->columns * this->rows + 1, 0);
+    for (size_t i = 0; i < this->nodes.size(); ++i) {
+        node_cells[i] = this->cell_row(this->nodes[i].y) * this->columns + this->cell_column(this->nodes[i].x);
+        this->cell_offsets[node_cells[i] + 1]++;
+    }
+    for (size_t i = 1; i < this->cell_offsets.size(); ++i)
+        this->cell_offsets[i] += this->cell_offsets[i-1];
+    
+    std::vector<size_t> next(this->cell_offsets.begin(), this->cell_offsets.end() - 1);
+    this->cell_nodes.resize(this->nodes.size());
+    for (size_t i = 0; i < this->nodes.size(); ++i)
+        this->cell_nodes[next[node_cells[i]]++] = i;
+}
+
+size_t
+MotionPlannerGraph::cell_column(coord_t x) const
+{
+    if (x <= this->nodes_bb.min.x) return 0;
+    return std::min(this->columns - 1, size_t((x - this->nodes_bb.min.x) / this->cell_size));
+}
+
+size_t
+MotionPlannerGraph::cell_row(coord_t y) const
+{
+    if (y <= this->nodes_bb.min.y) return 0;
+    return std::min(this->rows - 1, size_t((y - this->nodes_bb.min.y) / this->cell_size));
 }
 
 size_t
 MotionPlannerGraph::find_node(const Point &point) const
 {
-    /*
-    for (Points::const_iterator p = this->nodes.begin(); p != this->nodes.end(); ++p) {
-        if (p->coincides_with(point)) return p - this->nodes.begin();
+    if (this->cell_offsets.empty())
+        return point.nearest_point_index(this->nodes);
+    
+    /*  Visit the cells in rings of growing size around the one containing the
+        point. Nodes in ring r are at least (r-1)*cell_size away, so we can stop
+        as soon as the best candidate is closer than that.
+        Ties are broken like Point::nearest_point_index() does, so that
+        the result doesn't depend on the grid. */
+    const long cx = this->cell_column(point.x);
+    const long cy = this->cell_row(point.y);
+    int best = -1;
+    double best_dist = 0;
+    for (long r = 0; r <= (long)std::max(this->columns, this->rows); ++r) {
+        if (best != -1 && r > 1 && best_dist < pow(double(r - 1) * this->cell_size, 2)) break;
+        
+        for (long y = std::max(0L, cy - r); y <= std::min((long)this->rows - 1, cy + r); ++y) {
+            // only the first and last row of the ring are visited entirely
+            const long step = (y == cy - r || y == cy + r) ? 1 : 2*r;
+            for (long x = cx - r; x <= cx + r; x += std::max(1L, step)) {
+                if (x < 0 || x >= (long)this->columns) continue;
+                const size_t cell = y * this->columns + x;
+                for (size_t k = this->cell_offsets[cell]; k < this->cell_offsets[cell+1]; ++k) {
+                    const node_t i = this->cell_nodes[k];
+                    const double d = pow(double(point.x - this->nodes[i].x), 2) + pow(double(point.y - this->nodes[i].y), 2);
+                    if (best == -1 || d < best_dist
+                        || (d == best_dist && (d < EPSILON ? i < best : i > best))) {
+                        best      = i;
+                        best_dist = d;
+                    }
+                }
+            }
+        }
     }
-    */
-    return point.nearest_point_index(this->nodes);
+    return best;
 }
 
 Polyline
-MotionPlannerGraph::shortest_path(node_t from, node_t to)
+MotionPlannerGraph::shortest_path(node_t from, node_t to) const
 {
-    // this prevents a crash in case for some reason we got here with an empty adjacency list
-    if (this->adjacency_list.empty()) return Polyline();
+    // this prevents a crash in case for some reason we got here with an empty graph
+    if (this->edges.empty()) return Polyline();
     
     const weight_t max_weight = std::numeric_limits<weight_t>::infinity();
     
-    std::vector<weight_t> dist;
-    std::vector<node_t> previous;
-    {
-        // number of nodes
-        const int n = this->adjacency_list.size();
+    // number of nodes
+    const int n = this->nodes.size();
+    
+    // A* search: edge weights are Euclidean distances between nodes, so the
+    // straight distance to the destination never overestimates the remaining
+    // cost and the first time we pop the destination its path is the shortest
+    std::vector<weight_t> dist(n, max_weight);
+    std::vector<node_t> previous(n, -1);
+    std::vector<bool> visited(n, false);
+    dist[from] = 0;  // distance from 'from' to itself
+    
+    typedef std::pair<weight_t,node_t> queued_node;  // estimated total cost, node
+    std::priority_queue<queued_node, std::vector<queued_node>, std::greater<queued_node> > Q;
+    Q.push(queued_node(this->nodes[from].distance_to(this->nodes[to]), from));
+    
+    while (!Q.empty()) {
+        // get the queued node having the minimum estimated cost
+        const node_t u = Q.top().second;
+        Q.pop();
         
-        // initialize dist and previous
-        dist.clear();
-        dist.resize(n, max_weight);
-        dist[from] = 0;  // distance from 'from' to itself
-        previous.clear();
-        previous.resize(n, -1);
+        // skip stale queue entries
+        if (visited[u]) continue;
+        visited[u] = true;
         
-        // initialize the Q with all nodes
-        std::set<node_t> Q;
-        for (node_t i = 0; i < n; ++i) Q.insert(i);
+        // stop searching if we reached our destination
+        if (u == to) break;
         
-        while (!Q.empty()) 
+        // Visit each edge starting from node u
+        for (std::vector<neighbor>::const_iterator neighbor_iter = this->edges.begin() + this->offsets[u];
+             neighbor_iter != this->edges.begin() + this->offsets[u+1];
+             ++neighbor_iter)
         {
-            // get node in Q having the minimum dist ('from' in the first loop)
-            node_t u;
-            {
-                double min_dist = -1;
-                for (std::set<node_t>::const_iterator n = Q.begin(); n != Q.end(); ++n) {
-                    if (dist[*n] < min_dist || min_dist == -1) {
-                        u = *n;
-                        min_dist = dist[*n];
-                    }
-                }
-            }
-            Q.erase(u);
+            // neighbor node is v
+            node_t v = neighbor_iter->target;
             
-            // stop searching if we reached our destination
-            if (u == to) break;
+            // skip if we already visited this
+            if (visited[v]) continue;
             
-            // Visit each edge starting from node u
-            const std::vector<neighbor> &neighbors = this->adjacency_list[u];
-            for (std::vector<neighbor>::const_iterator neighbor_iter = neighbors.begin();
-                 neighbor_iter != neighbors.end();
-                 ++neighbor_iter)
-            {
-                // neighbor node is v
-                node_t v = neighbor_iter->target;
-                
-                // skip if we already visited this
-                if (Q.find(v) == Q.end()) continue;
-                
-                // calculate total distance
-                weight_t alt = dist[u] + neighbor_iter->weight;
-                
-                // if total distance through u is shorter than the previous
-                // distance (if any) between 'from' and 'v', replace it
-                if (alt < dist[v]) {
-                    dist[v]     = alt;
-                    previous[v] = u;
-                }
-
+            // calculate total distance
+            weight_t alt = dist[u] + neighbor_iter->weight;
+            
+            // if total distance through u is shorter than the previous
+            // distance (if any) between 'from' and 'v', replace it
+            if (alt < dist[v]) {
+                dist[v]     = alt;
+                previous[v] = u;
+                Q.push(queued_node(alt + this->nodes[v].distance_to(this->nodes[to]), v));
             }
         }
     }
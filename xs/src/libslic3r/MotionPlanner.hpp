@@ -3,9 +3,11 @@
 
 #include "libslic3r.h"
 #include "ClipperUtils.hpp"
+#include "BoundingBox.hpp"
+#include "Cache.hpp"
 #include "ExPolygonCollection.hpp"
+#include "ExPolygonGrid.hpp"
 #include "Polyline.hpp"
-#include <map>
 #include <utility>
 #include <vector>
 
@@ -13,6 +15,8 @@ namespace Slic3r {
 
 constexpr coord_t MP_INNER_MARGIN = scale_(1.0);
 constexpr coord_t MP_OUTER_MARGIN = scale_(2.0);
+// memory budget for the node paths remembered by MotionPlanner, in bytes
+constexpr size_t MP_PATH_CACHE_MAX_MEMORY = 1024 * 1024;
 
 class MotionPlanner;
 
@@ -41,17 +45,40 @@ class MotionPlannerGraph
         neighbor(node_t arg_target, weight_t arg_weight)
             : target(arg_target), weight(arg_weight) { }
     };
-    typedef std::vector< std::vector<neighbor> > adjacency_list_t;
-    adjacency_list_t adjacency_list;
+    
+    // Edges are stored in compressed sparse row form: the neighbors of
+    // node i are edges[offsets[i]] to edges[offsets[i+1]-1].
+    std::vector<size_t> offsets;
+    std::vector<neighbor> edges;
+    // edges collected by add_edge() until finalize() is called
+    std::vector< std::pair<node_t,neighbor> > pending_edges;
+    
+    // Uniform grid over the nodes for find_node(), in the same compressed
+    // form: the nodes in cell i are cell_nodes[cell_offsets[i]] to
+    // cell_nodes[cell_offsets[i+1]-1].
+    BoundingBox nodes_bb;
+    coord_t cell_size;
+    size_t columns, rows;
+    std::vector<size_t> cell_offsets;
+    std::vector<node_t> cell_nodes;
+    void index_nodes();
+    size_t cell_column(coord_t x) const;
+    size_t cell_row(coord_t y) const;
     
     public:
     Points nodes;
-    //std::map<std::pair<size_t,size_t>, double> edges;
+    MotionPlannerGraph() : cell_size(0), columns(0), rows(0) {};
     void add_edge(node_t from, node_t to, double weight);
+    void finalize();
     size_t find_node(const Point &point) const;
-    Polyline shortest_path(node_t from, node_t to);
+    Polyline shortest_path(node_t from, node_t to) const;
 };
 
+/// Finds travel paths avoiding to cross the islands contours.
+/// The islands graphs are built lazily by shortest_path() unless build() was
+/// called, so a planner must only be used by one thread at a time: the
+/// per-layer planners are shared through Layer::motion_planner, and the
+/// bodies of a layer are always generated by a single thread.
 class MotionPlanner
 {
     public:
@@ -59,16 +86,32 @@ class MotionPlanner
     ~MotionPlanner();
     Polyline shortest_path(const Point &from, const Point &to);
     size_t islands_count() const;
+    // Builds the configuration space and all the graphs ahead of time instead
+    // of lazily in shortest_path(), so that it can be done in parallel.
+    void build();
+    // seconds spent in build()
+    double build_time;
     
     private:
     bool initialized;
     std::vector<MotionPlannerEnv> islands;
+    ExPolygons islands_ex;          // the islands contours, indexed by islands_grid
+    ExPolygonGrid islands_grid;
     MotionPlannerEnv outer;
+    ExPolygonCollection outer_grown_env;
     std::vector<MotionPlannerGraph*> graphs;
+    // node paths already computed, keyed by graph and nodes
+    typedef std::pair<int,std::pair<size_t,size_t> > PathKey;
+    LRUCache<PathKey,Polyline> path_cache;
     
     void initialize();
     MotionPlannerGraph* init_graph(int island_idx);
     const MotionPlannerEnv& get_env(int island_idx) const;
+    Polyline graph_path(int island_idx, const Point &from, const Point &to);
+    
+    // non-copyable (owns the graphs, islands_grid points to islands_ex)
+    MotionPlanner(const MotionPlanner&);
+    MotionPlanner& operator=(const MotionPlanner&);
 };
 
 }
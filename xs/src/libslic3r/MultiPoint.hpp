@@ -50,6 +50,12 @@ class MultiPoint
     protected:
     MultiPoint() {};
     explicit MultiPoint(const Points &_points): points(_points) {};
+    // declared explicitly, as the user-declared destructor would otherwise
+    // turn every move of a Polygon or Polyline into a copy of its points
+    MultiPoint(const MultiPoint &other) = default;
+    MultiPoint(MultiPoint &&other) = default;
+    MultiPoint& operator=(const MultiPoint &other) = default;
+    MultiPoint& operator=(MultiPoint &&other) = default;
     ~MultiPoint() = default;
 };
 
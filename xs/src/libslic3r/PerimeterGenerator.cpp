@@ -96,7 +96,7 @@ PerimeterGenerator::process()
                         
                         // the maximum thickness of our thin wall area is equal to the minimum thickness of a single loop
                         for (ExPolygons::const_iterator ex = expp.begin(); ex != expp.end(); ++ex)
-                            ex->medial_axis(ext_pwidth + ext_pspacing2, min_width, &thin_walls);
+                            this->_medial_axis(*ex, ext_pwidth + ext_pspacing2, min_width, &thin_walls);
                         
                         #ifdef DEBUG
                         printf("  %zu thin walls detected\n", thin_walls.size());
@@ -243,7 +243,7 @@ PerimeterGenerator::process()
             
             // append perimeters for this slice as a collection
             if (!entities.empty())
-                this->loops->append(entities);
+                this->loops->append(std::move(entities));
         }
         
         // fill gaps
@@ -265,14 +265,12 @@ PerimeterGenerator::process()
             
             ThickPolylines polylines;
             for (ExPolygons::const_iterator ex = gaps_ex.begin(); ex != gaps_ex.end(); ++ex)
-                ex->medial_axis(max, min, &polylines);
+                this->_medial_axis(*ex, max, min, &polylines);
             
             if (!polylines.empty()) {
                 ExtrusionEntityCollection gap_fill = this->_variable_width(polylines, 
                     erGapFill, this->solid_infill_flow);
                 
-                this->gap_fill->append(gap_fill.entities);
-            
                 /*  Make sure we don't infill narrow parts that are already gap-filled
                     (we only consider this surface's gaps to reduce the diff() complexity).
                     Growing actual extrusions ensures that gaps not filled by medial axis
@@ -282,6 +280,8 @@ PerimeterGenerator::process()
                 //FIXME Vojtech: This grows by a rounded extrusion width, not by line spacing,
                 // therefore it may cover the area, but no the volume.
                 last = diff(last, gap_fill.grow());
+                
+                this->gap_fill->append(std::move(gap_fill.entities));
             }
         }
         
@@ -320,6 +320,17 @@ PerimeterGenerator::process()
     }
 }
 
+void
+PerimeterGenerator::_medial_axis(const ExPolygon &expolygon, double max_width, double min_width,
+    ThickPolylines* polylines) const
+{
+    if (this->medial_axis_cache != NULL) {
+        this->medial_axis_cache->medial_axis(expolygon, max_width, min_width, polylines);
+    } else {
+        expolygon.medial_axis(max_width, min_width, polylines);
+    }
+}
+
 ExtrusionEntityCollection
 PerimeterGenerator::_traverse_loops(const PerimeterGeneratorLoops &loops,
     ThickPolylines &thin_walls) const
@@ -349,14 +360,14 @@ PerimeterGenerator::_traverse_loops(const PerimeterGeneratorLoops &loops,
             && !(this->object_config->support_material && this->object_config->support_material_contact_distance.value == 0)) {
             // get non-overhang paths by intersecting this loop with the grown lower slices
             {
-                const Polylines polylines = intersection_pl(loop->polygon, this->_lower_slices_p);
-                for (const Polyline &polyline : polylines) {
+                Polylines polylines = intersection_pl(loop->polygon, this->_lower_slices_p);
+                for (Polyline &polyline : polylines) {
                     ExtrusionPath path(role);
-                    path.polyline   = polyline;
+                    path.polyline   = std::move(polyline);
                     path.mm3_per_mm = is_external ? this->_ext_mm3_per_mm           : this->_mm3_per_mm;
                     path.width      = is_external ? this->ext_perimeter_flow.width  : this->perimeter_flow.width;
                     path.height     = this->layer_height;
-                    paths.push_back(path);
+                    paths.push_back(std::move(path));
                 }
             }
             
@@ -364,14 +375,14 @@ PerimeterGenerator::_traverse_loops(const PerimeterGeneratorLoops &loops,
             // outside the grown lower slices (thus where the distance between
             // the loop centerline and original lower slices is >= half nozzle diameter
             {
-                const Polylines polylines = diff_pl(loop->polygon, this->_lower_slices_p);
-                for (const Polyline &polyline : polylines) {
+                Polylines polylines = diff_pl(loop->polygon, this->_lower_slices_p);
+                for (Polyline &polyline : polylines) {
                     ExtrusionPath path(erOverhangPerimeter);
-                    path.polyline   = polyline;
+                    path.polyline   = std::move(polyline);
                     path.mm3_per_mm = this->_mm3_per_mm_overhang;
                     path.width      = this->overhang_flow.width;
                     path.height     = this->overhang_flow.height;
-                    paths.push_back(path);
+                    paths.push_back(std::move(path));
                 }
             }
             
@@ -385,10 +396,10 @@ PerimeterGenerator::_traverse_loops(const PerimeterGeneratorLoops &loops,
             path.mm3_per_mm = is_external ? this->_ext_mm3_per_mm           : this->_mm3_per_mm;
             path.width      = is_external ? this->ext_perimeter_flow.width  : this->perimeter_flow.width;
             path.height     = this->layer_height;
-            paths.push_back(path);
+            paths.push_back(std::move(path));
         }
         
-        coll.append(ExtrusionLoop(paths, loop_role));
+        coll.append(ExtrusionLoop(std::move(paths), loop_role));
     }
     
     // append thin walls to the nearest-neighbor search (only for first iteration)
@@ -396,7 +407,7 @@ PerimeterGenerator::_traverse_loops(const PerimeterGeneratorLoops &loops,
         ExtrusionEntityCollection tw = this->_variable_width
             (thin_walls, erExternalPerimeter, this->ext_perimeter_flow);
         
-        coll.append(tw.entities);
+        coll.append(std::move(tw.entities));
         thin_walls.clear();
     }
     
@@ -423,12 +434,12 @@ PerimeterGenerator::_traverse_loops(const PerimeterGeneratorLoops &loops,
             ExtrusionEntityCollection children = this->_traverse_loops(loop.children, thin_walls);
             if (loop.is_contour) {
                 eloop.make_counter_clockwise();
-                entities.append(children.entities);
-                entities.append(eloop);
+                entities.append(std::move(children.entities));
+                entities.append(std::move(eloop));
             } else {
                 eloop.make_clockwise();
-                entities.append(eloop);
-                entities.append(children.entities);
+                entities.append(std::move(eloop));
+                entities.append(std::move(children.entities));
             }
         }
     }
@@ -517,21 +528,21 @@ PerimeterGenerator::_variable_width(const ThickPolylines &polylines, ExtrusionRo
                     path.polyline.append(line.b);
                 } else {
                     // we need to initialize a new line
-                    paths.push_back(path);
+                    paths.push_back(std::move(path));
                     path = ExtrusionPath(role);
                     --i;
                 }
             }
         }
         if (path.polyline.is_valid())
-            paths.push_back(path);
+            paths.push_back(std::move(path));
         
         // append paths to collection
         if (!paths.empty()) {
             if (paths.front().first_point().coincides_with(paths.back().last_point())) {
-                coll.append(ExtrusionLoop(paths));
+                coll.append(ExtrusionLoop(std::move(paths)));
             } else {
-                coll.append(paths);
+                coll.append(std::move(paths));
             }
         }
     }
@@ -370,18 +370,10 @@ Point3::wkt() const
     return ss.str();
 }
 
-void
-Point3::scale(double factor)
-{
-    Point::scale(factor);
-    this->z *= factor;
-}
-
 void
 Point3::translate(double x, double y, double z)
 {
-    Point::translate(x, y);
-    this->z += z;
+    Point::translate(x, y, z);
 }
 
 void
@@ -103,15 +103,12 @@ operator+=(Points &dst, const Point &p) {
 class Point3 : public Point
 {
     public:
-    coord_t z;
-    explicit Point3(coord_t _x = 0, coord_t _y = 0, coord_t _z = 0): Point(_x, _y), z(_z) {};
-    bool coincides_with(const Point3 &point3) const { return this->x == point3.x && this->y == point3.y && this->z == point3.z; }
+    explicit Point3(coord_t _x = 0, coord_t _y = 0, coord_t _z = 0): Point(_x, _y, _z) {};
     static Point3 new_scale(coordf_t x, coordf_t y, coordf_t z) {
         return Point3(scale_(x), scale_(y), scale_(z));
     };
     bool operator==(const Point3& rhs) const;
     std::string wkt() const;
-    void scale(double factor);
     void translate(double x, double y, double z);
     void translate(const Vector3 &vector);
     void rotate_z(double angle);
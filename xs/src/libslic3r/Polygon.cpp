@@ -85,16 +85,26 @@ Polygon::equally_spaced_points(double distance) const
     return this->split_at_first_point().equally_spaced_points(distance);
 }
 
+// Same formula as ClipperLib::Area(), without converting the points to a Clipper path first.
 double
 Polygon::area() const
 {
-    return ClipperLib::Area(Slic3rMultiPoint_to_ClipperPath(*this));
+    const size_t size = this->points.size();
+    if (size < 3) return 0;
+
+    double a = 0;
+    for (size_t i = 0, j = size - 1; i < size; ++i) {
+        a += ((double)this->points[j].x + this->points[i].x) * ((double)this->points[j].y - this->points[i].y);
+        j = i;
+    }
+    return -a * 0.5;
 }
 
 bool
 Polygon::is_counter_clockwise() const
 {
-    return ClipperLib::Orientation(Slic3rMultiPoint_to_ClipperPath(*this));
+    // ClipperLib::Orientation()
+    return this->area() >= 0;
 }
 
 bool
@@ -30,6 +30,8 @@ void
 PrintState<StepClass>::set_started(StepClass step)
 {
     this->started.insert(step);
+    if (this->profile != NULL)
+        this->profile->step_started(this->object, step);
 }
 
 template <class StepClass>
@@ -37,6 +39,8 @@ void
 PrintState<StepClass>::set_done(StepClass step)
 {
     this->done.insert(step);
+    if (this->profile != NULL)
+        this->profile->step_done(this->object, step);
 }
 
 template <class StepClass>
@@ -45,6 +49,8 @@ PrintState<StepClass>::invalidate(StepClass step)
 {
     bool invalidated = this->started.erase(step) > 0;
     this->done.erase(step);
+    if (this->profile != NULL)
+        this->profile->step_invalidated(this->object, step);
     return invalidated;
 }
 
@@ -56,6 +62,7 @@ Print::Print()
 :   total_used_filament(0),
     total_extruded_volume(0)
 {
+    this->state.profile = &this->profile;
 }
 
 Print::~Print()
@@ -83,6 +90,7 @@ Print::delete_object(size_t idx)
     (*i)->invalidate_all_steps();
     
     // destroy object and remove it from our container
+    this->profile.forget(*i);
     delete *i;
     this->objects.erase(i);
 
@@ -215,6 +223,7 @@ Print::invalidate_state_by_config(const PrintConfigBase &config)
             || opt_key == "notes"
             || opt_key == "only_retract_when_crossing_perimeters"
             || opt_key == "output_filename_format"
+            || opt_key == "parallel_gcode"
             || opt_key == "perimeter_acceleration"
             || opt_key == "post_process"
             || opt_key == "pressure_advance"
@@ -229,6 +238,8 @@ Print::invalidate_state_by_config(const PrintConfigBase &config)
             || opt_key == "retract_restart_extra"
             || opt_key == "retract_restart_extra_toolchange"
             || opt_key == "retract_speed"
+            || opt_key == "slice_cache_dir"
+            || opt_key == "slice_cache_size"
             || opt_key == "slowdown_below_layer_time"
             || opt_key == "spiral_vase"
             || opt_key == "standby_temperature_delta"
@@ -828,7 +839,8 @@ Print::_make_brim()
     const double mm3_per_mm = flow.mm3_per_mm();
     
     const coord_t grow_distance = flow.scaled_width()/2;
-    Polygons islands;
+    std::vector<Polygons> objects_islands;
+    std::vector<Points> copies;
     
     for (PrintObject* object : this->objects) {
         const Layer* layer0 = object->get_layer(0);
@@ -844,29 +856,26 @@ Print::_make_brim()
             for (const ExtrusionEntity* e : support_layer0->support_interface_fills.entities)
                 append_to(object_islands, offset(e->as_polyline(), grow_distance));
         }
-        for (const Point &copy : object->_shifted_copies) {
-            for (Polygon p : object_islands) {
-                p.translate(copy);
-                islands.push_back(p);
-            }
-        }
+        objects_islands.push_back(object_islands);
+        copies.push_back(object->_shifted_copies);
     }
     
-    Polygons loops;
     const int num_loops = floor(this->config.brim_width / flow.width + 0.5);
+    std::vector<std::pair<float,float> > deltas;
     for (int i = num_loops; i >= 1; --i) {
         // JT_SQUARE ensures no vertex is outside the given offset distance
         // -0.5 because islands are not represented by their centerlines
         // (first offset more, then step back - reverse order than the one used for 
         // perimeters because here we're offsetting outwards)
-        append_to(loops, offset2(
-            islands,
+        deltas.push_back(std::make_pair(
             flow.scaled_width() + flow.scaled_spacing() * (i - 1.5 + 0.5),
-            flow.scaled_spacing() * -0.525, // WORKAROUND for brim placement, original 0.5 leaves too much of a gap.
-            100000,
-            ClipperLib::jtSquare
+            flow.scaled_spacing() * -0.525 // WORKAROUND for brim placement, original 0.5 leaves too much of a gap.
         ));
     }
+    // Each object is offset once for all of its copies, which are only
+    // offset together where their brims meet.
+    const Polygons loops = offset2_copies(objects_islands, copies, deltas,
+        100000, ClipperLib::jtSquare, 3, this->config.threads.value);
     
     {
         Polygons chained = union_pt_chained(loops);
@@ -879,6 +888,13 @@ Print::_make_brim()
     
     if (this->config.brim_connections_width > 0) {
         // get islands to connect
+        Polygons islands;
+        for (size_t i = 0; i < objects_islands.size(); ++i)
+            for (const Point &copy : copies[i])
+                for (Polygon p : objects_islands[i]) {
+                    p.translate(copy);
+                    islands.push_back(p);
+                }
         for (Polygon &p : islands)
             p = Geometry::convex_hull(p.points);
         
@@ -929,7 +945,7 @@ Print::_make_brim()
                 for (Polylines::const_iterator pl = paths.begin(); pl != paths.end(); ++pl) {
                     ExtrusionPath path(erSkirt, mm3_per_mm, flow.width, flow.height);
                     path.polyline = *pl;
-                    this->brim.append(path);
+                    this->brim.append(std::move(path));
                 }
             }
         }
@@ -937,7 +953,7 @@ Print::_make_brim()
     
     if (this->config.interior_brim_width > 0) {
         // collect all island holes to fill
-        Polygons holes;
+        std::vector<Polygons> objects_holes;
         for (const PrintObject* object : this->objects) {
             const Layer &layer0 = *object->get_layer(0);
             
@@ -950,24 +966,16 @@ Print::_make_brim()
                     append_to(o_holes, (Polygons)layerm->fill_surfaces);
             }
             
-            for (const Point &copy : object->_shifted_copies) {
-                for (Polygon p : o_holes) {
-                    p.translate(copy);
-                    holes.push_back(p);
-                }
-            }
+            objects_holes.push_back(o_holes);
         }
         
-        Polygons loops;
         const int num_loops = floor(this->config.interior_brim_width / flow.width + 0.5);
-        for (int i = 1; i <= num_loops; ++i) {
-            append_to(loops, offset2(
-                holes,
-                -flow.scaled_spacing() * (i + 0.5),
-                flow.scaled_spacing()
-            ));
-        }
+        std::vector<std::pair<float,float> > deltas;
+        for (int i = 1; i <= num_loops; ++i)
+            deltas.push_back(std::make_pair(-flow.scaled_spacing() * (i + 0.5), flow.scaled_spacing()));
         
+        Polygons loops = offset2_copies(objects_holes, copies, deltas,
+            CLIPPER_OFFSET_SCALE, ClipperLib::jtMiter, 3, this->config.threads.value);
         loops = union_pt_chained(loops);
         for (const Polygon &p : loops) {
             ExtrusionPath path(erSkirt, mm3_per_mm, flow.width, flow.height);
@@ -976,6 +984,7 @@ Print::_make_brim()
         }
     }
     
+    this->profile.add_items(NULL, psBrim, this->brim.entities.size());
     this->state.set_done(psBrim);
 }
 
@@ -11,8 +11,11 @@
 #include "PrintConfig.hpp"
 #include "Point.hpp"
 #include "Layer.hpp"
+#include "MedialAxisCache.hpp"
+#include "BridgeDetector.hpp"
 #include "Model.hpp"
 #include "PlaceholderParser.hpp"
+#include "PrintProfile.hpp"
 #include "SlicingAdaptive.hpp"
 #include "LayerHeightSpline.hpp"
 #include "NonplanarSurface.hpp"
@@ -31,7 +34,7 @@ enum PrintStep {
 enum PrintObjectStep {
     posLayers, posSlice, posPerimeters, posDetectSurfaces,
     posPrepareInfill, posInfill, posSupportMaterial,
-    posNonplanarProjection,
+    posNonplanarDetection, posNonplanarProjection, posMotionPlanning,
 };
 
 // To be instantiated over PrintStep or PrintObjectStep enums.
@@ -40,7 +43,11 @@ class PrintState
 {
     public:
     std::set<StepType> started, done;
+    /// Records the steps if set, as steps of object (NULL for the Print).
+    PrintProfile* profile;
+    const PrintObject* object;
 
+    PrintState() : profile(NULL), object(NULL) {};
     bool is_started(StepType step) const;
     bool is_done(StepType step) const;
     void set_started(StepType step);
@@ -87,6 +94,10 @@ class PrintObject
 
     LayerHeightSpline layer_height_spline;
 
+    /// Nonplanar surfaces found on the object meshes (posNonplanarDetection).
+    /// They only depend on the meshes and the nonplanar options, so they are
+    /// kept across reslices; collisions are checked against the current slices
+    /// by move_nonplanar_surfaces_up().
     NonplanarSurfaces nonplanar_surfaces;
 
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
@@ -105,6 +116,13 @@ class PrintObject
 
     LayerPtrs layers;
     SupportLayerPtrs support_layers;
+    /// Thin wall and gap fill medial axes shared by the layers of this object
+    MedialAxisCache medial_axis_cache;
+    /// Bridge angles shared by the layers of this object
+    BridgeAngleCache bridge_angle_cache;
+    /// Whether layers whose perimeters or fills would be identical to those
+    /// of a previous layer copy them instead of generating them again
+    bool reuse_identical_layers;
     // TODO: Fill* fill_maker        => (is => 'lazy');
     PrintState<PrintObjectStep> state;
 
@@ -153,10 +171,12 @@ class PrintObject
     void project_nonplanar_surfaces();
     void process_external_surfaces();
     void bridge_over_infill();
+    void build_motion_planners();
     coordf_t adjust_layer_height(coordf_t layer_height) const;
     std::vector<coordf_t> generate_object_layers(coordf_t first_layer_height);
     void _slice();
     void find_nonplanar_surfaces();
+    bool restore_planar_slices();
     std::vector<ExPolygons> _slice_region(size_t region_id, std::vector<float> z, bool modifier);
     void _make_perimeters();
     void _infill();
@@ -165,11 +185,21 @@ class PrintObject
     Print* _print;
     ModelObject* _model_object;
     Points _copies;      // Slic3r::Point objects in scaled G-code coordinates
+    /// Region slices as they were before move_nonplanar_surfaces_up() modified them,
+    /// indexed by layer_id * region_count + region_id
+    std::vector<Surfaces> _planar_slices;
 
     // TODO: call model_object->get_bounding_box() instead of accepting
         // parameter
     PrintObject(Print* print, ModelObject* model_object, const BoundingBoxf3 &modobj_bbox);
     ~PrintObject();
+    void _make_slices_do(size_t idx);
+    void _snapshot_region_slices_do(size_t idx, std::vector<Polygons>* region_slices) const;
+    void _detect_surfaces_type_do(size_t idx, const std::vector<Polygons>* region_slices);
+    void _find_identical_layers(size_t (Layer::*hash)() const,
+        bool (Layer::*same)(const Layer&) const,
+        std::vector<Layer*>* unique_layers,
+        std::vector<std::pair<Layer*,const Layer*> >* identical_layers) const;
 };
 
 typedef std::vector<PrintObject*> PrintObjectPtrs;
@@ -189,6 +219,8 @@ class Print
     double total_used_filament, total_extruded_volume, total_cost, total_weight;
     std::map<size_t,float> filament_stats;
     PrintState<PrintStep> state;
+    /// timings and memory use of the steps of the print and of its objects
+    PrintProfile profile;
 
     // ordered collections of extrusion paths to build skirt loops and brim
     ExtrusionEntityCollection skirt, brim;
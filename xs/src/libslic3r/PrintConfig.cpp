@@ -970,6 +970,12 @@ PrintConfigDef::PrintConfigDef()
     def->cli = "overhangs|detect-bridging-perimeters!";
     def->default_value = new ConfigOptionBool(true);
 
+    def = this->add("parallel_gcode", coBool);
+    def->label = "Parallel G-code generation";
+    def->tooltip = "Generate the extrusions of each layer in parallel threads and join them in order afterwards. Every layer then starts its seams and its travels from a fixed point instead of following the previous layer, and an extrusion axis reset is inserted before each layer when using absolute E values. Layers using more than one extruder are still generated sequentially.";
+    def->cli = "parallel-gcode!";
+    def->default_value = new ConfigOptionBool(false);
+
     def = this->add("shortcuts", coStrings);
     def->label = "Shortcuts";
     def->aliases.push_back("overridable");
@@ -1257,6 +1263,15 @@ PrintConfigDef::PrintConfigDef()
     def->enum_values.push_back("250000");
     def->default_value = new ConfigOptionInt(250000);
 
+    def = this->add("serial_rx_buffer", coInt);
+    def->label = "RX buffer";
+    def->full_label = "Firmware RX buffer size";
+    def->tooltip = "Size (bytes) of the serial receive buffer of the firmware. When set, lines are sent ahead of the acknowledgements as long as the unacknowledged ones fit in this buffer, which keeps the command queue of the firmware full on dense G-code. 128 is the default of Marlin, Repetier and Grbl. Set this to zero to wait for each line to be acknowledged before sending the next one.";
+    def->sidetext = "bytes";
+    def->cli = "serial-rx-buffer=i";
+    def->min = 0;
+    def->default_value = new ConfigOptionInt(0);
+
     def = this->add("skirt_distance", coFloat);
     def->label = "Distance from object";
     def->category = "Skirt and brim";
@@ -1283,6 +1298,36 @@ PrintConfigDef::PrintConfigDef()
     def->min = 0;
     def->default_value = new ConfigOptionInt(1);
 
+    def = this->add("slice_cache_dir", coString);
+    def->label = "Slice cache directory";
+    def->tooltip = "If set, the slices of each object are stored in this directory and reused by later jobs slicing the same model with the same layer heights, skipping slicing entirely. Leave empty to disable the cache.";
+    def->cli = "slice-cache-dir=s";
+    def->default_value = new ConfigOptionString("");
+
+    def = this->add("slice_cache_size", coInt);
+    def->label = "Slice cache size";
+    def->tooltip = "Maximum disk space used by the slice cache. The least recently used slices are removed when it grows larger than this.";
+    def->sidetext = "MB";
+    def->cli = "slice-cache-size=i";
+    def->min = 0;
+    def->default_value = new ConfigOptionInt(1024);
+
+    def = this->add("sla_raster_antialiasing", coInt);
+    def->label = "Antialiasing";
+    def->tooltip = "Number of samples taken per pixel along each axis when rasterizing SLA layers, used to render smooth gray edges. Set this to 1 to disable antialiasing.";
+    def->cli = "sla-raster-antialiasing=i";
+    def->min = 1;
+    def->max = 16;
+    def->default_value = new ConfigOptionInt(4);
+
+    def = this->add("sla_raster_dpi", coFloat);
+    def->label = "Raster resolution";
+    def->tooltip = "Resolution of the layer images exported for masked SLA/DLP printers. This should match the pixel density of your printer's projector or LCD.";
+    def->sidetext = "dpi";
+    def->cli = "sla-raster-dpi=f";
+    def->min = 1;
+    def->default_value = new ConfigOptionFloat(254);
+
     def = this->add("slowdown_below_layer_time", coInt);
     def->label = "Slow down if layer print time is below";
     def->tooltip = "If layer print time is estimated below this number of seconds, print moves speed will be scaled down to extend duration to this value.";
@@ -1945,6 +1990,12 @@ CLIConfigDef::CLIConfigDef()
     def->cli = "export-svg";
     def->default_value = new ConfigOptionBool(false);
 
+    def = this->add("export_png", coBool);
+    def->label = "Export PNG";
+    def->tooltip = "Slice the model and export slices as a ZIP archive of PNG images.";
+    def->cli = "export-png";
+    def->default_value = new ConfigOptionBool(false);
+
     def = this->add("export_3mf", coBool);
     def->label = "Export 3MF";
     def->tooltip = "Slice the model and export slices as 3MF.";
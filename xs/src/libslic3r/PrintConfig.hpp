@@ -466,6 +466,7 @@ class PrintConfig : public GCodeConfig
     ConfigOptionBool                only_retract_when_crossing_perimeters;
     ConfigOptionBool                ooze_prevention;
     ConfigOptionString              output_filename_format;
+    ConfigOptionBool                parallel_gcode;
     ConfigOptionFloat               perimeter_acceleration;
     ConfigOptionStrings             post_process;
     ConfigOptionFloat               resolution;
@@ -474,6 +475,8 @@ class PrintConfig : public GCodeConfig
     ConfigOptionFloat               skirt_distance;
     ConfigOptionInt                 skirt_height;
     ConfigOptionInt                 skirts;
+    ConfigOptionString              slice_cache_dir;
+    ConfigOptionInt                 slice_cache_size;
     ConfigOptionInt                 slowdown_below_layer_time;
     ConfigOptionBool                spiral_vase;
     ConfigOptionInt                 standby_temperature_delta;
@@ -528,6 +531,7 @@ class PrintConfig : public GCodeConfig
         OPT_PTR(only_retract_when_crossing_perimeters);
         OPT_PTR(ooze_prevention);
         OPT_PTR(output_filename_format);
+        OPT_PTR(parallel_gcode);
         OPT_PTR(perimeter_acceleration);
         OPT_PTR(post_process);
         OPT_PTR(resolution);
@@ -536,6 +540,8 @@ class PrintConfig : public GCodeConfig
         OPT_PTR(skirt_distance);
         OPT_PTR(skirt_height);
         OPT_PTR(skirts);
+        OPT_PTR(slice_cache_dir);
+        OPT_PTR(slice_cache_size);
         OPT_PTR(slowdown_below_layer_time);
         OPT_PTR(spiral_vase);
         OPT_PTR(standby_temperature_delta);
@@ -562,6 +568,7 @@ class HostConfig : public virtual StaticPrintConfig
     ConfigOptionString              octoprint_apikey;
     ConfigOptionString              serial_port;
     ConfigOptionInt                 serial_speed;
+    ConfigOptionInt                 serial_rx_buffer;
 
     HostConfig(bool initialize = true) : StaticPrintConfig() {
         if (initialize)
@@ -574,6 +581,7 @@ class HostConfig : public virtual StaticPrintConfig
         OPT_PTR(octoprint_apikey);
         OPT_PTR(serial_port);
         OPT_PTR(serial_speed);
+        OPT_PTR(serial_rx_buffer);
 
         return NULL;
     };
@@ -617,11 +625,18 @@ class SLAPrintConfig
     ConfigOptionFloatOrPercent      perimeter_extrusion_width;
     ConfigOptionInt                 raft_layers;
     ConfigOptionFloat               raft_offset;
+    ConfigOptionInt                 sla_raster_antialiasing;
+    ConfigOptionFloat               sla_raster_dpi;
     ConfigOptionBool                support_material;
     ConfigOptionFloatOrPercent      support_material_extrusion_width;
     ConfigOptionFloat               support_material_spacing;
     ConfigOptionInt                 threads;
 
+    SLAPrintConfig(bool initialize = true) : StaticPrintConfig() {
+        if (initialize)
+            this->set_defaults();
+    }
+
     virtual ConfigOption* optptr(const t_config_option_key &opt_key, bool create = false) {
         OPT_PTR(fill_angle);
         OPT_PTR(fill_density);
@@ -632,6 +647,8 @@ class SLAPrintConfig
         OPT_PTR(perimeter_extrusion_width);
         OPT_PTR(raft_layers);
         OPT_PTR(raft_offset);
+        OPT_PTR(sla_raster_antialiasing);
+        OPT_PTR(sla_raster_dpi);
         OPT_PTR(support_material);
         OPT_PTR(support_material_extrusion_width);
         OPT_PTR(support_material_spacing);
@@ -660,6 +677,7 @@ class CLIConfig
     ConfigOptionBool                export_obj;
     ConfigOptionBool                export_pov;
     ConfigOptionBool                export_svg;
+    ConfigOptionBool                export_png;
     ConfigOptionBool                export_3mf;
     ConfigOptionBool                info;
     ConfigOptionStrings             load;
@@ -685,6 +703,7 @@ class CLIConfig
         OPT_PTR(export_obj);
         OPT_PTR(export_pov);
         OPT_PTR(export_svg);
+        OPT_PTR(export_png);
         OPT_PTR(export_3mf);
         OPT_PTR(info);
         OPT_PTR(load);
@@ -2,6 +2,7 @@
 #include "BoundingBox.hpp"
 #include "ClipperUtils.hpp"
 #include "Geometry.hpp"
+#include "SliceCache.hpp"
 #include <boost/version.hpp>
 #if BOOST_VERSION >= 107300
 #include <boost/bind/bind.hpp>
@@ -9,6 +10,7 @@
 #include <algorithm>
 #include <vector>
 #include <limits>
+#include <unordered_map>
 #include "SVG.hpp"
 
 namespace Slic3r {
@@ -20,9 +22,13 @@ using boost::placeholders::_1;
 PrintObject::PrintObject(Print* print, ModelObject* model_object, const BoundingBoxf3 &modobj_bbox)
 :   layer_height_spline(model_object->layer_height_spline),
     typed_slices(false),
+    reuse_identical_layers(true),
     _print(print),
     _model_object(model_object)
 {
+    this->state.profile = &print->profile;
+    this->state.object  = this;
+
     // Compute the translation to be applied to our meshes so that we work with smaller coordinates
     {
         // Translate meshes so that our toolpath generation algorithms work with smaller
@@ -266,6 +272,15 @@ PrintObject::invalidate_state_by_config(const PrintConfigBase &config)
         } else if (opt_key == "interface_shells"
             || opt_key == "infill_only_where_needed") {
             steps.insert(posPrepareInfill);
+        } else if (opt_key == "nonplanar_layers"
+            || opt_key == "nonplanar_layers_angle"
+            || opt_key == "nonplanar_layers_collision_angle"
+            || opt_key == "nonplanar_layers_height"
+            || opt_key == "nonplanar_minimal_area") {
+            steps.insert(posNonplanarDetection);
+        } else if (opt_key == "nonplanar_layers_ignore_collision_size") {
+            // only used when moving the detected surfaces up
+            steps.insert(posPrepareInfill);
         } else if (opt_key == "seam_position"
             || opt_key == "support_material_speed") {
             // these options only affect G-code export, so nothing to invalidate
@@ -299,19 +314,27 @@ PrintObject::invalidate_step(PrintObjectStep step)
     // propagate to dependent steps
     if (step == posPerimeters) {
         invalidated |= this->invalidate_step(posPrepareInfill);
+        invalidated |= this->invalidate_step(posNonplanarProjection);
         invalidated |= this->_print->invalidate_step(psSkirt);
         invalidated |= this->_print->invalidate_step(psBrim);
     } else if (step == posDetectSurfaces) {
         invalidated |= this->invalidate_step(posPrepareInfill);
     } else if (step == posPrepareInfill) {
         invalidated |= this->invalidate_step(posInfill);
+        // release the bridges cached by the previous run
+        this->bridge_angle_cache.clear();
     } else if (step == posInfill) {
+        invalidated |= this->invalidate_step(posNonplanarProjection);
         invalidated |= this->_print->invalidate_step(psSkirt);
         invalidated |= this->_print->invalidate_step(psBrim);
+    } else if (step == posNonplanarDetection) {
+        // surfaces are moved up and projected as part of prepare_infill()
+        invalidated |= this->invalidate_step(posPrepareInfill);
     } else if (step == posSlice) {
         invalidated |= this->invalidate_step(posPerimeters);
         invalidated |= this->invalidate_step(posDetectSurfaces);
         invalidated |= this->invalidate_step(posSupportMaterial);
+        invalidated |= this->invalidate_step(posMotionPlanning);
     }else if (step == posLayers) {
         invalidated |= this->invalidate_step(posSlice);
     } else if (step == posSupportMaterial) {
@@ -352,16 +375,64 @@ PrintObject::detect_surfaces_type()
     if (this->state.is_done(posDetectSurfaces)) return;
     this->state.set_started(posDetectSurfaces);
 
-    parallelize<Layer*>(
-        std::queue<Layer*>(std::deque<Layer*>(this->layers.begin(), this->layers.end())),  // cast LayerPtrs to std::queue<Layer*>
-        boost::bind(&Slic3r::Layer::detect_surfaces_type, _1),
-        this->_print->config.threads.value
-    );
+    const size_t region_count = this->_print->regions.size();
+    if (!this->layers.empty() && region_count > 0) {
+        // Phase 1: snapshot the region slices, since with interface_shells the
+        // classification of a region reads the same region in the neighbor layers
+        // while those are being rewritten.
+        std::vector<Polygons> region_slices;
+        if (this->config.interface_shells.value) {
+            region_slices.resize(this->layers.size() * region_count);
+            parallelize<size_t>(
+                0,
+                region_slices.size()-1,
+                boost::bind(&PrintObject::_snapshot_region_slices_do, this, _1, &region_slices),
+                this->_print->config.threads.value
+            );
+        }
+
+        // Phase 2: classify all the layer regions concurrently and without locking.
+        parallelize<size_t>(
+            0,
+            this->layers.size() * region_count - 1,
+            [this, region_count, &region_slices](size_t idx) {
+                const Layer* layer = this->layers[idx / region_count];
+                PrintProfile::LayerScope scope(&this->_print->profile, this, posDetectSurfaces, layer->id());
+                this->_detect_surfaces_type_do(idx, &region_slices);
+                scope.items = layer->regions[idx % region_count]->slices.surfaces.size();
+            },
+            this->_print->config.threads.value
+        );
+    }
 
     this->typed_slices = true;
     this->state.set_done(posDetectSurfaces);
 }
 
+void
+PrintObject::_snapshot_region_slices_do(size_t idx, std::vector<Polygons>* region_slices) const
+{
+    const size_t region_count = this->_print->regions.size();
+    (*region_slices)[idx] = this->layers[idx / region_count]->get_region(idx % region_count)->slices;
+}
+
+void
+PrintObject::_detect_surfaces_type_do(size_t idx, const std::vector<Polygons>* region_slices)
+{
+    const size_t region_count = this->_print->regions.size();
+    const size_t layer_idx    = idx / region_count;
+    const size_t region_id    = idx % region_count;
+
+    // neighbor slices are only read when interface_shells is enabled
+    static const Polygons empty;
+    const Polygons &upper = (!region_slices->empty() && layer_idx + 1 < this->layers.size())
+        ? (*region_slices)[idx + region_count] : empty;
+    const Polygons &lower = (!region_slices->empty() && layer_idx > 0)
+        ? (*region_slices)[idx - region_count] : empty;
+
+    this->layers[layer_idx]->detect_surfaces_type(region_id, upper, lower);
+}
+
 void
 PrintObject::debug_svg_print()
 {
@@ -518,11 +589,32 @@ PrintObject::move_nonplanar_surfaces_up()
     //skip if not active
     if(!this->config.nonplanar_layers.value) return;
 
+    // keep the planar slices so that the next run doesn't need to reslice the object
+    if (!this->typed_slices) {
+        const size_t region_count = this->_print->regions.size();
+        this->_planar_slices.assign(this->layers.size() * region_count, Surfaces());
+        for (size_t i = 0; i < this->layers.size(); ++i)
+            for (size_t region_id = 0; region_id < region_count; ++region_id)
+                this->_planar_slices[i * region_count + region_id] = this->layers[i]->regions[region_id]->slices.surfaces;
+    }
+
+    //check if surfaces areas collide with the current slices
+    NonplanarSurfaces nonplanar_surfaces = this->nonplanar_surfaces;
+    if (this->config.nonplanar_layers_collision_angle < 90.0) {
+        for (NonplanarSurfaces::iterator it = nonplanar_surfaces.begin(); it!=nonplanar_surfaces.end();) {
+            if(check_nonplanar_collisions((*it),std::distance(nonplanar_surfaces.begin(), it))) {
+                it = nonplanar_surfaces.erase(it);
+            }else {
+                it++;
+            }
+        }
+    }
+
     FOREACH_REGION(this->_print, region_it) {
         size_t region_id = region_it - this->_print->regions.begin();
         const PrintRegion &region = **region_it;
         //assign all nonplanar surfaces to the corresponding layers
-        for (auto& nonplanar_surface: this->nonplanar_surfaces) {
+        for (auto& nonplanar_surface: nonplanar_surfaces) {
             //search home layer where the area is projected to (from top to bottom)
             for (size_t i = this->layers.size()-1; i > 0; i--){
                 //when found, itterate down for number of top nonplanar layers
@@ -610,6 +702,31 @@ PrintObject::move_nonplanar_surfaces_up()
     this->typed_slices = true;
 }
 
+/* Undoes move_nonplanar_surfaces_up() and detect_surfaces_type() by restoring
+   the region slices saved by the former, so that rerunning prepare_infill()
+   doesn't need a full reslice. Returns false if there's nothing to restore. */
+bool
+PrintObject::restore_planar_slices()
+{
+    const size_t region_count = this->_print->regions.size();
+    if (!this->state.is_done(posSlice)
+        || this->_planar_slices.empty()
+        || this->_planar_slices.size() != this->layers.size() * region_count)
+        return false;
+
+    for (size_t i = 0; i < this->layers.size(); ++i) {
+        for (size_t region_id = 0; region_id < region_count; ++region_id) {
+            LayerRegion* layerm = this->layers[i]->regions[region_id];
+            layerm->slices.surfaces = this->_planar_slices[i * region_count + region_id];
+            layerm->nonplanar_surfaces.clear();
+            layerm->distances_to_top.clear();
+        }
+    }
+    this->typed_slices = false;
+    this->state.invalidate(posDetectSurfaces);
+    return true;
+}
+
 void
 PrintObject::project_nonplanar_surfaces()
 {
@@ -621,7 +738,12 @@ PrintObject::project_nonplanar_surfaces()
     this->state.set_started(posNonplanarProjection);
     parallelize<Layer*>(
         std::queue<Layer*>(std::deque<Layer*>(this->layers.begin(), this->layers.end())),  // cast LayerPtrs to std::queue<Layer*>
-        boost::bind(&Slic3r::Layer::project_nonplanar_surfaces, _1),
+        [this](Layer* layer) {
+            PrintProfile::LayerScope scope(&this->_print->profile, this, posNonplanarProjection, layer->id());
+            layer->project_nonplanar_surfaces();
+            for (const LayerRegion* layerm : layer->regions)
+                scope.items += layerm->nonplanar_surfaces.size();
+        },
         this->_print->config.threads.value
     );
 
@@ -636,6 +758,46 @@ PrintObject::process_external_surfaces()
         boost::bind(&Slic3r::Layer::process_external_surfaces, _1),
         this->_print->config.threads.value
     );
+
+    #ifdef SLIC3R_DEBUG
+    {
+        const BridgeAngleCache::Stats stats = this->bridge_angle_cache.stats();
+        printf("Bridge angle cache: %zu hits, %zu misses, %zu entries, %zu bytes\n",
+            stats.hits, stats.misses, stats.entries, stats.memory);
+    }
+    #endif
+}
+
+/* Builds the motion planners used by avoid_crossing_perimeters for all layers
+   in parallel, so that G-code export doesn't have to build them serially */
+void
+PrintObject::build_motion_planners()
+{
+    if (!this->_print->config.avoid_crossing_perimeters.value) return;
+    if (this->state.is_done(posMotionPlanning)) return;
+    this->state.set_started(posMotionPlanning);
+
+    parallelize<Layer*>(
+        std::queue<Layer*>(std::deque<Layer*>(this->layers.begin(), this->layers.end())),  // cast LayerPtrs to std::queue<Layer*>
+        [this](Layer* layer) {
+            PrintProfile::LayerScope scope(&this->_print->profile, this, posMotionPlanning, layer->id());
+            layer->build_motion_planner();
+            scope.items = layer->slices.expolygons.size();
+        },
+        this->_print->config.threads.value
+    );
+
+    #ifdef SLIC3R_DEBUG
+    double total = 0;
+    for (const Layer* layer : this->layers) {
+        printf("Motion planner for layer %zu built in %.3f ms\n",
+            layer->id(), layer->motion_planner->build_time * 1000);
+        total += layer->motion_planner->build_time;
+    }
+    printf("Motion planners built in %.3f s (cumulative)\n", total);
+    #endif
+
+    this->state.set_done(posMotionPlanning);
 }
 
 /* This method applies bridge flow to the first internal solid layer above
@@ -1005,6 +1167,8 @@ std::vector<coordf_t> PrintObject::generate_object_layers(coordf_t first_layer_h
 // this should be idempotent
 void PrintObject::_slice()
 {
+    // the saved planar slices belong to the layers we're about to replace
+    this->_planar_slices.clear();
 
     coordf_t raft_height = 0;
     coordf_t first_layer_height = this->config.first_layer_height.get_abs_value(this->config.layer_height.value);
@@ -1104,8 +1268,6 @@ void PrintObject::_slice()
         }
     }
 
-    this->find_nonplanar_surfaces();
-
     // remove last layer(s) if empty
     bool done = false;
     while (! this->layers.empty()) {
@@ -1122,63 +1284,96 @@ void PrintObject::_slice()
     }
 
     // Apply size compensation and perform clipping of multi-part objects.
-    const coord_t xy_size_compensation = scale_(this->config.xy_size_compensation.value);
-    for (Layer* layer : this->layers) {
-        if (abs(xy_size_compensation) > 0) {
-            if (layer->regions.size() == 1) {
-                // Single region, growing or shrinking.
-                LayerRegion* layerm = layer->regions.front();
-                layerm->slices.set(
-                    offset_ex(to_expolygons(std::move(layerm->slices.surfaces)), xy_size_compensation),
-                    stInternal
-                );
-            } else {
-                // Multiple regions, growing, shrinking or just clipping one region by the other.
-                // When clipping the regions, priority is given to the first regions.
-                Polygons processed;
-                for (size_t region_id = 0; region_id < layer->regions.size(); ++region_id) {
-                    LayerRegion* layerm = layer->regions[region_id];
-                    Polygons slices = layerm->slices;
-
-                    if (abs(xy_size_compensation) > 0)
-                        slices = offset(slices, xy_size_compensation);
-
-                    if (region_id > 0)
-                        // Trim by the slices of already processed regions.
-                        slices = diff(std::move(slices), processed);
-
-                    if (region_id + 1 < layer->regions.size())
-                        // Collect the already processed regions to trim the to be processed regions.
-                        append_to(processed, slices);
+    if (!this->layers.empty()) {
+        parallelize<size_t>(
+            0,
+            this->layers.size()-1,
+            [this](size_t idx) {
+                const Layer* layer = this->layers[idx];
+                PrintProfile::LayerScope scope(&this->_print->profile, this, posSlice, layer->id());
+                this->_make_slices_do(idx);
+                scope.items = layer->slices.expolygons.size();
+            },
+            this->_print->config.threads.value
+        );
+    }
+}
 
-                    layerm->slices.set(union_ex(slices), stInternal);
-                }
-            }
-        }
+/// Post-processes the slices of a single layer: applies xy_size_compensation,
+/// clips the regions by each other, merges them into the layer islands and
+/// applies regions_overlap. The intermediate results are kept as Clipper paths
+/// so that each chain of operations only converts its input and its output.
+void
+PrintObject::_make_slices_do(size_t idx)
+{
+    Layer* layer = this->layers[idx];
+    const coord_t xy_size_compensation = scale_(this->config.xy_size_compensation.value);
 
-        // Merge all regions' slices to get islands, chain them by a shortest path.
-        layer->make_slices();
+    if (abs(xy_size_compensation) > 0) {
+        if (layer->regions.size() == 1) {
+            // Single region, growing or shrinking.
+            LayerRegion* layerm = layer->regions.front();
+            layerm->slices.set(
+                offset_ex(to_expolygons(std::move(layerm->slices.surfaces)), xy_size_compensation),
+                stInternal
+            );
+        } else {
+            // Multiple regions, growing, shrinking or just clipping one region by the other.
+            // When clipping the regions, priority is given to the first regions.
+            ClipperLib::Paths processed;
+            for (size_t region_id = 0; region_id < layer->regions.size(); ++region_id) {
+                LayerRegion* layerm = layer->regions[region_id];
+                ClipperLib::Paths slices = _offset(to_polygons(layerm->slices.surfaces), xy_size_compensation);
+
+                if (region_id > 0)
+                    // Trim by the slices of already processed regions.
+                    slices = _clipper_do<ClipperLib::Paths>(ClipperLib::ctDifference,
+                        std::move(slices), processed, ClipperLib::pftNonZero);
+
+                if (region_id + 1 < layer->regions.size())
+                    // Collect the already processed regions to trim the to be processed regions.
+                    processed.insert(processed.end(), slices.begin(), slices.end());
 
-        // Apply regions overlap
-        if (this->config.regions_overlap.value > 0) {
-            const coord_t delta = scale_(this->config.regions_overlap.value)/2;
-            for (LayerRegion* layerm : layer->regions)
                 layerm->slices.set(
-                    intersection_ex(
-                        offset(layerm->slices, +delta),
-                        layer->slices
-                    ),
+                    _clipper_ex(ClipperLib::ctUnion, std::move(slices), ClipperLib::Paths()),
                     stInternal
                 );
+            }
         }
     }
+
+    // Merge all regions' slices to get islands, chain them by a shortest path.
+    layer->make_slices();
+
+    // Apply regions overlap
+    if (this->config.regions_overlap.value > 0) {
+        const coord_t delta = scale_(this->config.regions_overlap.value)/2;
+        const ClipperLib::Paths layer_slices = Slic3rExPolygons_to_ClipperPaths(layer->slices.expolygons);
+        for (LayerRegion* layerm : layer->regions)
+            layerm->slices.set(
+                _clipper_ex(
+                    ClipperLib::ctIntersection,
+                    _offset(to_polygons(layerm->slices.surfaces), +delta),
+                    layer_slices
+                ),
+                stInternal
+            );
+    }
 }
 
 void
 PrintObject::find_nonplanar_surfaces()
 {
+    if (this->state.is_done(posNonplanarDetection)) return;
+    this->state.set_started(posNonplanarDetection);
+
+    this->nonplanar_surfaces.clear();
+
     //skip if not active
-    if(!this->config.nonplanar_layers.value) return;
+    if(!this->config.nonplanar_layers.value) {
+        this->state.set_done(posNonplanarDetection);
+        return;
+    }
 
     //Itterate over all model volumes
     const ModelVolumePtrs volumes = this->model_object()->volumes;
@@ -1239,19 +1434,10 @@ PrintObject::find_nonplanar_surfaces()
             for (auto& surface : this->nonplanar_surfaces) {
                 surface.translate(-mesh.stl.stats.min.x,-mesh.stl.stats.min.y,-mesh.stl.stats.min.z);
             }
-
-            //check if surfaces areas collide
-            if (this->config.nonplanar_layers_collision_angle < 90.0) {
-                for (NonplanarSurfaces::iterator it = this->nonplanar_surfaces.begin(); it!=this->nonplanar_surfaces.end();) {
-                    if(check_nonplanar_collisions((*it),std::distance(nonplanar_surfaces.begin(), it))) {
-                        it = this->nonplanar_surfaces.erase(it);
-                    }else {
-                        it++;
-                    }
-                }
-            }
         }
     }
+
+    this->state.set_done(posNonplanarDetection);
 }
 
 // called from slice()
@@ -1288,11 +1474,59 @@ PrintObject::_slice_region(size_t region_id, std::vector<float> z, bool modifier
         -object.bounding_box().min.z
     );
 
+    // reuse the slices of a previous job if possible
+    const std::string &cache_dir = this->_print->config.slice_cache_dir.value;
+    if (!cache_dir.empty()) {
+        SliceCache cache(cache_dir, size_t(this->_print->config.slice_cache_size.value) * 1024 * 1024);
+        const uint64_t key = SliceCache::key(mesh, z);
+        if (cache.load(key, &layers)) return layers;
+        TriangleMeshSlicer<Z>(&mesh).slice(z, &layers);
+        cache.store(key, layers);
+        return layers;
+    }
+
     // perform actual slicing
     TriangleMeshSlicer<Z>(&mesh).slice(z, &layers);
     return layers;
 }
 
+/// Splits the layers into the ones needing to be processed and the ones whose
+/// inputs are identical to a previous layer (paired with that layer).
+void
+PrintObject::_find_identical_layers(size_t (Layer::*hash)() const,
+    bool (Layer::*same)(const Layer&) const,
+    std::vector<Layer*>* unique_layers,
+    std::vector<std::pair<Layer*,const Layer*> >* identical_layers) const
+{
+    if (!this->reuse_identical_layers) {
+        unique_layers->insert(unique_layers->end(), this->layers.begin(), this->layers.end());
+        return;
+    }
+
+    std::unordered_multimap<size_t,const Layer*> seen;
+    for (Layer* layer : this->layers) {
+        const size_t h = (layer->*hash)();
+        const Layer* identical = NULL;
+        auto range = seen.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it) {
+            if ((layer->*same)(*it->second)) {
+                identical = it->second;
+                break;
+            }
+        }
+        if (identical != NULL) {
+            identical_layers->push_back(std::make_pair(layer, identical));
+        } else {
+            seen.insert(std::make_pair(h, layer));
+            unique_layers->push_back(layer);
+        }
+    }
+
+    #ifdef SLIC3R_DEBUG
+    printf("%zu layers are identical to a previous one\n", identical_layers->size());
+    #endif
+}
+
 void
 PrintObject::_make_perimeters()
 {
@@ -1401,11 +1635,34 @@ PrintObject::_make_perimeters()
         }
     }
 
+    // only compute the perimeters of the first layer of each set of identical layers
+    std::vector<Layer*> unique_layers;
+    std::vector<std::pair<Layer*,const Layer*> > identical_layers;
+    this->_find_identical_layers(&Layer::perimeters_inputs_hash, &Layer::same_perimeters_inputs,
+        &unique_layers, &identical_layers);
+    for (Layer* layer : unique_layers)
+        layer->perimeters_source = NULL;
+
     parallelize<Layer*>(
-        std::queue<Layer*>(std::deque<Layer*>(this->layers.begin(), this->layers.end())),  // cast LayerPtrs to std::queue<Layer*>
-        boost::bind(&Slic3r::Layer::make_perimeters, _1),
+        std::queue<Layer*>(std::deque<Layer*>(unique_layers.begin(), unique_layers.end())),
+        [this](Layer* layer) {
+            PrintProfile::LayerScope scope(&this->_print->profile, this, posPerimeters, layer->id());
+            layer->make_perimeters();
+            for (const LayerRegion* layerm : layer->regions)
+                scope.items += layerm->perimeters.entities.size() + layerm->thin_fills.entities.size();
+        },
         this->_print->config.threads.value
     );
+    for (const auto &identical : identical_layers)
+        identical.first->copy_perimeters_from(*identical.second);
+
+    #ifdef SLIC3R_DEBUG
+    {
+        const MedialAxisCache::Stats stats = this->medial_axis_cache.stats();
+        printf("Medial axis cache: %zu hits, %zu misses (%.1f%%), %zu entries, %zu bytes\n",
+            stats.hits, stats.misses, stats.hit_rate() * 100, stats.entries, stats.memory);
+    }
+    #endif
 
     /*
         simplify slices (both layer and region slices),
@@ -1417,17 +1674,57 @@ PrintObject::_make_perimeters()
     this->state.set_done(posPerimeters);
 }
 
+/// Estimated cost of LayerRegion::make_fill(), proportional to the length
+/// of the paths it generates.
+static double
+_fill_cost(const LayerRegion &layerm)
+{
+    const double density = layerm.region()->config.fill_density.value / 100;
+    double cost = 0;
+    for (const Surface &surface : layerm.fill_surfaces.surfaces)
+        if (surface.surface_type != stInternalVoid)
+            cost += surface.area() * (surface.is_solid() ? 1. : density);
+    return cost;
+}
+
 void
 PrintObject::_infill()
 {
     if (this->state.is_done(posInfill)) return;
     this->state.set_started(posInfill);
 
-    parallelize<Layer*>(
-        std::queue<Layer*>(std::deque<Layer*>(this->layers.begin(), this->layers.end())),  // cast LayerPtrs to std::queue<Layer*>
-        boost::bind(&Slic3r::Layer::make_fills, _1),
+    // only compute the fills of the first layer of each set of identical layers
+    std::vector<Layer*> unique_layers;
+    std::vector<std::pair<Layer*,const Layer*> > identical_layers;
+    this->_find_identical_layers(&Layer::fills_inputs_hash, &Layer::same_fills_inputs,
+        &unique_layers, &identical_layers);
+    for (Layer* layer : unique_layers)
+        layer->fills_source = NULL;
+
+    // The regions are filled independently, largest first, so that the
+    // large layers (e.g. the solid first ones) don't end up being filled
+    // alone after the others.
+    std::vector<std::pair<double,LayerRegion*> > by_cost;
+    for (Layer* layer : unique_layers)
+        for (LayerRegion* layerm : layer->regions)
+            by_cost.push_back(std::make_pair(_fill_cost(*layerm), layerm));
+    std::stable_sort(by_cost.begin(), by_cost.end(),
+        [](const std::pair<double,LayerRegion*> &a, const std::pair<double,LayerRegion*> &b) { return a.first > b.first; });
+    std::queue<LayerRegion*> queue;
+    for (const auto &region : by_cost)
+        queue.push(region.second);
+    
+    parallelize<LayerRegion*>(
+        queue,
+        [this](LayerRegion* layerm) {
+            PrintProfile::LayerScope scope(&this->_print->profile, this, posInfill, layerm->layer()->id());
+            layerm->make_fill();
+            scope.items = layerm->fills.entities.size();
+        },
         this->_print->config.threads.value
     );
+    for (const auto &identical : identical_layers)
+        identical.first->copy_fills_from(*identical.second);
 
     /*  we could free memory now, but this would make this step not idempotent
     ### $_->fill_surfaces->clear for map @{$_->regions}, @{$object->layers};
@@ -0,0 +1,279 @@
+#include "PrintProfile.hpp"
+#include "Print.hpp"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#ifdef _WIN32
+// GetProcessMemoryInfo() from kernel32 rather than psapi.dll
+#ifndef PSAPI_VERSION
+#define PSAPI_VERSION 2
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace Slic3r {
+
+void
+ProfileCounters::add(const ProfileCounters &other)
+{
+    this->wall_time         += other.wall_time;
+    this->cpu_time          += other.cpu_time;
+    this->peak_rss_delta    += other.peak_rss_delta;
+    this->items             += other.items;
+}
+
+#ifdef _WIN32
+static double
+_filetime_seconds(const FILETIME &time)
+{
+    // in units of 100 ns
+    return (double(time.dwHighDateTime) * 4294967296. + double(time.dwLowDateTime)) * 1e-7;
+}
+#else
+static double
+_clock_seconds(clockid_t clock)
+{
+    timespec ts;
+    if (clock_gettime(clock, &ts) != 0) return 0;
+    return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+}
+#endif
+
+PrintProfile::Snapshot
+PrintProfile::Snapshot::now()
+{
+    Snapshot snapshot;
+    snapshot.wall = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    snapshot.process_cpu    = 0;
+    snapshot.thread_cpu     = 0;
+    snapshot.peak_rss       = 0;
+
+    #ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        snapshot.process_cpu = _filetime_seconds(kernel) + _filetime_seconds(user);
+    if (GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        snapshot.thread_cpu = _filetime_seconds(kernel) + _filetime_seconds(user);
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))
+        snapshot.peak_rss = memory.PeakWorkingSetSize;
+    #else
+    snapshot.process_cpu    = _clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    snapshot.thread_cpu     = _clock_seconds(CLOCK_THREAD_CPUTIME_ID);
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        #ifdef __APPLE__
+        snapshot.peak_rss = size_t(usage.ru_maxrss);            // bytes
+        #else
+        snapshot.peak_rss = size_t(usage.ru_maxrss) * 1024;     // kilobytes
+        #endif
+    }
+    #endif
+    return snapshot;
+}
+
+PrintProfile::LayerScope::LayerScope(PrintProfile* profile, const PrintObject* object, int step, size_t layer_id)
+:   items(0), _profile(profile), _object(object), _step(step), _layer_id(layer_id),
+    _start(Snapshot::now())
+{
+}
+
+PrintProfile::LayerScope::~LayerScope()
+{
+    if (this->_profile == NULL) return;
+    const Snapshot end = Snapshot::now();
+    ProfileCounters counters;
+    counters.wall_time      = end.wall - this->_start.wall;
+    counters.cpu_time       = end.thread_cpu - this->_start.thread_cpu;
+    counters.peak_rss_delta = end.peak_rss - this->_start.peak_rss;
+    counters.items          = this->items;
+    this->_profile->_add_layer(this->_object, this->_step, this->_layer_id, counters);
+}
+
+void
+PrintProfile::step_started(const PrintObject* object, int step)
+{
+    const Snapshot start = Snapshot::now();
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    Step &record = this->_steps[StepKey(object, step)];
+    record.running  = true;
+    record.start    = start;
+}
+
+void
+PrintProfile::step_done(const PrintObject* object, int step)
+{
+    const Snapshot end = Snapshot::now();
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    std::map<StepKey,Step>::iterator it = this->_steps.find(StepKey(object, step));
+    // steps may be marked as done without having been started
+    if (it == this->_steps.end() || !it->second.running) return;
+    Step &record = it->second;
+    record.total.wall_time      += end.wall - record.start.wall;
+    record.total.cpu_time       += end.process_cpu - record.start.process_cpu;
+    record.total.peak_rss_delta += end.peak_rss - record.start.peak_rss;
+    ++record.runs;
+    record.running = false;
+}
+
+void
+PrintProfile::step_invalidated(const PrintObject* object, int step)
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    std::map<StepKey,Step>::iterator it = this->_steps.find(StepKey(object, step));
+    if (it != this->_steps.end())
+        it->second.running = false;
+}
+
+void
+PrintProfile::add_items(const PrintObject* object, int step, size_t items)
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    std::map<StepKey,Step>::iterator it = this->_steps.find(StepKey(object, step));
+    if (it != this->_steps.end() && it->second.running)
+        it->second.total.items += items;
+}
+
+void
+PrintProfile::_add_layer(const PrintObject* object, int step, size_t layer_id, const ProfileCounters &counters)
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    std::map<StepKey,Step>::iterator it = this->_steps.find(StepKey(object, step));
+    // layers processed outside of their step, e.g. by tests
+    if (it == this->_steps.end() || !it->second.running) return;
+    it->second.layers[layer_id].add(counters);
+    it->second.total.items += counters.items;
+}
+
+void
+PrintProfile::forget(const PrintObject* object)
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    this->_steps.erase(
+        this->_steps.lower_bound(StepKey(object, INT_MIN)),
+        this->_steps.upper_bound(StepKey(object, INT_MAX))
+    );
+}
+
+void
+PrintProfile::clear()
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    // keep the start of running steps
+    for (std::map<StepKey,Step>::iterator it = this->_steps.begin(); it != this->_steps.end(); ++it) {
+        it->second.total    = ProfileCounters();
+        it->second.runs     = 0;
+        it->second.layers.clear();
+    }
+}
+
+static const char*
+_step_name(const PrintObject* object, int step)
+{
+    if (object == NULL) {
+        switch (PrintStep(step)) {
+            case psSkirt:                   return "skirt";
+            case psBrim:                    return "brim";
+        }
+    } else {
+        switch (PrintObjectStep(step)) {
+            case posLayers:                 return "layers";
+            case posSlice:                  return "slice";
+            case posPerimeters:             return "perimeters";
+            case posDetectSurfaces:         return "detect_surfaces";
+            case posPrepareInfill:          return "prepare_infill";
+            case posInfill:                 return "infill";
+            case posSupportMaterial:        return "support_material";
+            case posNonplanarDetection:     return "nonplanar_detection";
+            case posNonplanarProjection:    return "nonplanar_projection";
+            case posMotionPlanning:         return "motion_planning";
+        }
+    }
+    return "unknown";
+}
+
+static void
+_json_string(const std::string &str, std::string* json)
+{
+    *json += '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            *json += '\\';
+            *json += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)c);
+            *json += buf;
+        } else {
+            *json += c;
+        }
+    }
+    *json += '"';
+}
+
+void
+PrintProfile::_counters_json(const ProfileCounters &counters, std::string* json)
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "\"wall_time\": %.6f, \"cpu_time\": %.6f, \"peak_rss_delta\": %lu, \"items\": %lu",
+        counters.wall_time, counters.cpu_time,
+        (unsigned long)counters.peak_rss_delta, (unsigned long)counters.items);
+    *json += buf;
+}
+
+void
+PrintProfile::_steps_json(const PrintObject* object, const std::string &indent, std::string* json) const
+{
+    *json += "[";
+    bool first_step = true;
+    for (std::map<StepKey,Step>::const_iterator it = this->_steps.lower_bound(StepKey(object, INT_MIN));
+        it != this->_steps.end() && it->first.first == object; ++it) {
+        const Step &record = it->second;
+        if (record.runs == 0) continue;
+        *json += first_step ? "\n" : ",\n";
+        first_step = false;
+        *json += indent + "  {\"step\": ";
+        _json_string(_step_name(object, it->first.second), json);
+        *json += ", \"runs\": " + std::to_string(record.runs) + ", ";
+        _counters_json(record.total, json);
+        *json += ", \"layers\": [";
+        bool first_layer = true;
+        for (std::map<size_t,ProfileCounters>::const_iterator layer = record.layers.begin(); layer != record.layers.end(); ++layer) {
+            *json += first_layer ? "\n" : ",\n";
+            first_layer = false;
+            *json += indent + "    {\"id\": " + std::to_string(layer->first) + ", ";
+            _counters_json(layer->second, json);
+            *json += "}";
+        }
+        *json += first_layer ? "]}" : "\n" + indent + "  ]}";
+    }
+    *json += first_step ? "]" : "\n" + indent + "]";
+}
+
+std::string
+PrintProfile::to_json(const std::vector<PrintObject*> &objects) const
+{
+    const Snapshot now = Snapshot::now();
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+
+    std::string json = "{\n  \"peak_rss\": " + std::to_string(now.peak_rss) + ",\n";
+    json += "  \"steps\": ";
+    this->_steps_json(NULL, "  ", &json);
+    json += ",\n  \"objects\": [";
+    for (size_t i = 0; i < objects.size(); ++i) {
+        json += i == 0 ? "\n" : ",\n";
+        json += "    {\"id\": " + std::to_string(i) + ", \"name\": ";
+        _json_string(objects[i]->model_object()->name, &json);
+        json += ", \"steps\": ";
+        this->_steps_json(objects[i], "    ", &json);
+        json += "}";
+    }
+    json += objects.empty() ? "]\n}\n" : "\n  ]\n}\n";
+    return json;
+}
+
+}
@@ -0,0 +1,107 @@
+#ifndef slic3r_PrintProfile_hpp_
+#define slic3r_PrintProfile_hpp_
+
+#include "libslic3r.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/thread.hpp>
+
+namespace Slic3r {
+
+class PrintObject;
+
+/// Resources used by a step, or by a layer within a step.
+struct ProfileCounters {
+    double wall_time;       ///< seconds
+    /// seconds of CPU time: of all the threads of the process for a step,
+    /// of the thread processing the layer for a layer
+    double cpu_time;
+    /// growth of the peak resident set size of the process, in bytes
+    size_t peak_rss_delta;
+    /// objects produced, e.g. slices, surfaces or extrusion entities
+    size_t items;
+
+    ProfileCounters() : wall_time(0), cpu_time(0), peak_rss_delta(0), items(0) {};
+    void add(const ProfileCounters &other);
+};
+
+/// Timings and memory use of the steps of a Print and of its objects, and
+/// of each layer within those steps.
+/// Steps are recorded by PrintState between set_started() and set_done(),
+/// whether they run in C++ or in Perl. Layers are recorded by a LayerScope
+/// in the functions processing a single layer, and only while their step
+/// is running. A step that runs again after being invalidated adds to its
+/// previous runs.
+/// Recording a step or a layer costs a few system calls, so profiling is
+/// always on. All methods are thread-safe.
+class PrintProfile {
+    public:
+    /// Time and resources used by the process up to a point.
+    struct Snapshot {
+        double wall;
+        double process_cpu;
+        double thread_cpu;
+        size_t peak_rss;
+
+        static Snapshot now();
+    };
+
+    /// Records the layer of a running step from its construction to its
+    /// destruction. Several scopes for the same layer (e.g. one per region)
+    /// add up.
+    class LayerScope {
+        public:
+        size_t items;
+
+        LayerScope(PrintProfile* profile, const PrintObject* object, int step, size_t layer_id);
+        ~LayerScope();
+
+        private:
+        PrintProfile* _profile;
+        const PrintObject* _object;
+        int _step;
+        size_t _layer_id;
+        Snapshot _start;
+    };
+
+    /// object is NULL for the steps of the Print (PrintStep), and the
+    /// PrintObject of the step (PrintObjectStep) otherwise.
+    void step_started(const PrintObject* object, int step);
+    void step_done(const PrintObject* object, int step);
+    /// Drops the current run of the step if it is running.
+    void step_invalidated(const PrintObject* object, int step);
+    /// Adds to the items of a running step.
+    void add_items(const PrintObject* object, int step, size_t items);
+    /// Drops the records of a deleted object.
+    void forget(const PrintObject* object);
+    void clear();
+
+    /// The records of the print steps and of the steps of objects, in the
+    /// order of objects. Objects that aren't in objects are left out.
+    std::string to_json(const std::vector<PrintObject*> &objects) const;
+
+    private:
+    struct Step {
+        ProfileCounters total;
+        size_t runs;
+        bool running;
+        Snapshot start;
+        std::map<size_t,ProfileCounters> layers;
+
+        Step() : runs(0), running(false) {};
+    };
+    typedef std::pair<const PrintObject*,int> StepKey;
+
+    mutable boost::mutex _mutex;
+    std::map<StepKey,Step> _steps;
+
+    void _add_layer(const PrintObject* object, int step, size_t layer_id, const ProfileCounters &counters);
+    static void _counters_json(const ProfileCounters &counters, std::string* json);
+    void _steps_json(const PrintObject* object, const std::string &indent, std::string* json) const;
+};
+
+}
+
+#endif
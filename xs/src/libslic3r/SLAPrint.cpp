@@ -1,9 +1,12 @@
 #include "SLAPrint.hpp"
 #include "ClipperUtils.hpp"
+#include "ExPolygonGrid.hpp"
 #include "ExtrusionEntity.hpp"
 #include "Fill/Fill.hpp"
 #include "Geometry.hpp"
 #include "Surface.hpp"
+#include "Zip/ZipArchive.hpp"
+#include <algorithm>
 #include <iostream>
 #include <complex>
 #include <cstdio>
@@ -84,62 +87,43 @@ SLAPrint::slice()
     this->sm_pillars.clear();
     ExPolygons overhangs;
     if (this->config.support_material) {
-        // flatten and merge all the overhangs
-        {
-            Polygons pp;
-            for (std::vector<Layer>::const_iterator it = this->layers.begin()+1; it != this->layers.end(); ++it)
-                pp += diff(it->slices, (it - 1)->slices);
-            overhangs = union_ex(pp);
-        }
+        overhangs = this->_detect_overhangs();
         
         // generate points following the shape of each island
         Points pillars_pos;
-        const coordf_t spacing = scale_(this->config.support_material_spacing);
-        const coordf_t radius  = scale_(this->sm_pillars_radius());
-        for (ExPolygons::const_iterator it = overhangs.begin(); it != overhangs.end(); ++it) {
-            // leave a radius/2 gap between pillars and contour to prevent lateral adhesion
-            for (float inset = radius * 1.5;; inset += spacing) {
-                // inset according to the configured spacing
-                Polygons curr = offset(*it, -inset);
-                if (curr.empty()) break;
-                
-                // generate points along the contours
-                for (Polygons::const_iterator pg = curr.begin(); pg != curr.end(); ++pg) {
-                    Points pp = pg->equally_spaced_points(spacing);
-                    for (Points::const_iterator p = pp.begin(); p != pp.end(); ++p)
-                        pillars_pos.push_back(*p);
-                }
-            }
+        {
+            std::vector<Points> island_pos(overhangs.size());
+            if (!overhangs.empty())
+                parallelize<size_t>(
+                    0,
+                    overhangs.size()-1,
+                    boost::bind(&SLAPrint::_pillars_positions, this, _1, &overhangs, &island_pos),
+                    this->config.threads.value
+                );
+            for (std::vector<Points>::const_iterator it = island_pos.begin(); it != island_pos.end(); ++it)
+                append_to(pillars_pos, *it);
         }
         
+        // index the slices of each layer for fast point containment queries
+        std::vector<ExPolygonGrid> grids(this->layers.size());
+        parallelize<size_t>(
+            0,
+            this->layers.size()-1,
+            boost::bind(&SLAPrint::_index_layer, this, _1, &grids),
+            this->config.threads.value
+        );
+        
         // for each pillar, check which layers it applies to
-        for (Points::const_iterator p = pillars_pos.begin(); p != pillars_pos.end(); ++p) {
-            SupportPillar pillar(*p);
-            bool object_hit = false;
-            
-            // check layers top-down
-            for (int i = this->layers.size()-1; i >= 0; --i) {
-                // check whether point is void in this layer
-                if (!this->layers[i].slices.contains(*p)) {
-                    // no slice contains the point, so it's in the void
-                    if (pillar.top_layer > 0) {
-                        // we have a pillar, so extend it
-                        pillar.bottom_layer = i + this->config.raft_layers;
-                    } else if (object_hit) {
-                        // we don't have a pillar and we're below the object, so create one
-                        pillar.top_layer = i + this->config.raft_layers;
-                    }
-                } else {
-                    if (pillar.top_layer > 0) {
-                        // we have a pillar which is not needed anymore, so store it and initialize a new potential pillar
-                        this->sm_pillars.push_back(pillar);
-                        pillar = SupportPillar(*p);
-                    }
-                    object_hit = true;
-                }
-            }
-            if (pillar.top_layer > 0) this->sm_pillars.push_back(pillar);
-        }
+        std::vector<std::vector<SupportPillar> > pillars(pillars_pos.size());
+        if (!pillars_pos.empty())
+            parallelize<size_t>(
+                0,
+                pillars_pos.size()-1,
+                boost::bind(&SLAPrint::_resolve_pillar, this, _1, &pillars_pos, &grids, &pillars),
+                this->config.threads.value
+            );
+        for (std::vector<std::vector<SupportPillar> >::const_iterator it = pillars.begin(); it != pillars.end(); ++it)
+            this->sm_pillars.insert(this->sm_pillars.end(), it->begin(), it->end());
     }
     
     // generate a solid raft if requested
@@ -213,6 +197,107 @@ SLAPrint::_infill_layer(size_t i, const Fill* _fill)
     );
 }
 
+ExPolygons
+SLAPrint::_detect_overhangs() const
+{
+    if (this->layers.size() < 2) return ExPolygons();
+    
+    // compute the overhangs of each layer in parallel
+    std::vector<Polygons> overhangs(this->layers.size()-1);
+    parallelize<size_t>(
+        0,
+        overhangs.size()-1,
+        boost::bind(&SLAPrint::_overhangs_layer, this, _1, &overhangs),
+        this->config.threads.value
+    );
+    
+    // Flatten and merge them pairwise, so that each union only deals with
+    // a limited number of polygons instead of the whole stack at once.
+    while (overhangs.size() > 1) {
+        std::vector<Polygons> merged((overhangs.size() + 1) / 2);
+        parallelize<size_t>(
+            0,
+            merged.size()-1,
+            boost::bind(&SLAPrint::_union_pair, _1, &overhangs, &merged),
+            this->config.threads.value
+        );
+        overhangs.swap(merged);
+    }
+    return union_ex(overhangs.front());
+}
+
+void
+SLAPrint::_overhangs_layer(size_t i, std::vector<Polygons>* overhangs) const
+{
+    (*overhangs)[i] = diff(this->layers[i+1].slices, this->layers[i].slices);
+}
+
+void
+SLAPrint::_union_pair(size_t i, const std::vector<Polygons>* polygons, std::vector<Polygons>* merged)
+{
+    if (2*i + 1 < polygons->size()) {
+        (*merged)[i] = union_((*polygons)[2*i], (*polygons)[2*i + 1]);
+    } else {
+        (*merged)[i] = (*polygons)[2*i];
+    }
+}
+
+void
+SLAPrint::_pillars_positions(size_t i, const ExPolygons* overhangs, std::vector<Points>* positions) const
+{
+    const coordf_t spacing = scale_(this->config.support_material_spacing);
+    const coordf_t radius  = scale_(this->sm_pillars_radius());
+    
+    // leave a radius/2 gap between pillars and contour to prevent lateral adhesion
+    for (float inset = radius * 1.5;; inset += spacing) {
+        // inset according to the configured spacing
+        Polygons curr = offset((*overhangs)[i], -inset);
+        if (curr.empty()) break;
+        
+        // generate points along the contours
+        for (Polygons::const_iterator pg = curr.begin(); pg != curr.end(); ++pg)
+            append_to((*positions)[i], pg->equally_spaced_points(spacing));
+    }
+}
+
+void
+SLAPrint::_index_layer(size_t i, std::vector<ExPolygonGrid>* grids) const
+{
+    (*grids)[i] = ExPolygonGrid(this->layers[i].slices.expolygons);
+}
+
+void
+SLAPrint::_resolve_pillar(size_t i, const Points* positions, const std::vector<ExPolygonGrid>* grids,
+    std::vector<std::vector<SupportPillar> >* pillars) const
+{
+    const Point &p = (*positions)[i];
+    SupportPillar pillar(p);
+    bool object_hit = false;
+    
+    // check layers top-down
+    for (int j = this->layers.size()-1; j >= 0; --j) {
+        // check whether point is void in this layer
+        if (!(*grids)[j].contains(p)) {
+            // no slice contains the point, so it's in the void
+            if (pillar.top_layer > 0) {
+                // we have a pillar, so extend it
+                pillar.bottom_layer = j + this->config.raft_layers;
+            } else if (object_hit) {
+                // we don't have a pillar and we're below the object, so create one
+                pillar.top_layer = j + this->config.raft_layers;
+            }
+        } else {
+            if (pillar.top_layer > 0) {
+                // we have a pillar which is not needed anymore, so store it and initialize a new potential pillar
+                (*pillars)[i].push_back(pillar);
+                pillar = SupportPillar(p);
+            }
+            object_hit = true;
+        }
+    }
+    if (pillar.top_layer > 0) (*pillars)[i].push_back(pillar);
+}
+
 void
 SLAPrint::write_svg(const std::string &outputfile) const
 {
@@ -312,6 +397,201 @@ SLAPrint::write_svg(const std::string &outputfile) const
     fclose(f);
 }
 
+bool
+SLAPrint::write_png_zip(const std::string &outputfile) const
+{
+    ZipArchive zip(outputfile, 'W');
+    if (!zip.z_stats()) return false;
+    
+    // Rasterize a few layers per thread at a time and write them to the archive
+    // in order before moving on, so that memory usage doesn't grow with the
+    // number of layers.
+    const size_t threads = std::max(1, this->config.threads.value);
+    const size_t batch_size = threads * 4;
+    std::vector<std::string> frames(this->layers.size());
+    
+    for (size_t start = 0; start < this->layers.size(); start += batch_size) {
+        const size_t end = std::min(start + batch_size, this->layers.size()) - 1;
+        parallelize<size_t>(
+            start,
+            end,
+            boost::bind(&SLAPrint::_rasterize_layer, this, _1, &frames),
+            threads
+        );
+        
+        for (size_t i = start; i <= end; ++i) {
+            char name[32];
+            sprintf(name, "layer%05zu.png", i);
+            // PNG data is already deflated
+            if (frames[i].empty()
+                || !zip.add_entry(name, frames[i].data(), frames[i].size(), MZ_NO_COMPRESSION))
+                return false;
+            std::string().swap(frames[i]);
+        }
+    }
+    return zip.finalize();
+}
+
+Polygons
+SLAPrint::_layer_raster_polygons(size_t i) const
+{
+    const Layer &layer = this->layers[i];
+    
+    Polygons pp;
+    if (layer.solid) {
+        pp = layer.slices;
+    } else {
+        pp = layer.perimeters;
+        append_to(pp, (Polygons)layer.solid_infill);
+        
+        // no need to union the grown infill paths as the rasterizer
+        // fills overlapping polygons using the nonzero winding rule
+        for (ExtrusionEntitiesPtr::const_iterator it = layer.infill.entities.begin();
+            it != layer.infill.entities.end(); ++it)
+            append_to(pp, (*it)->grow());
+    }
+    
+    // don't print support material in raft layers
+    if (i >= (size_t)this->config.raft_layers) {
+        const double support_material_radius = sm_pillars_radius();
+        for (std::vector<SupportPillar>::const_iterator it = this->sm_pillars.begin(); it != this->sm_pillars.end(); ++it) {
+            if (!(it->top_layer >= i && it->bottom_layer <= i)) continue;
+            
+            // generate a conic tip
+            const double radius = scale_(std::min(
+                support_material_radius,
+                (it->top_layer - i + 1) * this->config.layer_height.value
+            ));
+            
+            const int segments = 32;
+            Polygon circle;
+            circle.points.reserve(segments);
+            for (int k = 0; k < segments; ++k) {
+                const double angle = 2 * PI * k / segments;
+                circle.points.push_back(Point(it->x + radius * cos(angle), it->y + radius * sin(angle)));
+            }
+            pp.push_back(circle);
+        }
+    }
+    return pp;
+}
+
+void
+SLAPrint::_rasterize_layer(size_t i, std::vector<std::string>* frames) const
+{
+    const Sizef3 size       = this->bb.size();
+    const double px_per_mm  = this->config.sla_raster_dpi.value / 25.4;
+    const int samples       = std::max(1, this->config.sla_raster_antialiasing.value);
+    const int width         = std::max(1, (int)ceil(size.x * px_per_mm));
+    const int height        = std::max(1, (int)ceil(size.y * px_per_mm));
+    
+    // Collect the polygon edges in subsample coordinates, mirroring Y as
+    // images are stored top-down.
+    struct Edge {
+        double x0, y0, y1, dxdy;
+        int winding;
+        bool operator<(const Edge &other) const { return this->y0 < other.y0; };
+    };
+    std::vector<Edge> edges;
+    {
+        const double scale = px_per_mm * samples;
+        const Polygons pp = this->_layer_raster_polygons(i);
+        for (Polygons::const_iterator pg = pp.begin(); pg != pp.end(); ++pg) {
+            const Points &points = pg->points;
+            for (size_t j = 0; j < points.size(); ++j) {
+                const Point &a = points[j];
+                const Point &b = points[(j+1) % points.size()];
+                double ax = (unscale(a.x) - this->bb.min.x) * scale;
+                double ay = (this->bb.max.y - unscale(a.y)) * scale;
+                double bx = (unscale(b.x) - this->bb.min.x) * scale;
+                double by = (this->bb.max.y - unscale(b.y)) * scale;
+                if (ay == by) continue;
+                
+                Edge e;
+                e.winding = (ay < by) ? 1 : -1;
+                if (ay > by) {
+                    std::swap(ax, bx);
+                    std::swap(ay, by);
+                }
+                e.x0    = ax;
+                e.y0    = ay;
+                e.y1    = by;
+                e.dxdy  = (bx - ax) / (by - ay);
+                edges.push_back(e);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+    }
+    
+    // Scanline fill: each pixel row accumulates the number of covered
+    // subsamples, which is then converted to a gray level.
+    std::vector<unsigned char> image(width * height, 0);
+    std::vector<int> coverage(width);
+    std::vector<const Edge*> active;
+    std::vector<std::pair<double,int> > crossings;
+    const int max_subcolumn = width * samples;
+    size_t next_edge = 0;
+    
+    for (int row = 0; row < height; ++row) {
+        std::fill(coverage.begin(), coverage.end(), 0);
+        
+        for (int s = 0; s < samples; ++s) {
+            const double y = row * samples + s + 0.5;
+            
+            // update the active edge list
+            while (next_edge < edges.size() && edges[next_edge].y0 <= y)
+                active.push_back(&edges[next_edge++]);
+            size_t n = 0;
+            for (size_t k = 0; k < active.size(); ++k)
+                if (active[k]->y1 > y) active[n++] = active[k];
+            active.resize(n);
+            if (active.empty()) continue;
+            
+            crossings.clear();
+            for (std::vector<const Edge*>::const_iterator e = active.begin(); e != active.end(); ++e)
+                crossings.push_back(std::make_pair((*e)->x0 + (y - (*e)->y0) * (*e)->dxdy, (*e)->winding));
+            std::sort(crossings.begin(), crossings.end());
+            
+            // fill spans using the nonzero winding rule
+            int winding = 0;
+            double span_start = 0;
+            for (std::vector<std::pair<double,int> >::const_iterator c = crossings.begin(); c != crossings.end(); ++c) {
+                const int prev = winding;
+                winding += c->second;
+                if (prev == 0 && winding != 0) {
+                    span_start = c->first;
+                } else if (prev != 0 && winding == 0) {
+                    // subsamples whose center lies within [span_start, c->first)
+                    const int k0 = std::max(0, (int)ceil(span_start - 0.5));
+                    const int k1 = std::min(max_subcolumn, (int)ceil(c->first - 0.5));
+                    if (k0 >= k1) continue;
+                    const int px0 = k0 / samples;
+                    const int px1 = (k1 - 1) / samples;
+                    if (px0 == px1) {
+                        coverage[px0] += k1 - k0;
+                    } else {
+                        coverage[px0] += (px0 + 1) * samples - k0;
+                        for (int px = px0 + 1; px < px1; ++px)
+                            coverage[px] += samples;
+                        coverage[px1] += k1 - px1 * samples;
+                    }
+                }
+            }
+        }
+        
+        const int total = samples * samples;
+        unsigned char* line = &image[row * width];
+        for (int px = 0; px < width; ++px)
+            line[px] = (coverage[px] * 255 + total/2) / total;
+    }
+    
+    size_t png_size = 0;
+    void* png = tdefl_write_image_to_png_file_in_memory_ex(&image.front(), width, height, 1, &png_size, MZ_BEST_SPEED, false);
+    if (png == NULL) return;
+    (*frames)[i].assign((const char*)png, png_size);
+    mz_free(png);
+}
+
 coordf_t
 SLAPrint::sm_pillars_radius() const
 {
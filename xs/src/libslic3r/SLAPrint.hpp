@@ -4,6 +4,7 @@
 #include "libslic3r.h"
 #include "ExPolygon.hpp"
 #include "ExPolygonCollection.hpp"
+#include "ExPolygonGrid.hpp"
 #include "Fill/Fill.hpp"
 #include "Model.hpp"
 #include "Point.hpp"
@@ -42,11 +43,27 @@ class SLAPrint
     void slice();
     void write_svg(const std::string &outputfile) const;
     
+    /// Rasterizes all layers to grayscale PNG images at config.sla_raster_dpi
+    /// and stores them in a ZIP archive, one entry per layer.
+    /// Layers are rasterized in parallel in batches, so that only a bounded
+    /// number of frames is held in memory while the archive is written in order.
+    /// Returns false if the archive could not be written.
+    bool write_png_zip(const std::string &outputfile) const;
+    
     private:
     Model* model;
     BoundingBoxf3 bb;
     
     void _infill_layer(size_t i, const Fill* fill);
+    ExPolygons _detect_overhangs() const;
+    void _overhangs_layer(size_t i, std::vector<Polygons>* overhangs) const;
+    static void _union_pair(size_t i, const std::vector<Polygons>* polygons, std::vector<Polygons>* merged);
+    void _pillars_positions(size_t i, const ExPolygons* overhangs, std::vector<Points>* positions) const;
+    void _index_layer(size_t i, std::vector<ExPolygonGrid>* grids) const;
+    void _resolve_pillar(size_t i, const Points* positions, const std::vector<ExPolygonGrid>* grids,
+        std::vector<std::vector<SupportPillar> >* pillars) const;
+    Polygons _layer_raster_polygons(size_t i) const;
+    void _rasterize_layer(size_t i, std::vector<std::string>* frames) const;
     coordf_t sm_pillars_radius() const;
     std::string _SVG_path_d(const Polygon &polygon) const;
     std::string _SVG_path_d(const ExPolygon &expolygon) const;
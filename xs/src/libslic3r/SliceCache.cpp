@@ -0,0 +1,280 @@
+#include "SliceCache.hpp"
+#include "GeometryHash.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/convert.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/version.hpp>
+
+namespace Slic3r {
+
+// bump this whenever the file format or the slicer output changes
+static const uint32_t SLICE_CACHE_VERSION = 1;
+static const char SLICE_CACHE_MAGIC[4] = { 'S', '3', 'S', 'C' };
+static const char SLICE_CACHE_EXTENSION[] = ".slices";
+
+// Paths are kept in UTF-8 and converted by _native() before being handed to
+// boost::filesystem and boost::interprocess: non-ASCII paths need the wide
+// character API on Windows, as in stl_open(); Boost.Interprocess only has it
+// since 1.77.
+#if defined(_WIN32) && BOOST_VERSION >= 107700
+static std::wstring
+_native(const std::string &path)
+{
+    return boost::nowide::widen(path);
+}
+#else
+static const std::string&
+_native(const std::string &path)
+{
+    return path;
+}
+#endif
+
+// Header: magic, version, key, layer count. The rest of the file is a stream
+// of varints: for each layer the number of expolygons, for each expolygon the
+// number of holes and then its polygons, each stored as the number of points
+// followed by zigzag-encoded deltas from the previous point.
+struct SliceCacheHeader {
+    char        magic[4];
+    uint32_t    version;
+    uint64_t    key;
+    uint64_t    layers;
+};
+
+static void
+_write_varint(std::string* out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out->push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(char(value));
+}
+
+static void
+_write_coord(std::string* out, coord_t value)
+{
+    const int64_t v = int64_t(value);
+    _write_varint(out, (uint64_t(v) << 1) ^ uint64_t(v >> 63));
+}
+
+static void
+_write_polygon(std::string* out, const Polygon &polygon)
+{
+    _write_varint(out, polygon.points.size());
+    coord_t x = 0, y = 0;
+    for (const Point &p : polygon.points) {
+        _write_coord(out, p.x - x);
+        _write_coord(out, p.y - y);
+        x = p.x;
+        y = p.y;
+    }
+}
+
+// Bounds-checked reader over the mapped file; any read past the end
+// marks the whole entry as invalid.
+struct SliceCacheReader {
+    const unsigned char* ptr;
+    const unsigned char* end;
+    bool ok;
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (ptr == end) break;
+            const unsigned char byte = *ptr++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        ok = false;
+        return 0;
+    };
+    coord_t coord() {
+        const uint64_t v = this->varint();
+        return coord_t(int64_t(v >> 1) ^ -int64_t(v & 1));
+    };
+    // guards against allocating huge vectors out of a corrupted count,
+    // as each item takes at least one byte
+    size_t count() {
+        const uint64_t n = this->varint();
+        if (n > uint64_t(end - ptr)) ok = false;
+        return ok ? size_t(n) : 0;
+    };
+    void polygon(Polygon* polygon) {
+        polygon->points.resize(this->count());
+        coord_t x = 0, y = 0;
+        for (Point &p : polygon->points) {
+            x += this->coord();
+            y += this->coord();
+            p.x = x;
+            p.y = y;
+        }
+    };
+};
+
+uint64_t
+SliceCache::key(const TriangleMesh &mesh, const std::vector<float> &z)
+{
+    uint64_t seed = GeometryHash::SEED;
+    GeometryHash::combine(seed, uint64_t(SLICE_CACHE_VERSION));
+    GeometryHash::combine(seed, uint64_t(mesh.stl.stats.number_of_facets));
+    for (int i = 0; i < mesh.stl.stats.number_of_facets; ++i) {
+        const stl_facet &facet = mesh.stl.facet_start[i];
+        for (int j = 0; j < 3; ++j) {
+            GeometryHash::combine(seed, double(facet.vertex[j].x));
+            GeometryHash::combine(seed, double(facet.vertex[j].y));
+            GeometryHash::combine(seed, double(facet.vertex[j].z));
+        }
+    }
+    GeometryHash::combine(seed, uint64_t(z.size()));
+    for (const float slice_z : z)
+        GeometryHash::combine(seed, double(slice_z));
+    return seed;
+}
+
+std::string
+SliceCache::_path(uint64_t key) const
+{
+    char name[32];
+    sprintf(name, "%016llx", (unsigned long long)key);
+    return this->_dir + "/" + name + SLICE_CACHE_EXTENSION;
+}
+
+bool
+SliceCache::load(uint64_t key, std::vector<ExPolygons>* layers) const
+{
+    const std::string path = this->_path(key);
+    boost::system::error_code ec;
+    const uintmax_t size = boost::filesystem::file_size(_native(path), ec);
+    if (ec || size < sizeof(SliceCacheHeader)) return false;
+
+    std::vector<ExPolygons> result;
+    try {
+        boost::interprocess::file_mapping file(_native(path).c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+        const unsigned char* data = static_cast<const unsigned char*>(region.get_address());
+
+        SliceCacheHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, SLICE_CACHE_MAGIC, sizeof(header.magic)) != 0
+            || header.version != SLICE_CACHE_VERSION
+            || header.key != key
+            || header.layers > region.get_size())
+            return false;
+
+        SliceCacheReader reader = { data + sizeof(header), data + region.get_size(), true };
+        result.resize(header.layers);
+        for (ExPolygons &expolygons : result) {
+            expolygons.resize(reader.count());
+            for (ExPolygon &expolygon : expolygons) {
+                expolygon.holes.resize(reader.count());
+                reader.polygon(&expolygon.contour);
+                for (Polygon &hole : expolygon.holes)
+                    reader.polygon(&hole);
+            }
+            if (!reader.ok) return false;
+        }
+        if (reader.ptr != reader.end) return false;
+    } catch (const boost::interprocess::interprocess_exception &) {
+        return false;
+    }
+
+    // mark the entry as recently used
+    boost::filesystem::last_write_time(_native(path), std::time(NULL), ec);
+
+    *layers = std::move(result);
+    return true;
+}
+
+void
+SliceCache::store(uint64_t key, const std::vector<ExPolygons> &layers)
+{
+    SliceCacheHeader header;
+    memcpy(header.magic, SLICE_CACHE_MAGIC, sizeof(header.magic));
+    header.version  = SLICE_CACHE_VERSION;
+    header.key      = key;
+    header.layers   = layers.size();
+
+    std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const ExPolygons &expolygons : layers) {
+        _write_varint(&data, expolygons.size());
+        for (const ExPolygon &expolygon : expolygons) {
+            _write_varint(&data, expolygon.holes.size());
+            _write_polygon(&data, expolygon.contour);
+            for (const Polygon &hole : expolygon.holes)
+                _write_polygon(&data, hole);
+        }
+    }
+    if (data.size() > this->_max_size) return;
+
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(_native(this->_dir), ec);
+
+    // write to a temporary file and rename it, so that concurrent readers
+    // never see a partial entry
+    const std::string path = this->_path(key);
+    const std::string tmp_path = path + "." + boost::filesystem::unique_path().string();
+    {
+        boost::nowide::ofstream file(tmp_path.c_str(), std::ios::out | std::ios::binary);
+        if (!file.good()) return;
+        file.write(data.data(), data.size());
+        if (!file.good()) {
+            file.close();
+            boost::filesystem::remove(_native(tmp_path), ec);
+            return;
+        }
+    }
+    boost::filesystem::rename(_native(tmp_path), _native(path), ec);
+    if (ec) {
+        boost::filesystem::remove(_native(tmp_path), ec);
+        return;
+    }
+
+    this->_evict();
+}
+
+void
+SliceCache::_evict() const
+{
+    struct Entry {
+        boost::filesystem::path path;
+        std::time_t time;
+        uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it(_native(this->_dir), ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != SLICE_CACHE_EXTENSION) continue;
+        Entry entry;
+        entry.path = it->path();
+        entry.time = boost::filesystem::last_write_time(entry.path, ec);
+        entry.size = boost::filesystem::file_size(entry.path, ec);
+        if (ec) {
+            // another process might have evicted it in the meantime
+            ec.clear();
+            continue;
+        }
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= this->_max_size) return;
+
+    // remove the least recently used entries first
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry &a, const Entry &b) { return a.time < b.time; });
+    for (const Entry &entry : entries) {
+        if (total <= this->_max_size) break;
+        boost::filesystem::remove(entry.path, ec);
+        total -= entry.size;
+    }
+}
+
+}
@@ -0,0 +1,43 @@
+#ifndef slic3r_SliceCache_hpp_
+#define slic3r_SliceCache_hpp_
+
+#include "libslic3r.h"
+#include "ExPolygon.hpp"
+#include "TriangleMesh.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+/// Persistent on-disk cache of TriangleMeshSlicer results.
+/// Each entry holds the slices of one region of one object, keyed by a hash
+/// of the transformed mesh and of the slice_z list: these are the only inputs
+/// of the slicer, so any config option affecting the slices (layer heights,
+/// scaling, rotation, ...) is accounted for. Entries are stored in a compact
+/// delta-encoded binary format and memory-mapped when loaded; the directory
+/// is kept under its size budget by evicting the least recently used entries.
+/// Several processes can safely share the same directory.
+class SliceCache
+{
+    public:
+    /// max_size is the size budget of the cache directory, in bytes.
+    SliceCache(const std::string &dir, size_t max_size)
+        : _dir(dir), _max_size(max_size) {};
+
+    static uint64_t key(const TriangleMesh &mesh, const std::vector<float> &z);
+    /// Returns false on a cache miss or if the entry can't be read.
+    bool load(uint64_t key, std::vector<ExPolygons>* layers) const;
+    void store(uint64_t key, const std::vector<ExPolygons> &layers);
+
+    private:
+    std::string _dir;
+    size_t _max_size;   ///< bytes
+
+    std::string _path(uint64_t key) const;
+    void _evict() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <boost/bind.hpp>
+
+namespace Slic3r {
+
+ThreadPool&
+ThreadPool::instance()
+{
+    // never deleted: joining threads while the process exits (or while a
+    // DLL is unloaded on Windows) could hang
+    static ThreadPool* pool = new ThreadPool();
+    return *pool;
+}
+
+size_t
+ThreadPool::size() const
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    return this->_size;
+}
+
+void
+ThreadPool::_grow(size_t size)
+{
+    boost::lock_guard<boost::mutex> l(this->_mutex);
+    for (; this->_size < size; ++this->_size)
+        boost::thread(boost::bind(&ThreadPool::_worker, this)).detach();
+}
+
+void
+ThreadPool::run(size_t count, const boost::function<void(size_t)> &func,
+    int threads_count, size_t max_chunk)
+{
+    if (count == 0) return;
+    if (threads_count <= 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) func(i);
+        return;
+    }
+
+    Loop loop;
+    loop.count          = count;
+    loop.func           = &func;
+    loop.max_chunk      = std::max<size_t>(max_chunk, 1);
+    loop.threads        = int(std::min<size_t>(threads_count, count));
+    loop.participants   = 1;
+    loop.running        = 1;
+    this->_grow(loop.threads - 1);
+    {
+        boost::lock_guard<boost::mutex> l(this->_mutex);
+        this->_loops.push_back(&loop);
+    }
+    this->_work.notify_all();
+
+    this->_participate(loop);
+
+    {
+        boost::unique_lock<boost::mutex> l(this->_mutex);
+        // no worker can join once the loop is out of the list
+        std::vector<Loop*>::iterator it = std::find(this->_loops.begin(), this->_loops.end(), &loop);
+        if (it != this->_loops.end()) this->_loops.erase(it);
+        --loop.running;
+        while (loop.running > 0)
+            loop.finished.wait(l);
+    }
+    if (loop.error)
+        std::rethrow_exception(loop.error);
+}
+
+ThreadPool::Loop*
+ThreadPool::_pick()
+{
+    // the most recent loops first, so that nested loops complete early
+    for (size_t i = this->_loops.size(); i > 0; --i) {
+        Loop* loop = this->_loops[i-1];
+        if (loop->next.load() >= loop->count || loop->failed.load()) {
+            this->_loops.erase(this->_loops.begin() + (i-1));
+            continue;
+        }
+        if (++loop->participants >= loop->threads)
+            this->_loops.erase(this->_loops.begin() + (i-1));
+        ++loop->running;
+        return loop;
+    }
+    return NULL;
+}
+
+void
+ThreadPool::_worker()
+{
+    while (true) {
+        Loop* loop;
+        {
+            boost::unique_lock<boost::mutex> l(this->_mutex);
+            while ((loop = this->_pick()) == NULL)
+                this->_work.wait(l);
+        }
+        this->_participate(*loop);
+        {
+            boost::lock_guard<boost::mutex> l(this->_mutex);
+            if (--loop->running == 0)
+                loop->finished.notify_all();
+        }
+    }
+}
+
+void
+ThreadPool::_participate(Loop &loop)
+{
+    const size_t divisor = 2 * size_t(loop.threads);
+    while (!loop.failed.load()) {
+        const size_t next = loop.next.load();
+        if (next >= loop.count) break;
+        const size_t chunk = std::min(loop.max_chunk, std::max<size_t>((loop.count - next) / divisor, 1));
+        const size_t begin = loop.next.fetch_add(chunk);
+        if (begin >= loop.count) break;
+        const size_t end = std::min(begin + chunk, loop.count);
+        try {
+            for (size_t i = begin; i < end && !loop.failed.load(std::memory_order_relaxed); ++i)
+                (*loop.func)(i);
+        } catch (...) {
+            boost::lock_guard<boost::mutex> l(this->_mutex);
+            if (!loop.error) loop.error = std::current_exception();
+            loop.failed = true;
+        }
+    }
+}
+
+}
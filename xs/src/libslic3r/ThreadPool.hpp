@@ -0,0 +1,77 @@
+#ifndef slic3r_ThreadPool_hpp_
+#define slic3r_ThreadPool_hpp_
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace Slic3r {
+
+/*
+Worker threads running the loops of parallelize(), started once and kept
+for the lifetime of the process.
+
+A loop over the indices [0, count) is run by the thread calling run(),
+joined by idle workers. Each participant claims chunks of consecutive
+indices from a shared atomic counter: the chunks hold the remaining
+indices divided by twice the number of participants, so that short items
+cost one atomic operation per chunk while the last chunks stay small
+enough to balance the load. max_chunk bounds them, down to one index at a
+time for items that must start in order (e.g. sorted by decreasing cost).
+
+Loops may be nested: an item can start a loop of its own, which idle
+workers join before older loops. Since the calling thread of a loop can
+always run all of its items alone, a loop never waits for a busy thread.
+*/
+class ThreadPool {
+    public:
+    /// The pool shared by all loops. Its workers are started as loops ask for
+    /// them, and never stopped.
+    static ThreadPool& instance();
+
+    /// Runs func(i) for each i in [0, count) on up to threads_count threads,
+    /// including the calling one, and returns when all are done.
+    /// If func throws, the remaining items are skipped and the first
+    /// exception is rethrown once the running items are finished.
+    void run(size_t count, const boost::function<void(size_t)> &func,
+        int threads_count, size_t max_chunk = size_t(-1));
+
+    /// Number of worker threads started so far.
+    size_t size() const;
+
+    private:
+    struct Loop {
+        size_t count;
+        const boost::function<void(size_t)>* func;
+        size_t max_chunk;
+        int threads;                ///< participants allowed
+        std::atomic<size_t> next;   ///< first index not claimed yet
+        std::atomic<bool> failed;
+        // the following are guarded by ThreadPool::_mutex
+        int participants;           ///< threads that joined the loop so far
+        int running;                ///< threads still running items
+        std::exception_ptr error;
+        boost::condition_variable finished;
+
+        Loop() : count(0), func(NULL), max_chunk(1), threads(1), next(0), failed(false),
+            participants(0), running(0) {};
+    };
+
+    mutable boost::mutex _mutex;
+    boost::condition_variable _work;    ///< signaled when a loop is added
+    std::vector<Loop*> _loops;          ///< loops open to workers, most recent last
+    size_t _size;
+
+    ThreadPool() : _size(0) {};
+    void _grow(size_t size);
+    void _worker();
+    Loop* _pick();
+    void _participate(Loop &loop);
+};
+
+}
+
+#endif
@@ -15,6 +15,7 @@
 #undef free
 #endif
 #include <boost/thread.hpp>
+#include "ThreadPool.hpp"
 
 /* Implementation of CONFESS("foo"): */
 #ifdef _MSC_VER
@@ -80,43 +81,39 @@ inline void append_to(std::vector<T> &dst, const std::vector<T> &src)
     dst.insert(dst.end(), src.begin(), src.end());
 }
 
-template <class T> void
-_parallelize_do(std::queue<T>* queue, boost::mutex* queue_mutex, boost::function<void(T)> func)
-{
-    //std::cout << "THREAD STARTED: " << boost::this_thread::get_id() << std::endl;
-    while (true) {
-        T i;
-        {
-            boost::lock_guard<boost::mutex> l(*queue_mutex);
-            if (queue->empty()) return;
-            i = queue->front();
-            queue->pop();
-        }
-        //std::cout << "  Thread " << boost::this_thread::get_id() << " processing item " << i << std::endl;
-        func(i);
-        boost::this_thread::interruption_point();
-    }
-}
-
+/// Runs func on each item of the queue in parallel, on up to threads_count
+/// threads including the calling one. Items are started in queue order.
 template <class T> void
 parallelize(std::queue<T> queue, boost::function<void(T)> func,
     int threads_count = boost::thread::hardware_concurrency())
 {
     if (threads_count == 0) threads_count = 2;
-    boost::mutex queue_mutex;
-    boost::thread_group workers;
-    for (int i = 0; i < std::min(threads_count, (int)queue.size()); i++)
-        workers.add_thread(new boost::thread(&_parallelize_do<T>, &queue, &queue_mutex, func));
-    workers.join_all();
+    std::vector<T> items;
+    items.reserve(queue.size());
+    for (; !queue.empty(); queue.pop())
+        items.push_back(queue.front());
+    ThreadPool::instance().run(
+        items.size(),
+        [&items, &func](size_t i) { func(items[i]); },
+        threads_count,
+        1
+    );
 }
 
+/// Runs func on each value of [start, end] in parallel, on up to
+/// threads_count threads including the calling one. Consecutive values are
+/// run in chunks, so that the items can be short.
 template <class T> void
 parallelize(T start, T end, boost::function<void(T)> func,
     int threads_count = boost::thread::hardware_concurrency())
 {
-    std::queue<T> queue;
-    for (T i = start; i <= end; ++i) queue.push(i);
-    parallelize(queue, func, threads_count);
+    if (threads_count == 0) threads_count = 2;
+    if (end < start) return;
+    ThreadPool::instance().run(
+        size_t(end - start) + 1,
+        [start, &func](size_t i) { func(T(start + i)); },
+        threads_count
+    );
 }
 
 } // namespace Slic3r
@@ -14,6 +14,7 @@ REGISTER_CLASS(Flow, "Flow");
 REGISTER_CLASS(Filler, "Filler");
 REGISTER_CLASS(AvoidCrossingPerimeters, "GCode::AvoidCrossingPerimeters");
 REGISTER_CLASS(CoolingBuffer, "GCode::CoolingBuffer");
+REGISTER_CLASS(LayerBodies, "GCode::LayerBodies");
 REGISTER_CLASS(OozePrevention, "GCode::OozePrevention");
 REGISTER_CLASS(SpiralVase, "GCode::SpiralVase");
 REGISTER_CLASS(Wipe, "GCode::Wipe");
@@ -47,6 +48,7 @@ REGISTER_CLASS(BoundingBox, "Geometry::BoundingBox");
 REGISTER_CLASS(BoundingBoxf, "Geometry::BoundingBoxf");
 REGISTER_CLASS(BoundingBoxf3, "Geometry::BoundingBoxf3");
 REGISTER_CLASS(BridgeDetector, "BridgeDetector");
+REGISTER_CLASS(BridgeAngleCache, "BridgeAngleCache");
 REGISTER_CLASS(Point, "Point");
 REGISTER_CLASS(Point3, "Point3");
 REGISTER_CLASS(Pointf, "Pointf");
@@ -64,6 +66,7 @@ REGISTER_CLASS(Surface, "Surface");
 REGISTER_CLASS(SurfaceCollection, "Surface::Collection");
 REGISTER_CLASS(TriangleMesh, "TriangleMesh");
 REGISTER_CLASS(GLVertexArray, "GUI::_3DScene::GLVertexArray");
+REGISTER_CLASS(ToolpathsPreview, "GUI::_3DScene::ToolpathsPreview");
 
 SV*
 ConfigBase__as_hash(ConfigBase* THIS) {
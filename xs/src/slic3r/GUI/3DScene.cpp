@@ -1,4 +1,7 @@
 #include "3DScene.hpp"
+#include <algorithm>
+#include <cstring>
+#include <boost/bind.hpp>
 
 namespace Slic3r {
 
@@ -10,13 +13,12 @@ _3DScene::_extrusionentity_to_verts_do(const Lines &lines, const std::vector<dou
 {
     if (lines.empty()) return;
     
-    /* It looks like it's faster without reserving capacity...
     // each segment has 4 quads, thus 16 vertices; + 2 caps
     qverts->reserve_more(3 * 4 * (4 * lines.size() + 2));
     
     // two triangles for each corner
-    tverts->reserve_more(3 * 3 * 2 * (lines.size() + 1));
-    */
+    if (tverts != NULL)
+        tverts->reserve_more(3 * 3 * 2 * (lines.size() + 1));
     
     Line prev_line;
     Pointf prev_b1, prev_b2;
@@ -78,66 +80,54 @@ _3DScene::_extrusionentity_to_verts_do(const Lines &lines, const std::vector<dou
         Vectorf3 xy_left_normal = xy_right_normal;
         xy_left_normal.scale(-1);
         
-        if (first_done) {
+        if (first_done && tverts != NULL) {
             // if we're making a ccw turn, draw the triangles on the right side, otherwise draw them on the left side
             double ccw = line.b.ccw(prev_line);
             if (ccw > EPSILON) {
                 // top-right vertex triangle between previous line and this one
                 {
                     // use the normal going to the right calculated for the previous line
-                    tverts->push_norm(prev_xy_right_normal);
-                    tverts->push_vert(prev_b1.x, prev_b1.y, middle_z_a);
+                    tverts->push(prev_xy_right_normal, prev_b1.x, prev_b1.y, middle_z_a);
             
                     // use the normal going to the right calculated for this line
-                    tverts->push_norm(xy_right_normal);
-                    tverts->push_vert(a1.x, a1.y, middle_z_a);
+                    tverts->push(xy_right_normal, a1.x, a1.y, middle_z_a);
             
                     // normal going upwards
-                    tverts->push_norm(0,0,1);
-                    tverts->push_vert(a.x, a.y, top_z_a);
+                    tverts->push(0,0,1, a.x, a.y, top_z_a);
                 }
                 // bottom-right vertex triangle between previous line and this one
                 {
                     // use the normal going to the right calculated for the previous line
-                    tverts->push_norm(prev_xy_right_normal);
-                    tverts->push_vert(prev_b1.x, prev_b1.y, middle_z_a);
+                    tverts->push(prev_xy_right_normal, prev_b1.x, prev_b1.y, middle_z_a);
             
                     // normal going downwards
-                    tverts->push_norm(0,0,-1);
-                    tverts->push_vert(a.x, a.y, bottom_z_a);
+                    tverts->push(0,0,-1, a.x, a.y, bottom_z_a);
             
                     // use the normal going to the right calculated for this line
-                    tverts->push_norm(xy_right_normal);
-                    tverts->push_vert(a1.x, a1.y, middle_z_a);
+                    tverts->push(xy_right_normal, a1.x, a1.y, middle_z_a);
                 }
             } else if (ccw < -EPSILON) {
                 // top-left vertex triangle between previous line and this one
                 {
                     // use the normal going to the left calculated for the previous line
-                    tverts->push_norm(prev_xy_left_normal);
-                    tverts->push_vert(prev_b2.x, prev_b2.y, middle_z_a);
+                    tverts->push(prev_xy_left_normal, prev_b2.x, prev_b2.y, middle_z_a);
             
                     // normal going upwards
-                    tverts->push_norm(0,0,1);
-                    tverts->push_vert(a.x, a.y, top_z_a);
+                    tverts->push(0,0,1, a.x, a.y, top_z_a);
             
                     // use the normal going to the right calculated for this line
-                    tverts->push_norm(xy_left_normal);
-                    tverts->push_vert(a2.x, a2.y, middle_z_a);
+                    tverts->push(xy_left_normal, a2.x, a2.y, middle_z_a);
                 }
                 // bottom-left vertex triangle between previous line and this one
                 {
                     // use the normal going to the left calculated for the previous line
-                    tverts->push_norm(prev_xy_left_normal);
-                    tverts->push_vert(prev_b2.x, prev_b2.y, middle_z_a);
+                    tverts->push(prev_xy_left_normal, prev_b2.x, prev_b2.y, middle_z_a);
             
                     // use the normal going to the right calculated for this line
-                    tverts->push_norm(xy_left_normal);
-                    tverts->push_vert(a2.x, a2.y, middle_z_a);
+                    tverts->push(xy_left_normal, a2.x, a2.y, middle_z_a);
             
                     // normal going downwards
-                    tverts->push_norm(0,0,-1);
-                    tverts->push_vert(a.x, a.y, bottom_z_a);
+                    tverts->push(0,0,-1, a.x, a.y, bottom_z_a);
                 }
             }
         }
@@ -155,94 +145,70 @@ _3DScene::_extrusionentity_to_verts_do(const Lines &lines, const std::vector<dou
             // terminate open paths with caps
             if (i == 0) {
                 // normal pointing downwards
-                qverts->push_norm(0,0,-1);
-                qverts->push_vert(a.x, a.y, bottom_z_a);
+                qverts->push(0,0,-1, a.x, a.y, bottom_z_a);
             
                 // normal pointing to the right
-                qverts->push_norm(xy_right_normal);
-                qverts->push_vert(a1.x, a1.y, middle_z_a);
+                qverts->push(xy_right_normal, a1.x, a1.y, middle_z_a);
             
                 // normal pointing upwards
-                qverts->push_norm(0,0,1);
-                qverts->push_vert(a.x, a.y, top_z_a);
+                qverts->push(0,0,1, a.x, a.y, top_z_a);
             
                 // normal pointing to the left
-                qverts->push_norm(xy_left_normal);
-                qverts->push_vert(a2.x, a2.y, middle_z_a);
+                qverts->push(xy_left_normal, a2.x, a2.y, middle_z_a);
             }
             // we don't use 'else' because both cases are true if we have only one line
             if (i == lines.size()-1) {
                 // normal pointing downwards
-                qverts->push_norm(0,0,-1);
-                qverts->push_vert(b.x, b.y, bottom_z_b);
+                qverts->push(0,0,-1, b.x, b.y, bottom_z_b);
             
                 // normal pointing to the left
-                qverts->push_norm(xy_left_normal);
-                qverts->push_vert(b2.x, b2.y, middle_z_b);
+                qverts->push(xy_left_normal, b2.x, b2.y, middle_z_b);
             
                 // normal pointing upwards
-                qverts->push_norm(0,0,1);
-                qverts->push_vert(b.x, b.y, top_z_b);
+                qverts->push(0,0,1, b.x, b.y, top_z_b);
             
                 // normal pointing to the right
-                qverts->push_norm(xy_right_normal);
-                qverts->push_vert(b1.x, b1.y, middle_z_b);
+                qverts->push(xy_right_normal, b1.x, b1.y, middle_z_b);
             }
         }
         
         // bottom-right face
         {
             // normal going downwards
-            qverts->push_norm(0,0,-1);
-            qverts->push_norm(0,0,-1);
-            qverts->push_vert(a.x, a.y, bottom_z_a);
-            qverts->push_vert(b.x, b.y, bottom_z_b);
+            qverts->push(0,0,-1, a.x, a.y, bottom_z_a);
+            qverts->push(0,0,-1, b.x, b.y, bottom_z_b);
             
-            qverts->push_norm(xy_right_normal);
-            qverts->push_norm(xy_right_normal);
-            qverts->push_vert(b1.x, b1.y, middle_z_b);
-            qverts->push_vert(a1.x, a1.y, middle_z_a);
+            qverts->push(xy_right_normal, b1.x, b1.y, middle_z_b);
+            qverts->push(xy_right_normal, a1.x, a1.y, middle_z_a);
         }
         
         // top-right face
         {
-            qverts->push_norm(xy_right_normal);
-            qverts->push_norm(xy_right_normal);
-            qverts->push_vert(a1.x, a1.y, middle_z_a);
-            qverts->push_vert(b1.x, b1.y, middle_z_b);
+            qverts->push(xy_right_normal, a1.x, a1.y, middle_z_a);
+            qverts->push(xy_right_normal, b1.x, b1.y, middle_z_b);
             
             // normal going upwards
-            qverts->push_norm(0,0,1);
-            qverts->push_norm(0,0,1);
-            qverts->push_vert(b.x, b.y, top_z_b);
-            qverts->push_vert(a.x, a.y, top_z_a);
+            qverts->push(0,0,1, b.x, b.y, top_z_b);
+            qverts->push(0,0,1, a.x, a.y, top_z_a);
         }
          
         // top-left face
         {
-            qverts->push_norm(0,0,1);
-            qverts->push_norm(0,0,1);
-            qverts->push_vert(a.x, a.y, top_z_a);
-            qverts->push_vert(b.x, b.y, top_z_b);
+            qverts->push(0,0,1, a.x, a.y, top_z_a);
+            qverts->push(0,0,1, b.x, b.y, top_z_b);
             
-            qverts->push_norm(xy_left_normal);
-            qverts->push_norm(xy_left_normal);
-            qverts->push_vert(b2.x, b2.y, middle_z_b);
-            qverts->push_vert(a2.x, a2.y, middle_z_a);
+            qverts->push(xy_left_normal, b2.x, b2.y, middle_z_b);
+            qverts->push(xy_left_normal, a2.x, a2.y, middle_z_a);
         }
         
         // bottom-left face
         {
-            qverts->push_norm(xy_left_normal);
-            qverts->push_norm(xy_left_normal);
-            qverts->push_vert(a2.x, a2.y, middle_z_a);
-            qverts->push_vert(b2.x, b2.y, middle_z_b);
+            qverts->push(xy_left_normal, a2.x, a2.y, middle_z_a);
+            qverts->push(xy_left_normal, b2.x, b2.y, middle_z_b);
             
             // normal going downwards
-            qverts->push_norm(0,0,-1);
-            qverts->push_norm(0,0,-1);
-            qverts->push_vert(b.x, b.y, bottom_z_b);
-            qverts->push_vert(a.x, a.y, bottom_z_a);
+            qverts->push(0,0,-1, b.x, b.y, bottom_z_b);
+            qverts->push(0,0,-1, a.x, a.y, bottom_z_a);
         }
         
         first_done = true;
@@ -257,10 +223,373 @@ GLVertexArray::load_mesh(const TriangleMesh &mesh)
     for (int i = 0; i < mesh.stl.stats.number_of_facets; ++i) {
         stl_facet &facet = mesh.stl.facet_start[i];
         for (int j = 0; j <= 2; ++j) {
-            this->push_norm(facet.normal.x, facet.normal.y, facet.normal.z);
-            this->push_vert(facet.vertex[j].x, facet.vertex[j].y, facet.vertex[j].z);
+            this->push(facet.normal.x, facet.normal.y, facet.normal.z,
+                facet.vertex[j].x, facet.vertex[j].y, facet.vertex[j].z);
         }
     }
 }
 
+const double ToolpathsPreview::lod_tolerance = 0.25;
+
+static inline void
+_hash(uint64_t* h, uint64_t value)
+{
+    *h ^= value + 0x9e3779b97f4a7c15ULL + (*h << 6) + (*h >> 2);
+}
+
+static inline void
+_hash(uint64_t* h, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    _hash(h, bits);
+}
+
+static void
+_hash(uint64_t* h, const ExtrusionEntity &entity)
+{
+    if (const ExtrusionEntityCollection* collection = dynamic_cast<const ExtrusionEntityCollection*>(&entity)) {
+        _hash(h, uint64_t(collection->entities.size()));
+        for (const ExtrusionEntity* e : collection->entities)
+            _hash(h, *e);
+    } else if (const ExtrusionPath* path = dynamic_cast<const ExtrusionPath*>(&entity)) {
+        _hash(h, uint64_t(path->role));
+        _hash(h, double(path->width));
+        _hash(h, double(path->height));
+        for (const Point &p : path->polyline.points) {
+            _hash(h, uint64_t(p.x));
+            _hash(h, uint64_t(p.y));
+            _hash(h, uint64_t(p.z));
+        }
+    } else if (const ExtrusionLoop* loop = dynamic_cast<const ExtrusionLoop*>(&entity)) {
+        _hash(h, uint64_t(loop->paths.size()));
+        for (const ExtrusionPath &path : loop->paths)
+            _hash(h, path);
+    }
+}
+
+// Computes the fingerprint of the toolpaths of a layer, i.e. of everything
+// its preview geometry depends on.
+void
+ToolpathsPreview::_fingerprint(size_t idx)
+{
+    LayerGeometry &geometry = this->_new_layers[idx];
+    const Layer &layer = *geometry.layer;
+
+    uint64_t h = 0;
+    _hash(&h, layer.print_z);
+    _hash(&h, uint64_t(geometry.support));
+    _hash(&h, uint64_t(this->_color_by_extruder));
+    _hash(&h, uint64_t(this->_colors_count));
+    for (const Point &copy : this->_object->_shifted_copies) {
+        _hash(&h, uint64_t(copy.x));
+        _hash(&h, uint64_t(copy.y));
+    }
+
+    const bool perimeters = this->_object->state.is_done(posPerimeters);
+    const bool infill = this->_object->state.is_done(posInfill);
+    _hash(&h, uint64_t(perimeters));
+    _hash(&h, uint64_t(infill));
+    for (const LayerRegion* layerm : layer.regions) {
+        const PrintRegionConfig &config = layerm->region()->config;
+        if (perimeters) {
+            _hash(&h, uint64_t(config.perimeter_extruder.value));
+            _hash(&h, layerm->perimeters);
+        }
+        if (infill) {
+            _hash(&h, uint64_t(config.infill_extruder.value));
+            _hash(&h, uint64_t(config.solid_infill_extruder.value));
+            _hash(&h, layerm->fills);
+        }
+    }
+
+    if (geometry.support && this->_object->state.is_done(posSupportMaterial)) {
+        const SupportLayer &support_layer = static_cast<const SupportLayer&>(layer);
+        _hash(&h, uint64_t(this->_object->config.support_material_extruder.value));
+        _hash(&h, uint64_t(this->_object->config.support_material_interface_extruder.value));
+        _hash(&h, support_layer.support_fills);
+        _hash(&h, support_layer.support_interface_fills);
+    }
+    geometry.fingerprint = h;
+}
+
+// Adds the extrusions of entity to the buffers of a layer, in each level
+// of detail.
+void
+ToolpathsPreview::_add(LayerGeometry &geometry, const ExtrusionEntity &entity, unsigned int color,
+    double top_z, const Point &copy) const
+{
+    std::vector<const ExtrusionPath*> paths;
+    bool closed;
+    if (const ExtrusionEntityCollection* collection = dynamic_cast<const ExtrusionEntityCollection*>(&entity)) {
+        for (const ExtrusionEntity* e : collection->entities)
+            this->_add(geometry, *e, color, top_z, copy);
+        return;
+    } else if (const ExtrusionPath* path = dynamic_cast<const ExtrusionPath*>(&entity)) {
+        paths.push_back(path);
+        closed = false;
+    } else if (const ExtrusionLoop* loop = dynamic_cast<const ExtrusionLoop*>(&entity)) {
+        for (const ExtrusionPath &path : loop->paths)
+            paths.push_back(&path);
+        closed = true;
+    } else {
+        return;
+    }
+
+    for (int lod = 0; lod < LODS; ++lod) {
+        Lines lines;
+        std::vector<double> widths, heights;
+        for (const ExtrusionPath* path : paths) {
+            Polyline polyline = path->polyline;
+            if (lod > 0)
+                polyline.simplify(scale_(lod_tolerance));
+            polyline.remove_duplicate_points();
+            polyline.translate(copy);
+            for (const Line &line : polyline.lines()) {
+                // points differing only in Z would give no direction
+                if (line.a.x == line.b.x && line.a.y == line.b.y) continue;
+                lines.push_back(line);
+                widths.push_back(path->width);
+                heights.push_back(path->height);
+            }
+        }
+        _3DScene::_extrusionentity_to_verts_do(lines, widths, heights, closed, top_z, copy,
+            &geometry.qverts[lod][color], (lod == 0) ? &geometry.tverts[lod][color] : NULL);
+    }
+}
+
+// Tells whether a fill, i.e. a collection of paths or loops, is solid
+// infill according to its first extrusion.
+static bool
+_is_solid_infill(const ExtrusionEntity &fill)
+{
+    const ExtrusionEntity* entity = &fill;
+    if (const ExtrusionEntityCollection* collection = dynamic_cast<const ExtrusionEntityCollection*>(entity)) {
+        if (collection->entities.empty()) return false;
+        entity = collection->entities.front();
+    }
+    if (const ExtrusionPath* path = dynamic_cast<const ExtrusionPath*>(entity))
+        return path->is_solid_infill();
+    if (const ExtrusionLoop* loop = dynamic_cast<const ExtrusionLoop*>(entity))
+        return loop->is_solid_infill();
+    return false;
+}
+
+// Converts the toolpaths of a layer, in the order the preview always
+// loaded them in.
+void
+ToolpathsPreview::_convert(size_t idx)
+{
+    LayerGeometry &geometry = this->_new_layers[idx];
+    if (geometry.cached) return;
+    const Layer &layer = *geometry.layer;
+    const PrintObject &object = *this->_object;
+    const double top_z = layer.print_z;
+    const unsigned int colors_count = std::max(this->_colors_count, 1u);
+
+    for (const Point &copy : object._shifted_copies) {
+        for (const LayerRegion* layerm : layer.regions) {
+            const PrintRegionConfig &config = layerm->region()->config;
+            if (object.state.is_done(posPerimeters)) {
+                const unsigned int color = this->_color_by_extruder
+                    ? (config.perimeter_extruder.value - 1) % colors_count
+                    : 0;
+                this->_add(geometry, layerm->perimeters, color, top_z, copy);
+            }
+
+            if (object.state.is_done(posInfill)) {
+                const unsigned int color = this->_color_by_extruder
+                    ? (config.infill_extruder.value - 1) % colors_count
+                    : 1 % colors_count;
+                if (this->_color_by_extruder && config.infill_extruder.value != config.solid_infill_extruder.value) {
+                    // divide solid and non-solid infill
+                    const unsigned int solid_color = (config.solid_infill_extruder.value - 1) % colors_count;
+                    for (const ExtrusionEntity* fill : layerm->fills.entities)
+                        this->_add(geometry, *fill, _is_solid_infill(*fill) ? solid_color : color, top_z, copy);
+                } else {
+                    this->_add(geometry, layerm->fills, color, top_z, copy);
+                }
+            }
+        }
+
+        if (geometry.support && object.state.is_done(posSupportMaterial)) {
+            const SupportLayer &support_layer = static_cast<const SupportLayer&>(layer);
+            unsigned int color = this->_color_by_extruder
+                ? (object.config.support_material_extruder.value - 1) % colors_count
+                : 2 % colors_count;
+            this->_add(geometry, support_layer.support_fills, color, top_z, copy);
+            color = this->_color_by_extruder
+                ? (object.config.support_material_interface_extruder.value - 1) % colors_count
+                : 2 % colors_count;
+            this->_add(geometry, support_layer.support_interface_fills, color, top_z, copy);
+        }
+    }
+}
+
+// Copies the coordinates of a layer into the new vertex arrays, either
+// from the previous ones or from its buffers.
+void
+ToolpathsPreview::_copy(size_t idx)
+{
+    LayerGeometry &geometry = this->_new_layers[idx];
+    std::map<unsigned int,const Group*> previous_groups;
+    if (geometry.cached)
+        for (const Group &group : this->groups)
+            previous_groups[group.color] = &group;
+    const LayerGeometry* previous = geometry.cached ? &this->_layers[geometry.previous] : NULL;
+
+    for (Group &group : this->_new_groups) {
+        for (int lod = 0; lod < LODS; ++lod) {
+            std::map<unsigned int,Span>::const_iterator span = geometry.spans[lod].find(group.color);
+            if (span == geometry.spans[lod].end()) continue;
+            const float *q, *t;
+            if (previous != NULL) {
+                const Span &from = previous->spans[lod].at(group.color);
+                const Group &from_group = *previous_groups.at(group.color);
+                q = from_group.qverts[lod].data.data() + from.q * 2;
+                t = from_group.tverts[lod].data.data() + from.t * 2;
+            } else {
+                q = geometry.qverts[lod][group.color].data.data();
+                t = geometry.tverts[lod][group.color].data.data();
+            }
+            if (span->second.q_size > 0)
+                memcpy(group.qverts[lod].data.data() + span->second.q * 2, q, span->second.q_size * 2 * sizeof(float));
+            if (span->second.t_size > 0)
+                memcpy(group.tverts[lod].data.data() + span->second.t * 2, t, span->second.t_size * 2 * sizeof(float));
+        }
+    }
+
+    for (int lod = 0; lod < LODS; ++lod) {
+        geometry.qverts[lod].clear();
+        geometry.tverts[lod].clear();
+    }
+}
+
+void
+ToolpathsPreview::load_object(PrintObject &object, bool color_by_extruder, unsigned int colors_count)
+{
+    this->_object               = &object;
+    this->_color_by_extruder    = color_by_extruder;
+    this->_colors_count         = colors_count;
+    const int threads           = object.print()->config.threads.value;
+
+    // layers and support layers, ordered by print_z
+    this->_new_layers.clear();
+    for (const Layer* layer : object.layers) {
+        this->_new_layers.push_back(LayerGeometry());
+        this->_new_layers.back().layer = layer;
+    }
+    for (const SupportLayer* layer : object.support_layers) {
+        this->_new_layers.push_back(LayerGeometry());
+        this->_new_layers.back().layer = layer;
+        this->_new_layers.back().support = true;
+    }
+    std::stable_sort(this->_new_layers.begin(), this->_new_layers.end(),
+        [](const LayerGeometry &a, const LayerGeometry &b) { return a.layer->print_z < b.layer->print_z; });
+
+    // find the layers whose geometry we already have
+    if (!this->_new_layers.empty())
+        parallelize<size_t>(0, this->_new_layers.size()-1,
+            boost::bind(&ToolpathsPreview::_fingerprint, this, _1), threads);
+    // a geometry is only reused for the same layer, so that a fingerprint
+    // collision can't show the toolpaths of another layer; the previous
+    // layers might have been deleted since, their addresses are only compared
+    std::map<std::pair<const Layer*,uint64_t>,size_t> previous;
+    for (size_t i = 0; i < this->_layers.size(); ++i)
+        previous[std::make_pair(this->_layers[i].layer, this->_layers[i].fingerprint)] = i;
+    bool unchanged = (this->_new_layers.size() == this->_layers.size());
+    this->layers_converted = 0;
+    for (size_t i = 0; i < this->_new_layers.size(); ++i) {
+        LayerGeometry &geometry = this->_new_layers[i];
+        std::map<std::pair<const Layer*,uint64_t>,size_t>::const_iterator it =
+            previous.find(std::make_pair(geometry.layer, geometry.fingerprint));
+        geometry.cached = (it != previous.end());
+        if (geometry.cached) {
+            geometry.previous = it->second;
+        } else {
+            ++this->layers_converted;
+        }
+        if (!geometry.cached || geometry.previous != i)
+            unchanged = false;
+    }
+    if (unchanged) {
+        this->_new_layers.clear();
+        return;
+    }
+
+    if (!this->_new_layers.empty())
+        parallelize<size_t>(0, this->_new_layers.size()-1,
+            boost::bind(&ToolpathsPreview::_convert, this, _1), threads);
+
+    // lay the layers out in new vertex arrays allocated at their final size
+    std::map<unsigned int,size_t> groups_by_color;
+    for (const LayerGeometry &geometry : this->_new_layers) {
+        for (int lod = 0; lod < LODS; ++lod) {
+            if (geometry.cached) {
+                for (const auto &span : this->_layers[geometry.previous].spans[lod])
+                    groups_by_color[span.first] = 0;
+            } else {
+                for (const auto &q : geometry.qverts[lod])
+                    groups_by_color[q.first] = 0;
+            }
+        }
+    }
+    this->_new_groups.clear();
+    for (auto &it : groups_by_color) {
+        it.second = this->_new_groups.size();
+        this->_new_groups.push_back(Group());
+        this->_new_groups.back().color = it.first;
+    }
+    this->zs.clear();
+    std::vector<Span> totals(this->_new_groups.size() * LODS);
+    for (LayerGeometry &geometry : this->_new_layers) {
+        this->zs.push_back(geometry.layer->print_z);
+        for (size_t g = 0; g < this->_new_groups.size(); ++g) {
+            Group &group = this->_new_groups[g];
+            for (int lod = 0; lod < LODS; ++lod) {
+                Span &total = totals[g * LODS + lod];
+                Span span;
+                span.q = total.q_size;
+                span.t = total.t_size;
+                if (geometry.cached) {
+                    std::map<unsigned int,Span>::const_iterator from =
+                        this->_layers[geometry.previous].spans[lod].find(group.color);
+                    if (from != this->_layers[geometry.previous].spans[lod].end()) {
+                        span.q_size = from->second.q_size;
+                        span.t_size = from->second.t_size;
+                    }
+                } else {
+                    std::map<unsigned int,GLVertexArray>::const_iterator q = geometry.qverts[lod].find(group.color);
+                    std::map<unsigned int,GLVertexArray>::const_iterator t = geometry.tverts[lod].find(group.color);
+                    if (q != geometry.qverts[lod].end()) span.q_size = q->second.size();
+                    if (t != geometry.tverts[lod].end()) span.t_size = t->second.size();
+                }
+                group.qoffsets[lod].push_back(span.q);
+                group.toffsets[lod].push_back(span.t);
+                if (span.q_size > 0 || span.t_size > 0)
+                    geometry.spans[lod][group.color] = span;
+                total.q_size += span.q_size;
+                total.t_size += span.t_size;
+            }
+        }
+    }
+    for (size_t g = 0; g < this->_new_groups.size(); ++g) {
+        for (int lod = 0; lod < LODS; ++lod) {
+            this->_new_groups[g].qverts[lod].data.resize(totals[g * LODS + lod].q_size * 2);
+            this->_new_groups[g].tverts[lod].data.resize(totals[g * LODS + lod].t_size * 2);
+        }
+    }
+
+    if (!this->_new_layers.empty())
+        parallelize<size_t>(0, this->_new_layers.size()-1,
+            boost::bind(&ToolpathsPreview::_copy, this, _1), threads);
+
+    this->groups.swap(this->_new_groups);
+    this->_layers.swap(this->_new_layers);
+    this->_new_groups.clear();
+    this->_new_layers.clear();
+    for (LayerGeometry &geometry : this->_layers)
+        geometry.cached = true;
+}
+
 }
@@ -5,47 +5,119 @@
 #include "../../libslic3r/Point.hpp"
 #include "../../libslic3r/Line.hpp"
 #include "../../libslic3r/TriangleMesh.hpp"
+#include "../../libslic3r/Print.hpp"
+#include <map>
+#include <vector>
 
 namespace Slic3r {
 
+/// Vertex array with the normal of each vertex stored before its coordinates,
+/// as in the GL_N3F_V3F interleaved format.
 class GLVertexArray {
     public:
-    std::vector<float> verts, norms;
-    
+    std::vector<float> data;
+
+    /// Distance in bytes between two vertices.
+    static const size_t stride = 6 * sizeof(float);
+
+    /// Number of coordinates, i.e. three per vertex.
+    size_t size() const { return this->data.size() / 2; };
     void reserve(size_t len) {
-        this->verts.reserve(len);
-        this->norms.reserve(len);
+        this->data.reserve(len * 2);
     };
+    /// Makes room for len more coordinates. The capacity grows geometrically,
+    /// so that reserving before each extrusion doesn't reallocate each time.
     void reserve_more(size_t len) {
-        len += this->verts.size();
-        this->reserve(len);
+        len += this->size();
+        if (len * 2 > this->data.capacity())
+            this->reserve(std::max(len, 2 * this->size()));
     };
-    void push_vert(const Pointf3 &point) {
-        this->verts.push_back(point.x);
-        this->verts.push_back(point.y);
-        this->verts.push_back(point.z);
+    void push(float nx, float ny, float nz, float x, float y, float z) {
+        this->data.push_back(nx);
+        this->data.push_back(ny);
+        this->data.push_back(nz);
+        this->data.push_back(x);
+        this->data.push_back(y);
+        this->data.push_back(z);
     };
-    void push_vert(float x, float y, float z) {
-        this->verts.push_back(x);
-        this->verts.push_back(y);
-        this->verts.push_back(z);
+    void push(const Vectorf3 &normal, float x, float y, float z) {
+        this->push(normal.x, normal.y, normal.z, x, y, z);
+    };
+    void load_mesh(const TriangleMesh &mesh);
+};
+
+/// Preview geometry of the toolpaths of a PrintObject: vertex arrays by
+/// color, with the offsets of each layer, in two levels of detail.
+/// Layers are converted in parallel, and reloading an object only converts
+/// the layers whose toolpaths changed since the previous load.
+class ToolpathsPreview {
+    public:
+    /// Levels of detail: the full geometry, and simplified paths without
+    /// the joints between their segments for far zoom.
+    static const int LODS = 2;
+    /// Tolerance of the simplified paths, in mm.
+    static const double lod_tolerance;
+
+    /// Toolpaths drawn with the same color.
+    struct Group {
+        unsigned int color;         ///< index in the color scheme
+        GLVertexArray qverts[LODS];
+        GLVertexArray tverts[LODS];
+        /// offsets of the coordinates of each layer of zs
+        std::vector<size_t> qoffsets[LODS];
+        std::vector<size_t> toffsets[LODS];
     };
-    void push_norm(const Pointf3 &point) {
-        this->norms.push_back(point.x);
-        this->norms.push_back(point.y);
-        this->norms.push_back(point.z);
+    std::vector<Group> groups;
+    /// print_z of the layers and support layers, in ascending order
+    std::vector<double> zs;
+    /// number of layers converted by the last load_object()
+    size_t layers_converted;
+
+    ToolpathsPreview() : layers_converted(0) {};
+    /// Colors are the perimeter, infill and support ones unless
+    /// color_by_extruder, and wrap around the colors_count of the scheme.
+    void load_object(PrintObject &object, bool color_by_extruder, unsigned int colors_count);
+
+    private:
+    /// Coordinates of a layer in the vertex arrays of a group.
+    struct Span {
+        size_t q, q_size, t, t_size;
+        Span() : q(0), q_size(0), t(0), t_size(0) {};
     };
-    void push_norm(float x, float y, float z) {
-        this->norms.push_back(x);
-        this->norms.push_back(y);
-        this->norms.push_back(z);
+    struct LayerGeometry {
+        const Layer* layer;
+        bool support;
+        uint64_t fingerprint;
+        /// false if converted into the buffers below
+        bool cached;
+        size_t previous;        ///< index in _layers if cached
+        std::map<unsigned int,GLVertexArray> qverts[LODS];
+        std::map<unsigned int,GLVertexArray> tverts[LODS];
+        /// where the layer is in the groups, by color
+        std::map<unsigned int,Span> spans[LODS];
+
+        LayerGeometry() : layer(NULL), support(false), fingerprint(0), cached(false), previous(0) {};
     };
-    void load_mesh(const TriangleMesh &mesh);
+    std::vector<LayerGeometry> _layers;
+
+    // state of the current load_object() call
+    PrintObject* _object;
+    bool _color_by_extruder;
+    unsigned int _colors_count;
+    std::vector<Group> _new_groups;
+    std::vector<LayerGeometry> _new_layers;
+
+    void _fingerprint(size_t idx);
+    void _convert(size_t idx);
+    void _copy(size_t idx);
+    void _add(LayerGeometry &geometry, const ExtrusionEntity &entity, unsigned int color,
+        double top_z, const Point &copy) const;
 };
 
 class _3DScene
 {
     public:
+    /// tverts may be NULL to leave out the joints between the lines.
     static void _extrusionentity_to_verts_do(const Lines &lines, const std::vector<double> &widths,
         const std::vector<double> &heights, bool closed, double top_z, const Point &copy,
         GLVertexArray* qverts, GLVertexArray* tverts);
@@ -9,7 +9,7 @@ BEGIN {
 }
 
 use Slic3r::XS;
-use Test::More tests => 20;
+use Test::More tests => 23;
 
 my $square = Slic3r::Polygon->new(  # ccw
     [100, 100],
@@ -89,4 +89,19 @@ my $expolygon = Slic3r::ExPolygon->new($square, $hole_in_square);
     ok $path->is_valid(), 'return path is valid';
 }
 
+{
+    my $from = Slic3r::Point->new(120, 120);
+    my $to = Slic3r::Point->new(180,180);
+    $_->scale(1/0.000001) for $from, $to;
+    
+    my $lazy_mp = Slic3r::MotionPlanner->new([ $expolygon ]);
+    my $prebuilt_mp = Slic3r::MotionPlanner->new([ $expolygon ]);
+    $prebuilt_mp->build;
+    ok $prebuilt_mp->build_time >= 0, 'build time is recorded';
+    
+    my $path = $prebuilt_mp->shortest_path($from, $to);
+    ok $path->is_valid(), 'prebuilt planner returns a valid path';
+    is_deeply $path->pp, $lazy_mp->shortest_path($from, $to)->pp, 'prebuilt planner returns the same path';
+}
+
 __END__
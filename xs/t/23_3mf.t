@@ -220,6 +220,31 @@ my $expected_relationships = "<?xml version=\"1.0\" encoding=\"UTF-8\"?> \n"
     unlink($output_path);
 }
 
+# Test 7: Write a compressed AMF file and read it back.
+{
+    my $input_path = dirname($current_path). "/models/amf/FaceColors.amf.xml";
+    my $output_path = dirname($current_path). "/models/amf/FaceColors_zipped.amf";
+
+    my $model = Slic3r::Model->new;
+    $model->read_amf($input_path);
+    my $result = $model->write_amf($output_path, 1);
+    is($result, 1, 'Test 7: Write compressed AMF file check.');
+
+    # The archive holds the XML document, named after the archive.
+    my $amf_output;
+    unzip $output_path => \$amf_output, Name => "FaceColors_zipped.amf"
+        or die "unzip failed: $UnzipError\n";
+    like($amf_output, qr/^<\?xml/, 'Test 7: compressed AMF contents check.');
+
+    my $model_2 = Slic3r::Model->new;
+    $result = $model_2->read_amf($output_path);
+    is($result, 1, 'Test 7: Read compressed AMF file check.');
+    is($model_2->objects_count(), $model->objects_count(), 'Test 7: objects match check.');
+    is($model_2->mesh->facets_count, $model->mesh->facets_count, 'Test 7: facets match check.');
+
+    unlink($output_path);
+}
+
 # Finish finish test cases.
 done_testing();
 
@@ -0,0 +1,62 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+use Slic3r::XS;
+use Test::More tests => 7;
+use File::Temp qw(tempdir);
+
+my $dir = tempdir(CLEANUP => 1);
+
+# Writes an OBJ file byte for byte, so that line ends are kept.
+sub write_obj {
+    my ($name, $content) = @_;
+    my $path = "$dir/$name";
+    open my $fh, '>:raw', $path or die "Can't write $path: $!";
+    print $fh $content;
+    close $fh;
+    return $path;
+}
+
+{
+    # CRLF line ends and no newline at the end of the file
+    my $path = write_obj('volumes.obj', join "\r\n",
+        '# quads, i/j/k and i//k tokens, relative indices',
+        'v 0 0 0', 'v 10 0 0', 'v 10 10 0', 'v 0 10 0', 'v 0 0 10',
+        'o first',
+        'f 1 2 3 4',
+        'f 1/1/1 2/2/2 5/5/5',
+        'g empty',
+        'g second',
+        'v 20 0 0', 'v 30 0 0', 'v 20 10 0', 'v 20 0 10',
+        'f -4//1 -3//1 -2//1',
+        'f 6 7 9',
+    );
+    my $model = Slic3r::Model->read_from_file($path);
+    my $object = $model->objects->[0];
+    is $object->volumes_count, 2, 'g and o lines start new volumes, empty groups are skipped';
+    is $object->get_volume(0)->mesh->facets_count, 3, 'quads are triangulated as fans';
+    is $object->get_volume(1)->mesh->facets_count, 2, 'last line without terminator is read';
+
+    my $bb = $object->get_volume(0)->mesh->bounding_box;
+    is_deeply [ $bb->x_min, $bb->x_max, $bb->z_min, $bb->z_max ], [ 0, 10, 0, 10 ],
+        'vertex indices are read out of i/j/k tokens';
+    $bb = $object->get_volume(1)->mesh->bounding_box;
+    is_deeply [ $bb->x_min, $bb->x_max, $bb->z_min, $bb->z_max ], [ 20, 30, 0, 10 ],
+        'relative indices refer to the last vertices read';
+}
+
+{
+    my $path = write_obj('no_newline.obj', "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3");
+    my $model = Slic3r::Model->read_from_file($path);
+    is $model->objects->[0]->get_volume(0)->mesh->facets_count, 1, 'face on the last line is read';
+}
+
+{
+    my $path = write_obj('out_of_range.obj', "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n");
+    eval { Slic3r::Model->read_from_file($path) };
+    like $@, qr/Error while reading OBJ file/, 'out of range index is an error';
+}
+
+__END__
@@ -0,0 +1,89 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+use Slic3r::XS;
+use Test::More;
+use IO::Select;
+use Time::HiRes qw(time);
+
+if (!Slic3r::GCode::Sender->can('new')) {
+    plan skip_all => 'Slic3r::XS was built without the G-code sender';
+}
+if (!eval { require IO::Pty; 1 }) {
+    plan skip_all => 'IO::Pty is required to emulate a printer';
+}
+plan tests => 8;
+
+use constant LINES => 50;
+
+# Plays the firmware on the master side of a pseudo-terminal the way Marlin
+# does: it acknowledges each line with an ok, and rejects a line with a bad
+# checksum or an unexpected line number with a resend request for the line
+# it expects, followed by an ok. The first time line $corrupt comes in, it is
+# taken as corrupted. Returns the commands accepted in the order they were
+# executed and the number of resend requests.
+sub serve {
+    my ($pty, $commands, $corrupt) = @_;
+
+    my $select = IO::Select->new($pty);
+    my ($buffer, $last_n, $resends) = ('', 0, 0);
+    my @accepted = ();
+    my $reply = sub { syswrite $pty, "$_\n" for @_ };
+    my $deadline = time + 10;
+    # wait a bit more after the last command, so that duplicates are seen
+    my $done;
+    while (time < ($done // $deadline)) {
+        next if !$select->can_read(0.05);
+        last if !sysread $pty, $buffer, 4096, length $buffer;
+        while ($buffer =~ s/^([^\n]*)\n//) {
+            my $line = $1;
+            $line =~ s/\r$//;
+            my ($n, $command, $cs) = $line =~ /^N(\d+) (.*)\*(\d+)$/ or next;
+            my $sum = 0;
+            $sum ^= ord for split //, "N$n $command";
+            if (defined $corrupt && $n == $corrupt) {
+                $sum = -1;
+                undef $corrupt;
+            }
+            if ($sum != $cs || $n != $last_n + 1) {
+                $reply->($sum != $cs
+                    ? "Error:checksum mismatch, Last Line: $last_n"
+                    : "Error:Line Number is not Last Line Number+1, Last Line: $last_n",
+                    "Resend: " . ($last_n + 1), "ok");
+                $resends++;
+                next;
+            }
+            $last_n = $n;
+            push @accepted, $command;
+            $reply->($command eq 'M105' ? 'ok T:20.0 /0.0 B:20.0 /0.0' : 'ok');
+        }
+        $done //= time + 0.5 if @accepted >= $commands;
+    }
+    return (\@accepted, $resends);
+}
+
+my @lines = map "G1 X$_", 1..LINES;
+# the sender checks the connection with a M105 first
+my @expected = ('M105', @lines);
+
+foreach my $rx_buffer_size (0, 64) {
+    my $pty = IO::Pty->new;
+    # the slave side is kept open so that reads on the master don't fail
+    # while the sender reopens the device
+    my $slave = $pty->slave;
+    $slave->set_raw;
+
+    my $sender = Slic3r::GCode::Sender->new;
+    ok $sender->connect($pty->ttyname, 115200, $rx_buffer_size), "connected with a receive buffer of $rx_buffer_size bytes";
+    $sender->send($_) for @lines;
+
+    my ($accepted, $resends) = serve($pty, scalar(@expected), 20);
+    is_deeply $accepted, \@expected, 'no line is lost or executed twice';
+    ok $resends >= 1, 'corrupted line is resent';
+    is $sender->queue_size, 0, 'queue is emptied';
+    $sender->disconnect;
+}
+
+__END__